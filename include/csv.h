@@ -14,9 +14,12 @@
 #include "csv/version.h"
 #include "csv/definitions.h"
 
+#include "csv/alloc.h"
+
 #include "csv/dialect.h"
 #include "csv/stream.h"
 
+#include "csv/parser.h"
 #include "csv/read.h"
 #include "csv/write.h"
 
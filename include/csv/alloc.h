@@ -0,0 +1,81 @@
+/**
+ * @file csv/alloc.h
+ * @author Robert Smith
+ * @brief CSV Library memory allocation hooks
+ *
+ * By default the library allocates with @c malloc, @c realloc and @c free.
+ * An application with its own allocator, for instance an arena with memory
+ * accounting, may replace them for the whole library with
+ * @c csv_set_allocator, or for the readers and writers made with a dialect
+ * with @c csvdialect_set_allocator.
+ *
+ * Memory allocated by third party libraries, such as zlib, zstd, @c glob or
+ * @c stdio, is not covered.
+ */
+
+#ifndef CSV_ALLOC_H_
+#define CSV_ALLOC_H_
+
+#include <stddef.h>
+
+#include "definitions.h"
+#include "version.h"
+
+/**
+ * @brief Allocate @p size bytes, as @c malloc
+ *
+ * @param[in]  context  pointer supplied with the allocator
+ * @param[in]  size     number of bytes, never 0
+ *
+ * @return              the allocation, or @c NULL on error
+ */
+typedef void *(*csv_malloc_fn)(void *context, size_t size);
+
+/**
+ * @brief Resize an allocation to @p size bytes, as @c realloc
+ *
+ * @param[in]  context  pointer supplied with the allocator
+ * @param[in]  pointer  allocation to resize, may be @c NULL
+ * @param[in]  size     number of bytes, never 0
+ *
+ * @return              the resized allocation, or @c NULL on error in which
+ *                      case @p pointer is unchanged
+ */
+typedef void *(*csv_realloc_fn)(void *context, void *pointer, size_t size);
+
+/**
+ * @brief Release an allocation, as @c free
+ *
+ * @param[in]  context  pointer supplied with the allocator
+ * @param[in]  pointer  allocation to release, may be @c NULL
+ */
+typedef void (*csv_free_fn)(void *context, void *pointer);
+
+/**
+ * @brief Set the allocator used throughout the library
+ *
+ * Every allocation the library makes outside of a reader or writer with its
+ * own allocator, including the records returned by @c csvreader_next_record,
+ * uses these functions. As the library cannot release memory with a
+ * different allocator than it was allocated with, this must be called while
+ * the library holds no memory, before any dialect, reader or writer is
+ * created or once all are closed. The functions may be called from the
+ * threads of multi-threaded readers, they must be thread safe for those.
+ *
+ * @param[in]  malloc_fn   allocates memory
+ * @param[in]  realloc_fn  resizes memory
+ * @param[in]  free_fn     releases memory
+ * @param[in]  context     passed to each function
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful, fails unless all functions are supplied
+ *                         or all are @c NULL, which restores the defaults
+ *
+ * @see csvdialect_set_allocator
+ */
+csvreturn csv_set_allocator(csv_malloc_fn  malloc_fn,
+                            csv_realloc_fn realloc_fn,
+                            csv_free_fn    free_fn,
+                            void *         context);
+
+#endif /* CSV_ALLOC_H_ */
@@ -56,6 +56,7 @@ typedef enum CSV_STREAM_SIGNAL {
   CSV_EOR,          /**< End of Record */
   CSV_END_OF_FIELD, /**< End of field */
   CSV_ERROR,        /**< Some IO Error encountered */
+  CSV_AGAIN,        /**< No input available yet, the stream has not ended */
 } CSV_STREAM_SIGNAL;
 
 /**
@@ -78,6 +79,8 @@ static inline const char* stream_signal(CSV_STREAM_SIGNAL csv_stream_signal) {
   case CSV_END_OF_FIELD: return "CSV_END_OF_FIELD";
 
   case CSV_ERROR: return "CSV_ERROR";
+
+  case CSV_AGAIN: return "CSV_AGAIN";
   }
 }
 
@@ -160,6 +163,9 @@ typedef struct csv_return {
                                 null when one is required */
   uint64_t quoteescape_error : 1;
   uint64_t delimiter_error   : 1;
+  uint64_t io_again          : 1; /**< indicates the stream has no input
+                                     available yet but has not ended, the
+                                     operation can be retried later */
 } csvreturn;
 
 /**
@@ -181,7 +187,7 @@ typedef struct csv_return {
  * @see csvreturn
  */
 #define csvreturn_init(succeeded) \
-  ((csvreturn) {((int)succeeded) == 0 ? 0 : 1, 0, 0, 0, 0, 0, 0, 0 })
+  ((csvreturn) {((int)succeeded) == 0 ? 0 : 1, 0, 0, 0, 0, 0, 0, 0, 0 })
 
 /**
  * Validate call to CSV API was performed successfully
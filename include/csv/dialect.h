@@ -11,6 +11,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "alloc.h"
 #include "definitions.h"
 #include "version.h"
 
@@ -292,4 +293,88 @@ csvreturn csvdialect_set_quotestyle(csvdialect dialect, QUOTE_STYLE quotestyle);
 csvreturn csvdialect_set_skipinitialspace(csvdialect dialect,
                                           bool       skipinitialspace);
 
+/**
+ * @brief Set the allocator of the readers and writers made with a dialect
+ *
+ * Readers and writers created with @p dialect allocate their state, their
+ * buffers and the records returned by @c csvreader_next_record with these
+ * functions, so those records must be released with @p free_fn. Records
+ * handed to a reader by a @c csvstream_saverecord callback are released with
+ * @p free_fn too. The worker state of multi-threaded readers, and the buffers
+ * of caller owned batches, use the library allocator. Copies of @p dialect
+ * share its allocator. The functions are captured when a reader or writer is
+ * created, changing them later does not affect it.
+ *
+ * @p dialect itself stays with the allocator it was created with.
+ *
+ * @param[in]  dialect     CSV Dialect type
+ * @param[in]  malloc_fn   allocates memory
+ * @param[in]  realloc_fn  resizes memory
+ * @param[in]  free_fn     releases memory
+ * @param[in]  context     passed to each function
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful, fails unless all functions are supplied
+ *                         or all are @c NULL, which restores the allocator
+ *                         set by @c csv_set_allocator
+ *
+ * @see csv_set_allocator
+ */
+csvreturn csvdialect_set_allocator(csvdialect     dialect,
+                                   csv_malloc_fn  malloc_fn,
+                                   csv_realloc_fn realloc_fn,
+                                   csv_free_fn    free_fn,
+                                   void *         context);
+
+/**
+ * @brief Infer the CSV Dialect of a sample of a CSV file
+ *
+ * The sample, typically the first few tens of kilobytes of a file, is
+ * tokenized once for each plausible quote character (@c '"' or @c '\'') and
+ * escape configuration (doubled quotes or @c '\\'). The delimiter is the
+ * one of @c ',', @c '\t', @c ';', @c '|' and @c ':' which occurs the same
+ * number of times in the most records. The line terminator is the most
+ * frequent of @c "\n", @c "\r\n" and @c "\r", and @c skipinitialspace is
+ * set if every delimiter is followed by a space. A final line without a line
+ * terminator is assumed to be cut off and is ignored.
+ *
+ * The result is applied with the @c csvdialect_set_* functions. Settings which
+ * cannot be inferred, such as the quoting style, are left unchanged.
+ *
+ * @param[in]      buf  sample of the CSV input
+ * @param[in]      len  number of characters in @p buf
+ * @param[in,out]  out  CSV Dialect to update, a new one is created by
+ *                      @c csvdialect_init if it is @c NULL
+ *
+ * @return              CSV Return type to determine if the operation was
+ *                      successful, @c delimiter_error is set if no candidate
+ *                      delimiter occurs in the sample
+ *
+ * @see csvdialect_sniff_header
+ */
+csvreturn csvdialect_sniff(const char *buf, size_t len, csvdialect *out);
+
+/**
+ * @brief Guess whether the first record of a sample is a header
+ *
+ * The first record is compared with up to twenty of the records which follow
+ * it. A column whose values are all numeric suggests a header if its first
+ * value is not, a column whose values all have the same length suggests a
+ * header if its first value has a different length. The header is assumed
+ * present if more columns suggest it than not.
+ *
+ * @param[in]   dialect  CSV Dialect of the sample, see @c csvdialect_sniff
+ * @param[in]   buf      sample of the CSV input
+ * @param[in]   len      number of characters in @p buf
+ * @param[out]  header   whether the first record appears to be a header
+ *
+ * @return               CSV Return type to determine if the operation was
+ *                       successful, fails if the sample has fewer than two
+ *                       records
+ */
+csvreturn csvdialect_sniff_header(csvdialect  dialect,
+                                  const char *buf,
+                                  size_t      len,
+                                  bool *      header);
+
 #endif /* CSV_DIALECT_H_ */
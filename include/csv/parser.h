@@ -0,0 +1,109 @@
+/**
+ * @file csv/parser.h
+ * @author Robert Smith
+ * @brief CSV Push Parser API
+ *
+ * The push parser is fed input as it arrives, for instance from a non-blocking
+ * socket, rather than pulling it from a stream. Complete records are passed to
+ * callbacks while feeding, a record split across any number of chunks is kept
+ * by the parser until it is complete.
+ */
+
+#ifndef CSV_PARSER_H_
+#define CSV_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "definitions.h"
+#include "dialect.h"
+#include "stream.h"
+#include "version.h"
+
+/**
+ * @brief CSV Push Parser datastructure
+ */
+typedef struct csv_parser *csvparser;
+
+/**
+ * @brief Called with each field of a completed record, in order
+ *
+ * @param[in]  context  pointer supplied to @c csvparser_init
+ * @param[in]  field    view of the field, valid only for the call
+ * @param[in]  column   zero based position of the field in its record
+ */
+typedef void (*csvparser_field_callback)(void *          context,
+                                         const csvfield *field,
+                                         size_t          column);
+
+/**
+ * @brief Called with each completed record, after its fields
+ *
+ * @param[in]  context  pointer supplied to @c csvparser_init
+ * @param[in]  fields   views of the record's fields, valid only for the call
+ * @param[in]  length   number of fields in @p fields
+ */
+typedef void (*csvparser_record_callback)(void *          context,
+                                          const csvfield *fields,
+                                          size_t          length);
+
+/**
+ * @brief CSV Push Parser initializer
+ *
+ * Records are parsed with the same rules as @c csvreader_next_record, blank
+ * lines are skipped.
+ *
+ * @param[in]  dialect    CSV dialect type, may be @c NULL
+ * @param[in]  on_field   called with each field, may be @c NULL
+ * @param[in]  on_record  called with each record, may be @c NULL
+ * @param[in]  context    passed to @p on_field and @p on_record
+ *
+ * @return                initialized CSV Push Parser, or NULL on error
+ *
+ * @see csvparser_feed
+ * @see csvparser_close
+ */
+csvparser csvparser_init(csvdialect                dialect,
+                         csvparser_field_callback  on_field,
+                         csvparser_record_callback on_record,
+                         void *                    context);
+
+/**
+ * @brief Parse a chunk of input
+ *
+ * The callbacks are called for every record completed by @p bytes before
+ * this returns. Chunks may end anywhere, within a field, a quoted field or a
+ * line terminator, the parser state and the partial record carry over to the
+ * next chunk. @p bytes is not referenced once this returns.
+ *
+ * @param[in,out]  parser  CSV Push Parser
+ * @param[in]      bytes   characters of input
+ * @param[in]      len     number of characters in @p bytes
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful, fails once @c csvparser_finish has been
+ *                         called
+ */
+csvreturn csvparser_feed(csvparser parser, const char *bytes, size_t len);
+
+/**
+ * @brief End the input
+ *
+ * A final record without a line terminator is completed and passed to the
+ * callbacks. Further input is refused.
+ *
+ * @param[in,out]  parser  CSV Push Parser
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful
+ */
+csvreturn csvparser_finish(csvparser parser);
+
+/**
+ * @brief Release the parser, any partial record is discarded
+ *
+ * @param[in,out]  parser  CSV Push Parser, set to @c NULL
+ */
+void csvparser_close(csvparser *parser);
+
+#endif /* CSV_PARSER_H_ */
@@ -9,6 +9,7 @@
 #define CSV_READ_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "definitions.h"
@@ -23,6 +24,114 @@
  */
 typedef struct csv_reader *csvreader;
 
+/**
+ * @brief Record filter, called with each record before it is returned
+ *
+ * @param[in]  context  pointer supplied to @c csvreader_set_filter
+ * @param[in]  fields   views of the record's fields, valid only for the call
+ * @param[in]  length   number of fields in @p fields
+ *
+ * @return              @c true to keep the record, @c false to drop it
+ *
+ * @see csvreader_set_filter
+ */
+typedef bool (*csvreader_filter)(void *          context,
+                                 const csvfield *fields,
+                                 size_t          length);
+
+/**
+ * @brief Batch of CSV Records
+ *
+ * Holds up to the requested number of records in three buffers owned by the
+ * batch: the characters of every field, the offset of every field and the
+ * first field of every record. A batch is reused by passing it to
+ * @c csvreader_next_batch again, which keeps its buffers, and is released as
+ * a unit by @c csvbatch_close.
+ *
+ * The fields of record @c i are @c fields[records[i]] up to, but excluding,
+ * @c fields[records[i + 1]]. Field @c j starts at @c heap + @c fields[j], and
+ * is terminated by a @c '\0' at @c heap + @c fields[j + 1] - 1. Use
+ * @c csvbatch_field rather than indexing directly where convenient.
+ *
+ * @see csvbatch_init
+ * @see csvbatch_field
+ * @see csvbatch_close
+ * @see csvreader_next_batch
+ */
+typedef struct csv_batch {
+  size_t  size;    /**< Number of records in the batch */
+  size_t *records; /**< @c size + 1 entries, index in @c fields of the first
+                      field of each record */
+  size_t *fields;  /**< @c records[size] + 1 entries, offset in @c heap of the
+                      first character of each field */
+  char *  heap;    /**< Characters of every field, each field terminated by
+                      @c '\0' */
+  size_t capacity_records; /**< Allocated entries of @c records */
+  size_t capacity_fields;  /**< Allocated entries of @c fields */
+  size_t capacity_heap;    /**< Allocated characters of @c heap */
+} csvbatch;
+
+/**
+ * @brief Single column of a CSV Column batch
+ *
+ * Laid out as an Arrow variable length binary array: the characters of record
+ * @c i are @c values + @c offsets[i] up to, but excluding, @c values +
+ * @c offsets[i + 1]. The characters are not null terminated.
+ *
+ * Bit @c i of @c validity, least significant bit first, is set if record
+ * @c i has this column. Records with fewer fields than the widest record leave
+ * the bit unset, and have an empty range of @c values.
+ *
+ * @see csvcolumns
+ */
+typedef struct csv_column {
+  int64_t *offsets;  /**< @c size + 1 entries, offset in @c values of the
+                        first character of each record */
+  char *   values;   /**< Characters of the column, for every record */
+  uint8_t *validity; /**< Validity bitmap, one bit per record */
+  size_t   capacity_offsets;  /**< Allocated entries of @c offsets */
+  size_t   capacity_values;   /**< Allocated characters of @c values */
+  size_t   capacity_validity; /**< Allocated bytes of @c validity */
+} csvcolumn;
+
+/**
+ * @brief Batch of CSV Records stored by column
+ *
+ * Holds up to the requested number of records transposed into one
+ * @c csvcolumn per field position, so column oriented consumers never see
+ * row-major records. A batch is reused by passing it to
+ * @c csvreader_next_columns again, which keeps its buffers, and is released
+ * as a unit by @c csvcolumns_close.
+ *
+ * @see csvcolumns_init
+ * @see csvcolumns_field
+ * @see csvcolumns_close
+ * @see csvreader_next_columns
+ */
+typedef struct csv_columns {
+  size_t     size;    /**< Number of records in the batch */
+  size_t     length;  /**< Number of columns, the widest record's length */
+  csvcolumn *columns; /**< @c length columns */
+  size_t     capacity_columns; /**< Allocated entries of @c columns */
+} csvcolumns;
+
+/**
+ * @brief Position of a CSV Reader between records
+ *
+ * Taken by @c csvreader_checkpoint and applied by @c csvreader_restore or
+ * @c csvreader_resume. Only fixed width integers are held, so a checkpoint
+ * can be written to storage as is, in native byte order, and read back by a
+ * later process to carry on reading where an earlier one stopped.
+ *
+ * @see csvreader_checkpoint
+ * @see csvreader_resume
+ */
+typedef struct csv_checkpoint {
+  uint64_t offset; /**< Offset of the first character not yet returned as
+                      part of a record */
+  uint64_t state;  /**< Parser state before that character */
+} csvcheckpoint;
+
 /**
  * @brief CSV Reader initializer from filepath
  *
@@ -68,6 +177,251 @@ csvreader csvreader_init(csvdialect dialect, const char *filepath);
  */
 csvreader csvreader_file_init(csvdialect dialect, FILE *fileobj);
 
+/**
+ * @brief Read the file ahead of the parser on a background thread
+ *
+ * For readers made by @c csvreader_init and @c csvreader_file_init. A thread
+ * fills a ring of @p blocks buffers from the file while the parser works
+ * through the buffers already filled, so slow storage stalls the parser only
+ * when the ring runs empty. Two blocks give double buffering. The thread runs
+ * until the reader is closed, seeking restarts it at the new position. If it
+ * cannot be restarted the reader continues without read-ahead.
+ *
+ * Must be called before the first record is read or straight after a seek.
+ * The reader owns the file from then on, a @c FILE* passed to
+ * @c csvreader_file_init must not be read or repositioned by the caller.
+ * Without thread support each block is still read as the parser requests it.
+ *
+ * @param[in,out]  reader  CSV Reader over a file
+ * @param[in]      blocks  number of buffers, at least two
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful
+ *
+ * @see csvreader_init
+ * @see csvreader_file_init
+ */
+csvreturn csvreader_set_readahead(csvreader reader, size_t blocks);
+
+/**
+ * @brief Point a CSV Reader at a new @c FILE*, reusing it
+ *
+ * Only the parser state and the input are replaced. The compiled dialect,
+ * the field and record buffers grown so far, the read-ahead, the field
+ * projection and the filter are kept, so reading many small inputs avoids
+ * the allocations and dialect copy of a new reader for each. Any partially
+ * read record and any loaded index are discarded.
+ *
+ * A file opened by @c csvreader_init or @c csvreader_reset_path is closed.
+ * @p fileobj is not closed by @c csvreader_close, as for
+ * @c csvreader_file_init. Only readers made by @c csvreader_init and
+ * @c csvreader_file_init can be reset.
+ *
+ * @param[in,out]  reader   CSV Reader over a file
+ * @param[in]      fileobj  Input CSV stream to read next
+ *
+ * @return                  CSV Return type to determine if the operation was
+ *                          successful
+ *
+ * @see csvreader_reset_path
+ */
+csvreturn csvreader_reset(csvreader reader, FILE *fileobj);
+
+/**
+ * @brief Point a CSV Reader at a new file, reusing it
+ *
+ * Opens @p filepath and resets the reader to it as @c csvreader_reset does.
+ * The file is closed by the next reset or by @c csvreader_close. If the file
+ * cannot be opened the reader is left as it was.
+ *
+ * @param[in,out]  reader    CSV Reader over a file
+ * @param[in]      filepath  Filepath to input CSV
+ *
+ * @return                   CSV Return type to determine if the operation was
+ *                           successful, @c io_error is set if @p filepath
+ *                           could not be opened
+ *
+ * @see csvreader_reset
+ */
+csvreturn csvreader_reset_path(csvreader reader, const char *filepath);
+
+/**
+ * @brief CSV Reader initializer from a file descriptor, such as a pipe
+ *
+ * The descriptor is read with large @c read calls, up to 1 MiB each, on a
+ * background thread when thread support is available, so data arriving
+ * through a pipe is parsed while more is read. Each block holds whatever one
+ * call returned, records written slowly into a pipe are not held back. The
+ * capacity of a pipe is raised where the platform allows it.
+ *
+ * The descriptor is not closed by @c csvreader_close, and must not be read by
+ * the caller while the reader is open. The reader cannot seek.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  fd       Open file descriptor to read
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_stdin_init
+ * @see csvreader_close
+ */
+csvreader csvreader_fd_init(csvdialect dialect, int fd);
+
+/**
+ * @brief CSV Reader initializer from standard input
+ *
+ * Equivalent to @c csvreader_fd_init on the standard input descriptor. Input
+ * already buffered by the @c stdin stream is not seen by the reader.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_fd_init
+ */
+csvreader csvreader_stdin_init(csvdialect dialect);
+
+/**
+ * @brief CSV Reader initializer which follows a growing file
+ *
+ * Reads @p filepath like @c tail @c -F: at the end of the file the reader
+ * waits for more to be written instead of ending the input. Records are
+ * returned as soon as they are complete, a partial trailing record is kept
+ * until the rest of it is written. On Linux the wait sleeps on inotify,
+ * elsewhere the file is polled.
+ *
+ * If nothing is written within @p timeout milliseconds
+ * @c csvreader_next_record fails with @c io_again set. The reader stays
+ * usable, the next call waits again and carries on with any partial record.
+ * The input never ends, @c io_eof is not set.
+ *
+ * A file which is replaced, as by log rotation, is reopened and read from
+ * its start, as is a file which is truncated. The reader cannot seek. Not
+ * available on Windows.
+ *
+ * @param[in]  dialect   CSV dialect type, may be @c NULL
+ * @param[in]  filepath  Filepath to input CSV
+ * @param[in]  timeout   milliseconds to wait for input, negative to wait
+ *                       without limit, zero not to wait at all
+ *
+ * @return               Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_close
+ */
+csvreader csvreader_follow_init(csvdialect  dialect,
+                                const char *filepath,
+                                int         timeout);
+
+/**
+ * @brief CSV Reader initializer over a memory mapped file
+ *
+ * Create a new CSV Reader which maps @p filepath into memory and parses
+ * directly out of the mapping. Fields which need no unescaping, which includes
+ * every unquoted field, are returned by @c csvreader_next_record_view as
+ * slices of the mapping without being copied. Fields containing escaped or
+ * doubled quote characters are unescaped into a buffer owned by the reader.
+ *
+ * The file must not be truncated while the reader is open.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  filepath Filepath to input CSV
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_init
+ * @see csvreader_next_record_view
+ * @see csvreader_close
+ */
+csvreader csvreader_mmap_init(csvdialect dialect, const char *filepath);
+
+/**
+ * @brief Multi-threaded CSV Reader initializer over a memory mapped file
+ *
+ * Create a new CSV Reader which maps @p filepath into memory and parses it on
+ * @p nthreads worker threads. The file is split into chunks at line
+ * terminators which quote parity suggests are outside of quoted fields, each
+ * chunk is parsed independently, and the records are returned in file order
+ * by @c csvreader_next_record and @c csvreader_next_record_view.
+ *
+ * A chunk which does not end on a record boundary, for instance because an
+ * escape character or a stray quote character misled the split, stops the
+ * workers and the rest of the file is parsed sequentially, so the records are
+ * always the same as those of @c csvreader_mmap_init.
+ *
+ * Without thread support, with fewer than two threads, or for small files
+ * this behaves as @c csvreader_mmap_init.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  filepath Filepath to input CSV
+ * @param[in]  nthreads Number of worker threads
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_mmap_init
+ * @see csvreader_next_record_view
+ * @see csvreader_close
+ */
+csvreader csvreader_parallel_init(csvdialect  dialect,
+                                  const char *filepath,
+                                  size_t      nthreads);
+
+/**
+ * @brief CSV Reader initializer over a list of files read as one input
+ *
+ * Create a new CSV Reader which returns the records of every file in
+ * @p paths, in list order, as though the files had been concatenated. Up to
+ * @p nthreads files are memory mapped and parsed at once on worker threads,
+ * each file by a single worker, while the records already parsed are
+ * returned. Workers run a few files ahead of the records being returned and
+ * no further, so memory use does not grow with the number of files.
+ *
+ * If @p skip_headers is set, the first record of each file after the first is
+ * dropped when it equals the first record of the input, which is returned
+ * once as the header. A file without a header keeps its first record.
+ *
+ * A file which cannot be read fails @c csvreader_next_record with
+ * @c io_error set once the records of the files before it have been
+ * returned. Without thread support, or with fewer than two threads, the files
+ * are read one after another. The reader cannot seek.
+ *
+ * @param[in]  dialect       CSV dialect type, may be @c NULL
+ * @param[in]  paths         Filepaths of the input CSV files, copied
+ * @param[in]  npaths        Number of entries in @p paths
+ * @param[in]  nthreads      Number of worker threads
+ * @param[in]  skip_headers  drop the repeated header of each later file
+ *
+ * @return                   Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_multi_glob_init
+ * @see csvreader_close
+ */
+csvreader csvreader_multi_init(csvdialect   dialect,
+                               const char **paths,
+                               size_t       npaths,
+                               size_t       nthreads,
+                               bool         skip_headers);
+
+/**
+ * @brief CSV Reader initializer over the files matching a pattern
+ *
+ * Expands @p pattern with @c glob and reads the matching files, in sorted
+ * order, as @c csvreader_multi_init does. Not available on Windows.
+ *
+ * @param[in]  dialect       CSV dialect type, may be @c NULL
+ * @param[in]  pattern       Shell pattern of the input CSV files
+ * @param[in]  nthreads      Number of worker threads
+ * @param[in]  skip_headers  drop the repeated header of each later file
+ *
+ * @return                   Fully initialized CSV Reader, or NULL on error or
+ *                           if no file matches @p pattern
+ *
+ * @see csvreader_multi_init
+ */
+csvreader csvreader_multi_glob_init(csvdialect  dialect,
+                                    const char *pattern,
+                                    size_t      nthreads,
+                                    bool        skip_headers);
+
 /**
  * @brief Advanced Initializer for CSV Reader
  *
@@ -101,6 +455,39 @@ csvreader csvreader_advanced_init(csvdialect            dialect,
                                   csvstream_saverecord  saverecord,
                                   csvstream_type        streamdata);
 
+/**
+ * @brief Advanced Initializer for CSV Reader over block-oriented streams
+ *
+ * Identical to @c csvreader_advanced_init, save that the input stream is
+ * pulled a block at a time through @p getnextblock rather than one character
+ * per callback. The parser walks each block directly, so sources which already
+ * hold their data in memory (or which can fill large buffers, like @c fread)
+ * avoid a function call per input character.
+ *
+ * @param[in]  dialect        preconfigured CSV Dialect type
+ * @param[in]  getnextblock   Function pointer which returns the next block of
+ *                            characters in the stream buffer.
+ * @param[in]  appendfield    Function pointer which appends character to
+ *                            current field buffer.
+ * @param[in]  savefield      Function pointer which pushes the current field to
+ *                            the end of the record buffer and resets the field
+ *                            buffer to the beginning.
+ * @param[in]  saverecord     Function pointer which completes a record and
+ *                            returns it by reference.
+ * @param[in]  streamdata     Datastructure which is passed to the callbacks
+ *
+ * @return                    initialized CSV Reader
+ *
+ * @see csvreader_advanced_init
+ * @see csvstream_getnextblock
+ */
+csvreader csvreader_advanced_block_init(csvdialect             dialect,
+                                        csvstream_getnextblock getnextblock,
+                                        csvstream_appendfield  appendfield,
+                                        csvstream_savefield    savefield,
+                                        csvstream_saverecord   saverecord,
+                                        csvstream_type         streamdata);
+
 /**
  * @brief Set CSV stream closer
  *
@@ -118,6 +505,118 @@ csvreader csvreader_advanced_init(csvdialect            dialect,
  */
 csvreader csvreader_set_closer(csvreader reader, csvstream_close closer);
 
+/**
+ * @brief Set CSV stream slice appender
+ *
+ * Optional for block-oriented readers. When set, runs of ordinary field
+ * characters are passed to @p appendslice as a single reference into the
+ * current block instead of one @c csvstream_appendfield call per character.
+ *
+ * @param[in]  reader        CSV reader type
+ * @param[in]  appendslice   Function pointer which appends a run of
+ *                           characters to the current field buffer.
+ *
+ * @return                   initialized CSV Reader
+ *
+ * @see csvreader_advanced_block_init
+ * @see csvstream_appendslice
+ */
+csvreader csvreader_set_appendslice(csvreader             reader,
+                                    csvstream_appendslice appendslice);
+
+/**
+ * @brief Set CSV stream record view callback
+ *
+ * Required for @c csvreader_next_record_view. Readers created with
+ * @c csvreader_init, @c csvreader_file_init or @c csvreader_mmap_init set this
+ * themselves.
+ *
+ * @param[in]  reader          CSV reader type
+ * @param[in]  saverecordview  Function pointer which completes a record and
+ *                             returns it by reference as field views.
+ *
+ * @return                     initialized CSV Reader
+ *
+ * @see csvreader_next_record_view
+ * @see csvstream_saverecordview
+ */
+csvreader csvreader_set_saverecordview(csvreader                reader,
+                                       csvstream_saverecordview saverecordview);
+
+/**
+ * @brief Drop records before they are returned
+ *
+ * @p filter is called with the field views of every record as soon as it is
+ * parsed, before @c csvreader_next_record or any other record function copies
+ * it. Records it rejects are skipped without allocating: the views are slices
+ * of the input, or of buffers the reader reuses for fields which had to be
+ * unescaped. Applies after @c csvreader_set_projection, so only kept columns
+ * are seen.
+ *
+ * Only available for readers which provide a record view callback. Passing
+ * @c NULL keeps every record again.
+ *
+ * @param[in]  reader   CSV reader type
+ * @param[in]  filter   Record predicate, or @c NULL
+ * @param[in]  context  Passed to every call of @p filter
+ *
+ * @return              CSV Return type to determine if the operation was
+ *                      successful
+ *
+ * @see csvreader_filter
+ * @see csvreader_set_saverecordview
+ */
+csvreturn csvreader_set_filter(csvreader        reader,
+                               csvreader_filter filter,
+                               void *           context);
+
+/**
+ * @brief Keep only the listed columns of every record
+ *
+ * Fields at any other position are still parsed, so quoting is honoured, but
+ * their characters are skipped over without calling @c appendfield,
+ * @c appendslice or @c savefield. Records returned afterwards hold the kept
+ * fields in file order, regardless of the order of @p indices. Records which
+ * are too short to have a kept column simply hold fewer fields.
+ *
+ * Passing @c NULL or a @p length of zero keeps every column again. Not
+ * available for @c csvreader_parallel_init readers, whose records are parsed
+ * before they are requested.
+ *
+ * @param[in]  reader   CSV reader type
+ * @param[in]  indices  Zero based positions of the columns to keep
+ * @param[in]  length   Number of entries in @p indices
+ *
+ * @return              CSV Return type to determine if the operation was
+ *                      successful
+ *
+ * @see csvreader_set_projection_names
+ */
+csvreturn csvreader_set_projection(csvreader     reader,
+                                   const size_t *indices,
+                                   size_t        length);
+
+/**
+ * @brief Keep only the named columns of every record
+ *
+ * Reads the next record as the header, finds each of @p names in it and
+ * calls @c csvreader_set_projection with their positions. The header record
+ * is consumed. If any name is missing from the header the return value
+ * indicates failure and every column is kept.
+ *
+ * @param[in]  reader   CSV reader type
+ * @param[in]  names    Null terminated column names to keep
+ * @param[in]  length   Number of entries in @p names
+ *
+ * @return              CSV Return type to determine if the operation was
+ *                      successful
+ *
+ * @see csvreader_set_projection
+ */
+csvreturn csvreader_set_projection_names(csvreader          reader,
+                                         const char *const *names,
+                                         size_t             length);
+
 /**
  * @brief CSV Reader destructor
  *
@@ -139,6 +638,17 @@ void csvreader_close(csvreader *reader);
 /**
  * @brief Get next CSV Record from CSV Reader's file
  *
+ * Blank lines between records are skipped. When the end of the stream is
+ * reached the final record, if any, is returned with @c io_eof set. Once no
+ * records remain the return value indicates failure with @c io_eof set, and
+ * @p record is set to @c NULL. If the stream has no input available yet the
+ * return value indicates failure with @c io_again set, the partially parsed
+ * record is kept and reading can be retried.
+ *
+ * The record belongs to the caller. Each field and the array are released
+ * with @c free, or with the allocator set by @c csv_set_allocator or
+ * @c csvdialect_set_allocator.
+ *
  * @param[in]   reader        CSV Reader type
  * @param[out]  record        Reference to a CSV Record type, if @c NULL a new
  *                            @c csvreader is allocated.
@@ -151,4 +661,467 @@ csvreturn csvreader_next_record(csvreader reader,
                                 char ***  record,
                                 size_t *  record_length);
 
+/**
+ * @brief Get next CSV Record from CSV Reader's file as field views
+ *
+ * Behaves as @c csvreader_next_record, but @p fields references storage owned
+ * by the reader and nothing needs to be freed by the caller. The views are
+ * valid until the next call on @p reader or until it is closed. Once the
+ * reader's buffers have grown to fit the widest record, no memory is allocated
+ * per record or per field.
+ *
+ * Only available for readers which provide a record view callback, otherwise
+ * the return value indicates failure.
+ *
+ * @param[in]   reader        CSV Reader type
+ * @param[out]  fields        Reference to the array of field views
+ * @param[out]  record_length Number of fields stored in @p fields
+ *
+ * @return                    CSV Return type to determine if the operation was
+ *                            successful
+ *
+ * @see csvreader_init
+ * @see csvreader_file_init
+ * @see csvreader_mmap_init
+ * @see csvreader_set_saverecordview
+ */
+csvreturn csvreader_next_record_view(csvreader        reader,
+                                     const csvfield **fields,
+                                     size_t *         record_length);
+
+/**
+ * @brief Get the next batch of CSV Records
+ *
+ * Parses up to @p max_records records into @p batch, replacing its previous
+ * contents but keeping its buffers, so a batch reused across calls stops
+ * allocating once it has grown to fit the largest batch.
+ *
+ * The return value indicates success if at least one record was stored, with
+ * @c io_eof set if the end of the stream was reached while filling the batch.
+ * Once no records remain the return value indicates failure with @c io_eof
+ * set, and @c batch->size is zero. If an IO error is encountered the records
+ * completed before it remain in @p batch and @c io_error is set.
+ *
+ * Only available for readers which provide a record view callback, otherwise
+ * the return value indicates failure.
+ *
+ * @param[in]      reader       CSV Reader type
+ * @param[in]      max_records  Maximum number of records to store in @p batch
+ * @param[in,out]  batch        Initialized batch to fill
+ *
+ * @return                      CSV Return type to determine if the operation
+ *                              was successful
+ *
+ * @see csvbatch_init
+ * @see csvreader_next_record_view
+ */
+csvreturn csvreader_next_batch(csvreader reader,
+                               size_t    max_records,
+                               csvbatch *batch);
+
+/**
+ * @brief Initialize an empty CSV Record batch
+ *
+ * @param[out]  batch  batch to initialize
+ *
+ * @see csvreader_next_batch
+ * @see csvbatch_close
+ */
+void csvbatch_init(csvbatch *batch);
+
+/**
+ * @brief Get a field of a record stored in a CSV Record batch
+ *
+ * @param[in]  batch   CSV Record batch
+ * @param[in]  record  index of the record, less than @c batch->size
+ * @param[in]  field   index of the field within @p record
+ *
+ * @return             view of the field, with a @c NULL @c data member if
+ *                     @p record or @p field is out of range
+ */
+csvfield csvbatch_field(const csvbatch *batch, size_t record, size_t field);
+
+/**
+ * @brief Get the number of fields in a record stored in a CSV Record batch
+ *
+ * @param[in]  batch   CSV Record batch
+ * @param[in]  record  index of the record, less than @c batch->size
+ *
+ * @return             number of fields, zero if @p record is out of range
+ */
+size_t csvbatch_record_length(const csvbatch *batch, size_t record);
+
+/**
+ * @brief Release the buffers of a CSV Record batch
+ *
+ * @p batch is left empty and may be reused. The buffers belong to the caller
+ * rather than to a reader, they are allocated with the library allocator set
+ * by @c csv_set_allocator whichever reader fills them.
+ *
+ * @param[in,out]  batch  batch to release
+ */
+void csvbatch_close(csvbatch *batch);
+
+/**
+ * @brief Get the next batch of CSV Records, stored by column
+ *
+ * Reads up to @p max_records records into the columns of @p columns,
+ * replacing their previous contents but keeping their buffers. Each field
+ * view is copied into the column it belongs to, without building row-major
+ * records. With @c csvreader_mmap_init that is the only copy of each field,
+ * other readers first assemble the field in their own buffer.
+ *
+ * Columns are added as wider records are found, earlier records of the batch
+ * are marked as not having them. The return value follows
+ * @c csvreader_next_batch.
+ *
+ * @param[in]      reader       CSV Reader type
+ * @param[in]      max_records  Maximum number of records to store
+ * @param[in,out]  columns      Initialized column batch to fill
+ *
+ * @return                      CSV Return type to determine if the operation
+ *                              was successful
+ *
+ * @see csvcolumns_init
+ * @see csvreader_next_batch
+ */
+csvreturn csvreader_next_columns(csvreader   reader,
+                                 size_t      max_records,
+                                 csvcolumns *columns);
+
+/**
+ * @brief Initialize an empty CSV Column batch
+ *
+ * @param[out]  columns  column batch to initialize
+ *
+ * @see csvreader_next_columns
+ * @see csvcolumns_close
+ */
+void csvcolumns_init(csvcolumns *columns);
+
+/**
+ * @brief Get a field of a record stored in a CSV Column batch
+ *
+ * @param[in]  columns  CSV Column batch
+ * @param[in]  column   index of the column, less than @c columns->length
+ * @param[in]  record   index of the record, less than @c columns->size
+ *
+ * @return              view of the field, with a @c NULL @c data member if
+ *                      @p column or @p record is out of range, or the record
+ *                      does not have the column
+ */
+csvfield csvcolumns_field(const csvcolumns *columns,
+                          size_t            column,
+                          size_t            record);
+
+/**
+ * @brief Release the buffers of a CSV Column batch
+ *
+ * @p columns is left empty and may be reused. As with @c csvbatch_close, the
+ * buffers are allocated with the library allocator set by
+ * @c csv_set_allocator whichever reader fills them.
+ *
+ * @param[in,out]  columns  column batch to release
+ */
+void csvcolumns_close(csvcolumns *columns);
+
+/**
+ * @brief CSV Reader initializer for a gzip compressed file
+ *
+ * The file is inflated on a separate thread, which stays a few blocks ahead
+ * of the parser, so inflating and parsing overlap. Concatenated gzip members
+ * and zlib streams are read as well. Only available if the library was built
+ * with zlib.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  filepath Filepath to the compressed input CSV
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error or if
+ *                      gzip support was not built
+ *
+ * @see csvreader_init
+ * @see csvreader_close
+ */
+csvreader csvreader_gzip_init(csvdialect dialect, const char *filepath);
+
+/**
+ * @brief CSV Reader initializer for a Zstandard compressed file
+ *
+ * As @c csvreader_gzip_init, for files made by @c zstd. Only available if the
+ * library was built with libzstd.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  filepath Filepath to the compressed input CSV
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error or if
+ *                      Zstandard support was not built
+ *
+ * @see csvreader_init
+ * @see csvreader_close
+ */
+csvreader csvreader_zstd_init(csvdialect dialect, const char *filepath);
+
+/**
+ * @brief CSV Reader initializer for a BGZF file, decompressed in parallel
+ *
+ * BGZF files, as written by @c bgzip, are gzip files made of independent
+ * members of at most 64 KiB each, whose compressed size is stored in the
+ * member header. The members are found without inflating them and are
+ * inflated by @p nthreads worker threads, the parser receives them in file
+ * order. A gzip file which is not BGZF is rejected, use
+ * @c csvreader_gzip_init for it.
+ *
+ * The table of members also lets the reader jump straight to the member
+ * holding an offset, so @c csvreader_seek_record and @c csvreader_seek_offset
+ * only inflate from there. Offsets are those of the uncompressed input, an
+ * index built from the uncompressed file can be loaded with
+ * @c csvreader_load_index. Only available if the library was built with zlib.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  filepath Filepath to the compressed input CSV
+ * @param[in]  nthreads Number of worker threads, one inflates on the calling
+ *                      thread without thread support
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error or if
+ *                      gzip support was not built
+ *
+ * @see csvreader_gzip_init
+ * @see csvreader_close
+ */
+csvreader csvreader_bgzf_init(csvdialect  dialect,
+                              const char *filepath,
+                              size_t      nthreads);
+
+/**
+ * @brief CSV Reader initializer for a seekable Zstandard file, decompressed
+ * in parallel
+ *
+ * As @c csvreader_bgzf_init, for files in the Zstandard seekable format whose
+ * independent frames are listed by the seek table at the end of the file.
+ * Only available if the library was built with libzstd.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  filepath Filepath to the compressed input CSV
+ * @param[in]  nthreads Number of worker threads
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error or if
+ *                      Zstandard support was not built
+ *
+ * @see csvreader_zstd_init
+ * @see csvreader_close
+ */
+csvreader csvreader_zstd_seekable_init(csvdialect  dialect,
+                                       const char *filepath,
+                                       size_t      nthreads);
+
+/**
+ * @brief CSV Reader initializer reading the file with io_uring
+ *
+ * Keeps several large, page aligned reads in flight through io_uring and
+ * hands the completed buffers to the parser in file order, for storage which
+ * one synchronous stream cannot keep busy. With @p direct the file is opened
+ * with @c O_DIRECT, bypassing the page cache, if its file system allows it.
+ *
+ * Where io_uring is not available, on other platforms or on kernels without
+ * it or where it is disabled, the reader made by @c csvreader_init is
+ * returned instead. Either reader can seek with @c csvreader_seek_record and
+ * @c csvreader_seek_offset.
+ *
+ * @param[in]  dialect  CSV dialect type.
+ * @param[in]  filepath Filepath to input CSV
+ * @param[in]  direct   Open the file with @c O_DIRECT
+ *
+ * @return              Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_init
+ * @see csvreader_close
+ */
+csvreader csvreader_uring_init(csvdialect  dialect,
+                               const char *filepath,
+                               bool        direct);
+
+/**
+ * @brief Count the records and fields of a CSV file
+ *
+ * Runs only the parser's quote aware structural scan over the memory mapped
+ * file, nothing is copied and no records are built. The counts are those
+ * which @c csvreader_next_record would return for the same @p dialect:
+ * blank lines are not records, and a final record without a line terminator
+ * is.
+ *
+ * @param[in]   dialect   CSV dialect type, may be @c NULL
+ * @param[in]   filepath  Filepath to input CSV
+ * @param[out]  records   Number of records in the file
+ * @param[out]  fields    Total number of fields over every record
+ *
+ * @return                CSV Return type to determine if the operation was
+ *                        successful, @c io_error is set if the file could not
+ *                        be read or contains a NUL byte
+ *
+ * @see csvreader_mmap_init
+ */
+csvreturn csvreader_count_records(csvdialect  dialect,
+                                  const char *filepath,
+                                  uint64_t *  records,
+                                  uint64_t *  fields);
+
+/**
+ * @brief Build a record offset index of a CSV file
+ *
+ * The memory mapped file is scanned once, as by @c csvreader_count_records,
+ * and the offset of every @p interval th record is written to the sidecar
+ * file at @p indexpath. The sidecar is written in native byte order and is
+ * not portable between machines.
+ *
+ * @param[in]   dialect    CSV dialect type, may be @c NULL
+ * @param[in]   filepath   Filepath to input CSV
+ * @param[in]   indexpath  Filepath of the index to write
+ * @param[in]   interval   Records between index entries, must not be zero
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful, @c io_error is set if either file could
+ *                         not be read or written
+ *
+ * @see csvreader_load_index
+ */
+csvreturn csvreader_build_index(csvdialect  dialect,
+                                const char *filepath,
+                                const char *indexpath,
+                                uint64_t    interval);
+
+/**
+ * @brief Extend a record offset index after records were appended to a file
+ *
+ * Only the records from the last entry of the index onwards are scanned. The
+ * end of the input covered by the index is compared with a checksum kept in
+ * the index, a file which was truncated or rewritten is not updated and has
+ * to be indexed again with @c csvreader_build_index.
+ *
+ * @param[in]   dialect    CSV dialect type the index was built with
+ * @param[in]   filepath   Filepath to input CSV
+ * @param[in]   indexpath  Filepath of the index to extend
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful, @c io_error is set if either file could
+ *                         not be read or written
+ */
+csvreturn csvreader_update_index(csvdialect  dialect,
+                                 const char *filepath,
+                                 const char *indexpath);
+
+/**
+ * @brief Load a record offset index for use by @c csvreader_seek_record
+ *
+ * The index must have been built from the reader's input with the reader's
+ * dialect, this is not checked.
+ *
+ * @param[in,out]  reader     CSV Reader to seek with the index
+ * @param[in]      indexpath  Filepath of an index from
+ *                            @c csvreader_build_index
+ *
+ * @return                    CSV Return type to determine if the operation
+ *                            was successful, @c io_error is set if the index
+ *                            could not be read
+ */
+csvreturn csvreader_load_index(csvreader reader, const char *indexpath);
+
+/**
+ * @brief Position the reader so that the next record read is @p record
+ *
+ * Records are counted from zero, as returned by @c csvreader_next_record,
+ * before any filter. The reader is moved to the nearest indexed record at or
+ * before @p record and parses forward from there. Only readers made by
+ * @c csvreader_init, @c csvreader_file_init, @c csvreader_mmap_init,
+ * @c csvreader_bgzf_init, @c csvreader_zstd_seekable_init and
+ * @c csvreader_uring_init can seek. A field projection and a filter stay in
+ * place.
+ *
+ * @param[in,out]  reader  CSV Reader with an index loaded
+ * @param[in]      record  number of the record to read next
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful, @c io_eof is set if @p record is past
+ *                         the last indexed record
+ *
+ * @see csvreader_load_index
+ */
+csvreturn csvreader_seek_record(csvreader reader, uint64_t record);
+
+/**
+ * @brief Position the reader at @p offset characters into its input
+ *
+ * @p offset must be the first character of a record, such as an offset
+ * recorded when the record was read, and is counted in the uncompressed
+ * input for the compressed readers. The same readers as
+ * @c csvreader_seek_record can seek.
+ *
+ * @param[in,out]  reader  CSV Reader to position
+ * @param[in]      offset  offset of the record to read next
+ *
+ * @return                 CSV Return type to determine if the operation was
+ *                         successful, @c io_error is set if @p offset is past
+ *                         the end of the input
+ *
+ * @see csvreader_seek_record
+ */
+csvreturn csvreader_seek_offset(csvreader reader, uint64_t offset);
+
+/**
+ * @brief Record where the reader is in its input
+ *
+ * The checkpoint holds the position just after the last record returned,
+ * whole records only. A record which was partly read when the input paused,
+ * @c io_again, is read again in full after a restore. Records dropped by a
+ * filter count as returned. The same readers as @c csvreader_seek_record can
+ * take a checkpoint.
+ *
+ * @param[in]   reader      CSV Reader
+ * @param[out]  checkpoint  position of the next record
+ *
+ * @return                  CSV Return type to determine if the operation was
+ *                          successful
+ *
+ * @see csvreader_restore
+ * @see csvreader_resume
+ */
+csvreturn csvreader_checkpoint(csvreader reader, csvcheckpoint *checkpoint);
+
+/**
+ * @brief Position the reader at a checkpoint
+ *
+ * The checkpoint must have been taken over the same input with the same
+ * dialect, this is not checked. A field projection and a filter stay in
+ * place.
+ *
+ * @param[in,out]  reader      CSV Reader to position
+ * @param[in]      checkpoint  checkpoint from @c csvreader_checkpoint
+ *
+ * @return                     CSV Return type to determine if the operation
+ *                             was successful, @c io_error is set if the
+ *                             stream could not be positioned
+ *
+ * @see csvreader_checkpoint
+ */
+csvreturn csvreader_restore(csvreader reader, const csvcheckpoint *checkpoint);
+
+/**
+ * @brief CSV Reader initializer from filepath, starting at a checkpoint
+ *
+ * Opens @p filepath as @c csvreader_init does and restores @p checkpoint, so
+ * an ingestion job which was stopped carries on from its last checkpoint
+ * rather than from the start of the file.
+ *
+ * @param[in]  dialect     CSV dialect type, may be @c NULL
+ * @param[in]  filepath    Filepath to input CSV
+ * @param[in]  checkpoint  checkpoint from @c csvreader_checkpoint
+ *
+ * @return                 Fully initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_restore
+ * @see csvreader_close
+ */
+csvreader csvreader_resume(csvdialect           dialect,
+                           const char *         filepath,
+                           const csvcheckpoint *checkpoint);
+
 #endif /* CSV_READ_H_ */
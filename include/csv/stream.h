@@ -24,6 +24,20 @@
  */
 typedef void *csvstream_type;
 
+/**
+ * @brief CSV Field view
+ *
+ * Non-owning reference to the characters of a single field. @c data is not
+ * guaranteed to be null terminated, @c len is the number of characters in the
+ * field. The storage referenced belongs to whichever object produced the view.
+ *
+ * @see csvreader_next_record_view
+ */
+typedef struct csv_field {
+  const char *data; /**< first character of the field */
+  size_t      len;  /**< number of characters in the field */
+} csvfield;
+
 /* reader and writer, optional shutdown method called within the closer */
 typedef void (*csvstream_close)(csvstream_type streamdata);
 
@@ -31,10 +45,32 @@ typedef void (*csvstream_close)(csvstream_type streamdata);
 typedef CSV_STREAM_SIGNAL (*csvstream_getnextchar)(
     csvstream_type streamdata, csv_comparison_char_type *value);
 
+/*
+ * reader only, get the next block of characters from the stream. On
+ * @c CSV_GOOD, @p block references @p length characters in a buffer owned by
+ * @p streamdata, which must remain valid until the next call or until the
+ * stream is closed. @c CSV_EOF and @c CSV_ERROR end the stream. @c CSV_AGAIN
+ * pauses it: the parser keeps its state, including any partial record, the
+ * read fails with @c io_again set, and the next read asks for a block again.
+ */
+typedef CSV_STREAM_SIGNAL (*csvstream_getnextblock)(csvstream_type streamdata,
+                                                    const char **  block,
+                                                    size_t *       length);
+
 /* reader only, append character to existing field buffer */
 typedef void (*csvstream_appendfield)(csvstream_type           streamdata,
                                       csv_comparison_char_type value);
 
+/*
+ * reader only, optional, append a run of characters to the existing field
+ * buffer. @p data references the block returned by @c csvstream_getnextblock,
+ * so it is only valid until the next block is requested. Readers without this
+ * callback receive each character through @c csvstream_appendfield instead.
+ */
+typedef void (*csvstream_appendslice)(csvstream_type streamdata,
+                                      const char *   data,
+                                      size_t         length);
+
 /* push field back into record */
 typedef void (*csvstream_savefield)(csvstream_type streamdata);
 
@@ -43,6 +79,15 @@ typedef void (*csvstream_saverecord)(csvstream_type streamdata,
                                      char ***       fields,
                                      size_t *       length);
 
+/*
+ * reader only, optional, finalize record and return it by reference as field
+ * views. The views remain owned by @p streamdata, and must stay valid until
+ * the next record is requested.
+ */
+typedef void (*csvstream_saverecordview)(csvstream_type   streamdata,
+                                         const csvfield **fields,
+                                         size_t *         length);
+
 /*
  * Sets the provided record as active
  */
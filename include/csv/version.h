@@ -0,0 +1,23 @@
+/**
+ * @file csv/version.h
+ * @author Robert Smith
+ * @date 2018-06-18
+ * @brief CSV I/O library version definitons
+ */
+
+#ifndef CSV_VERSION_H_
+#define CSV_VERSION_H_
+
+/*
+ * Generated from CMake variables / call to configure_file. See project
+ * root CMakeLists.txt and src/CMakeLists.txt
+ */
+
+#define CSV_VERSION_MAJOR 0U
+#define CSV_VERSION_MINOR 1U
+#define CSV_VERSION_PATCH 0U
+#define CSV_VERSION_TWEAK 0U
+
+#define CSV_VERSION "0.1.0.0"
+
+#endif /* CSV_VERSION_H_ */
@@ -0,0 +1,59 @@
+/**
+ * @cond INTERNAL
+ * @file alloc_private.h
+ * @author Robert Smith
+ * @brief Private API for library memory allocation. No guarantee of
+ * stability.
+ *
+ * Every allocation in the library goes through these functions. An object
+ * with an allocator of its own keeps a copy of it and passes it to each call,
+ * everything else passes @c NULL for the allocator set by
+ * @c csv_set_allocator.
+ */
+#ifndef CSV_ALLOC_PRIVATE_H_
+#define CSV_ALLOC_PRIVATE_H_
+
+#include <stddef.h>
+
+#include "csv/alloc.h"
+
+/**
+ * @brief Allocator functions and the context passed to them
+ */
+typedef struct csv_allocator {
+  csv_malloc_fn  malloc_fn;
+  csv_realloc_fn realloc_fn;
+  csv_free_fn    free_fn;
+  void *         context;
+} csvallocator;
+
+/**
+ * @brief Allocator set by @c csv_set_allocator
+ */
+const csvallocator *csv_get_allocator(void);
+
+/**
+ * @brief @c malloc through @p allocator, or the library allocator if @c NULL
+ */
+void *csv_malloc(const csvallocator *allocator, size_t size);
+
+/**
+ * @brief @c calloc through @p allocator, or the library allocator if @c NULL
+ */
+void *csv_calloc(const csvallocator *allocator, size_t count, size_t size);
+
+/**
+ * @brief @c realloc through @p allocator, or the library allocator if @c NULL
+ */
+void *csv_realloc(const csvallocator *allocator, void *pointer, size_t size);
+
+/**
+ * @brief @c free through @p allocator, or the library allocator if @c NULL
+ */
+void csv_free(const csvallocator *allocator, void *pointer);
+
+/**
+ * @endcond
+ */
+
+#endif /* CSV_ALLOC_PRIVATE_H_ */
@@ -0,0 +1,123 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_alloc.c
+ * @author Robert W. Smith
+ * @brief Implementation of the library memory allocation hooks
+ *
+ * Private documentation, API subject to change. The functions guarantee the
+ * allocator is never asked for 0 bytes, so an arena need not handle it.
+ *
+ * @see csv/alloc.h
+ * @see alloc_private.h
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csv.h"
+#include "alloc_private.h"
+
+/*
+ * private forward declarations
+ */
+void *csv_stdlib_malloc(void *context, size_t size);
+void *csv_stdlib_realloc(void *context, void *pointer, size_t size);
+void  csv_stdlib_free(void *context, void *pointer);
+
+/*
+ * end of private forward declarations
+ */
+
+static csvallocator csv_allocator = {
+    &csv_stdlib_malloc, &csv_stdlib_realloc, &csv_stdlib_free, NULL};
+
+/*
+ * API implementation
+ */
+csvreturn csv_set_allocator(csv_malloc_fn  malloc_fn,
+                            csv_realloc_fn realloc_fn,
+                            csv_free_fn    free_fn,
+                            void *         context) {
+  ZF_LOGI("setting the library allocator");
+
+  if ((malloc_fn == NULL) && (realloc_fn == NULL) && (free_fn == NULL)) {
+    csv_allocator.malloc_fn  = &csv_stdlib_malloc;
+    csv_allocator.realloc_fn = &csv_stdlib_realloc;
+    csv_allocator.free_fn    = &csv_stdlib_free;
+    csv_allocator.context    = NULL;
+    return csvreturn_init(true);
+  }
+
+  if ((malloc_fn == NULL) || (realloc_fn == NULL) || (free_fn == NULL)) {
+    ZF_LOGE("allocator functions must all be supplied, or all be NULL");
+    return csvreturn_init(false);
+  }
+
+  csv_allocator.malloc_fn  = malloc_fn;
+  csv_allocator.realloc_fn = realloc_fn;
+  csv_allocator.free_fn    = free_fn;
+  csv_allocator.context    = context;
+  return csvreturn_init(true);
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+const csvallocator *csv_get_allocator(void) { return &csv_allocator; }
+
+void *csv_malloc(const csvallocator *allocator, size_t size) {
+  if (allocator == NULL) allocator = &csv_allocator;
+  return (*allocator->malloc_fn)(allocator->context, (size > 0) ? size : 1);
+}
+
+void *csv_calloc(const csvallocator *allocator, size_t count, size_t size) {
+  void *pointer = NULL;
+
+  if ((size > 0) && (count > SIZE_MAX / size)) {
+    ZF_LOGE("allocation of `%lu` elements overflows",
+            (long unsigned)count);
+    return NULL;
+  }
+
+  if ((pointer = csv_malloc(allocator, count * size)) != NULL) {
+    memset(pointer, 0, count * size);
+  }
+  return pointer;
+}
+
+void *csv_realloc(const csvallocator *allocator, void *pointer, size_t size) {
+  if (allocator == NULL) allocator = &csv_allocator;
+  return (*allocator->realloc_fn)(
+      allocator->context, pointer, (size > 0) ? size : 1);
+}
+
+void csv_free(const csvallocator *allocator, void *pointer) {
+  if (pointer == NULL) return;
+  if (allocator == NULL) allocator = &csv_allocator;
+  (*allocator->free_fn)(allocator->context, pointer);
+}
+
+void *csv_stdlib_malloc(void *context, size_t size) {
+  (void)context;
+  return malloc(size);
+}
+
+void *csv_stdlib_realloc(void *context, void *pointer, size_t size) {
+  (void)context;
+  return realloc(pointer, size);
+}
+
+void csv_stdlib_free(void *context, void *pointer) {
+  (void)context;
+  free(pointer);
+}
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,844 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_blocked.c
+ * @author Robert W. Smith
+ * @brief Implementation of the block compressed CSV Readers
+ *
+ * Private documentation, API subject to change. BGZF and seekable Zstandard
+ * files are made of independently compressed blocks whose extents can be found
+ * without decompressing them. The file is memory mapped and a table of its
+ * blocks is built, then worker threads decompress blocks into a ring of
+ * buffers ahead of the parser, which receives them in file order. The block
+ * handed to the parser is held until it asks for the next one, the workers
+ * never write to it.
+ *
+ * The table also maps an offset of the uncompressed input to the block holding
+ * it, so seeking only restarts the workers at that block. Without thread
+ * support each block is decompressed as the parser requests it.
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef CSV_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#ifdef CSV_HAVE_ZLIB
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+
+#ifdef CSV_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+/*
+ * blocks decompressed ahead of the parser per worker thread
+ */
+#define CSV_BLOCKED_AHEAD 4
+
+/*
+ * largest uncompressed BGZF member
+ */
+#define CSV_BGZF_BLOCK_SIZE ((size_t)1 << 16)
+
+/*
+ * magic numbers of the Zstandard seekable format's seek table
+ */
+#define CSV_ZSTD_SKIPPABLE_MAGIC 0x184D2A5EU
+#define CSV_ZSTD_SEEKABLE_MAGIC 0x8F92EAB1U
+#define CSV_ZSTD_SEEKABLE_FOOTER 9
+
+typedef struct csv_blocked_reader *csvblockedreader;
+
+/*
+ * an independently compressed block of the file
+ */
+typedef struct csv_block {
+  size_t   offset; /* first character of compressed data in the mapping */
+  size_t   size;   /* characters of compressed data */
+  size_t   length; /* characters once decompressed */
+  uint64_t start;  /* offset of the first decompressed character */
+  uint32_t crc;    /* CRC-32 of the decompressed characters, BGZF only */
+} csvblock;
+
+/*
+ * format specific callbacks, each worker owns a decompression state
+ */
+typedef struct csv_blocked_codec {
+  const char *name;
+  bool (*table)(csvblockedreader br);
+  void *(*open)(void);
+  bool (*decompress)(void *               state,
+                     const unsigned char *in,
+                     const csvblock *     block,
+                     char *               out);
+  void (*release)(void *state);
+} csvblockedcodec;
+
+typedef struct csv_blocked_worker {
+  csvblockedreader br;
+  void *           state;
+#ifdef CSV_HAVE_PTHREADS
+  pthread_t thread;
+  bool      started;
+#endif
+} csvblockedworker;
+
+struct csv_blocked_reader {
+  const csvblockedcodec *codec;
+  const char *           map;
+  size_t                 map_length;
+
+  csvblock *blocks;
+  size_t    count;
+  size_t    capacity;
+  uint64_t  length; /* characters of uncompressed input */
+
+  /* block `b` is decompressed into `slots[b % window]` */
+  char ** slots;
+  size_t *ready; /* `b + 1` once block `b` is in its slot */
+  size_t  window;
+
+  size_t claimed;  /* blocks taken by the workers */
+  size_t consumed; /* blocks released by the parser */
+  size_t skip;     /* characters of block `consumed` before a seek offset */
+  bool   held;     /* the parser holds block `consumed` */
+  bool   failed;   /* a block could not be decompressed */
+
+  csvblockedworker *workers;
+  size_t            nworkers;
+
+#ifdef CSV_HAVE_PTHREADS
+  size_t          busy; /* workers decompressing a block */
+  bool            stop;
+  pthread_mutex_t lock;
+  pthread_cond_t  done; /* signalled when a worker finishes a block */
+  pthread_cond_t  work; /* signalled when a slot is released, or on `stop` */
+#endif
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Map @p filepath, build its block table and start the workers
+ *
+ * @return reader over the decompressed blocks, or NULL on error
+ */
+csvreader csv_blocked_init(csvdialect             dialect,
+                           const char *           filepath,
+                           size_t                 nthreads,
+                           const csvblockedcodec *codec);
+
+/**
+ * @brief Allocate the ring and the worker states, then start the workers
+ *
+ * @return @c false if anything could not be allocated or started
+ */
+bool csv_blocked_start(csvblockedreader br, size_t nthreads);
+
+/**
+ * @brief Append a block to the table, offsets follow the previous block
+ *
+ * @return @c false if the table could not be grown
+ */
+bool csv_blocked_append(csvblockedreader br,
+                        size_t           offset,
+                        size_t           size,
+                        size_t           length,
+                        uint32_t         crc);
+
+/**
+ * @brief Decompress block @p b into its slot
+ */
+bool csv_blocked_decompress(csvblockedreader br, void *state, size_t b);
+
+/**
+ * @brief Hand the next block to the parser in file order
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csv_blocked_getnextblock(csvstream_type streamdata,
+                                           const char **  block,
+                                           size_t *       length);
+
+/**
+ * @brief Restart decompression at the block holding @p offset
+ *
+ * @see csvstream_seek
+ */
+bool csv_blocked_seek(csvstream_type streamdata, uint64_t offset);
+
+/**
+ * @brief Stop the workers, unmap the file and release the buffers
+ *
+ * @see csvstream_close
+ */
+void csv_blocked_close(csvstream_type streamdata);
+
+#ifdef CSV_HAVE_PTHREADS
+/**
+ * @brief Worker thread, decompresses blocks while their slots are free
+ */
+void *csv_blocked_work(void *arg);
+#endif
+
+/**
+ * @brief Little endian integers of the block headers
+ */
+uint32_t csv_blocked_le16(const unsigned char *p);
+uint32_t csv_blocked_le32(const unsigned char *p);
+
+#ifdef CSV_HAVE_ZLIB
+/**
+ * @brief Build the table from the BSIZE field of each BGZF member header
+ */
+bool csv_bgzf_table(csvblockedreader br);
+
+/**
+ * @brief Raw inflate state, reset for each member
+ */
+void *csv_bgzf_open(void);
+
+/**
+ * @brief Inflate a member and check its length and CRC-32
+ */
+bool csv_bgzf_decompress(void *               state,
+                         const unsigned char *in,
+                         const csvblock *     block,
+                         char *               out);
+
+void csv_bgzf_release(void *state);
+
+static const csvblockedcodec csv_bgzf_codec = {"BGZF",
+                                               &csv_bgzf_table,
+                                               &csv_bgzf_open,
+                                               &csv_bgzf_decompress,
+                                               &csv_bgzf_release};
+#endif /* CSV_HAVE_ZLIB */
+
+#ifdef CSV_HAVE_ZSTD
+/**
+ * @brief Build the table from the seek table at the end of the file
+ */
+bool csv_zstd_seekable_table(csvblockedreader br);
+
+void *csv_zstd_seekable_open(void);
+
+/**
+ * @brief Decompress a frame and check its length
+ */
+bool csv_zstd_seekable_decompress(void *               state,
+                                  const unsigned char *in,
+                                  const csvblock *     block,
+                                  char *               out);
+
+void csv_zstd_seekable_release(void *state);
+
+static const csvblockedcodec csv_zstd_seekable_codec = {
+    "seekable Zstandard",
+    &csv_zstd_seekable_table,
+    &csv_zstd_seekable_open,
+    &csv_zstd_seekable_decompress,
+    &csv_zstd_seekable_release};
+#endif /* CSV_HAVE_ZSTD */
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreader csvreader_bgzf_init(csvdialect  dialect,
+                              const char *filepath,
+                              size_t      nthreads) {
+  ZF_LOGI("Initiailizing BGZF CSV Reader from filepath `%s`", filepath);
+
+#ifdef CSV_HAVE_ZLIB
+  return csv_blocked_init(dialect, filepath, nthreads, &csv_bgzf_codec);
+#else
+  (void)dialect;
+  (void)nthreads;
+  ZF_LOGE("built without zlib, BGZF input is not supported");
+  return NULL;
+#endif /* CSV_HAVE_ZLIB */
+}
+
+csvreader csvreader_zstd_seekable_init(csvdialect  dialect,
+                                       const char *filepath,
+                                       size_t      nthreads) {
+  ZF_LOGI("Initiailizing seekable zstd CSV Reader from filepath `%s`",
+          filepath);
+
+#ifdef CSV_HAVE_ZSTD
+  return csv_blocked_init(
+      dialect, filepath, nthreads, &csv_zstd_seekable_codec);
+#else
+  (void)dialect;
+  (void)nthreads;
+  ZF_LOGE("built without libzstd, zstd input is not supported");
+  return NULL;
+#endif /* CSV_HAVE_ZSTD */
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+csvreader csv_blocked_init(csvdialect             dialect,
+                           const char *           filepath,
+                           size_t                 nthreads,
+                           const csvblockedcodec *codec) {
+  csvblockedreader br = NULL;
+
+  if ((filepath == NULL) || ((br = csv_calloc(NULL, 1, sizeof *br)) == NULL)) {
+    ZF_LOGE("`csvblockedreader` could not be allocated");
+    return NULL;
+  }
+
+  br->codec = codec;
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_mutex_init(&br->lock, NULL);
+  pthread_cond_init(&br->done, NULL);
+  pthread_cond_init(&br->work, NULL);
+#endif
+
+  if (!csv_mmap_map(filepath, &br->map, &br->map_length)) {
+    ZF_LOGE("`%s` could not be mapped", filepath);
+    csv_blocked_close((csvstream_type)br);
+    return NULL;
+  }
+
+  if (!(*codec->table)(br)) {
+    ZF_LOGE("`%s` is not a %s file", filepath, codec->name);
+    csv_blocked_close((csvstream_type)br);
+    return NULL;
+  }
+
+  ZF_LOGD("`%lu` blocks hold `%lu` characters",
+          (long unsigned)br->count,
+          (long unsigned)br->length);
+
+  if (!csv_blocked_start(br, nthreads)) {
+    csv_blocked_close((csvstream_type)br);
+    return NULL;
+  }
+
+  /* releases the blocked reader on failure */
+  return csvreader_source_init(dialect,
+                               &csv_blocked_getnextblock,
+                               &csv_blocked_seek,
+                               &csv_blocked_close,
+                               (csvstream_type)br);
+}
+
+bool csv_blocked_start(csvblockedreader br, size_t nthreads) {
+  size_t slot_size = 1;
+
+  for (size_t b = 0; b < br->count; ++b) {
+    if (br->blocks[b].length > slot_size) slot_size = br->blocks[b].length;
+  }
+
+#ifdef CSV_HAVE_PTHREADS
+  br->nworkers = (nthreads > 0) ? nthreads : 1;
+  br->window   = br->nworkers * CSV_BLOCKED_AHEAD;
+#else
+  (void)nthreads;
+  br->nworkers = 1;
+  br->window   = 1;
+#endif
+
+  if (((br->slots = csv_calloc(NULL, br->window, sizeof *br->slots)) == NULL) ||
+      ((br->ready = csv_calloc(NULL, br->window, sizeof *br->ready)) == NULL) ||
+      ((br->workers =
+            csv_calloc(NULL, br->nworkers, sizeof *br->workers)) == NULL)) {
+    ZF_LOGE("`csvblockedreader` ring could not be allocated");
+    return false;
+  }
+
+  for (size_t s = 0; s < br->window; ++s) {
+    if ((br->slots[s] = csv_malloc(NULL, slot_size)) == NULL) {
+      ZF_LOGE("`csvblockedreader` slot could not be allocated");
+      return false;
+    }
+  }
+
+  for (size_t w = 0; w < br->nworkers; ++w) {
+    br->workers[w].br = br;
+
+    if ((br->workers[w].state = (*br->codec->open)()) == NULL) {
+      ZF_LOGE("decompression state could not be allocated");
+      return false;
+    }
+  }
+
+#ifdef CSV_HAVE_PTHREADS
+  for (size_t w = 0; w < br->nworkers; ++w) {
+    if (pthread_create(&br->workers[w].thread,
+                       NULL,
+                       &csv_blocked_work,
+                       &br->workers[w]) != 0) {
+      ZF_LOGE("`csvblockedreader` worker could not be started");
+      return false;
+    }
+    br->workers[w].started = true;
+  }
+#endif
+
+  return true;
+}
+
+bool csv_blocked_append(csvblockedreader br,
+                        size_t           offset,
+                        size_t           size,
+                        size_t           length,
+                        uint32_t         crc) {
+  csvblock *temp     = NULL;
+  size_t    capacity = (br->capacity > 0) ? br->capacity * 2 : 256;
+
+  if (br->count == br->capacity) {
+    temp = csv_realloc(NULL, br->blocks, capacity * sizeof *temp);
+    if (temp == NULL) {
+      ZF_LOGE("block table could not be grown");
+      return false;
+    }
+    br->blocks   = temp;
+    br->capacity = capacity;
+  }
+
+  br->blocks[br->count].offset = offset;
+  br->blocks[br->count].size   = size;
+  br->blocks[br->count].length = length;
+  br->blocks[br->count].start  = br->length;
+  br->blocks[br->count].crc    = crc;
+  br->count++;
+  br->length += length;
+  return true;
+}
+
+bool csv_blocked_decompress(csvblockedreader br, void *state, size_t b) {
+  const csvblock *block = &br->blocks[b];
+
+  return (*br->codec->decompress)(state,
+                                  (const unsigned char *)br->map +
+                                      block->offset,
+                                  block,
+                                  br->slots[b % br->window]);
+}
+
+CSV_STREAM_SIGNAL csv_blocked_getnextblock(csvstream_type streamdata,
+                                           const char **  block,
+                                           size_t *       length) {
+  csvblockedreader  br     = (csvblockedreader)streamdata;
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+  size_t            b      = 0;
+
+  *block  = NULL;
+  *length = 0;
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_mutex_lock(&br->lock);
+#endif
+
+  if (br->held) {
+    br->held = false;
+    br->consumed++;
+#ifdef CSV_HAVE_PTHREADS
+    pthread_cond_broadcast(&br->work);
+#endif
+  }
+
+  b = br->consumed;
+
+#ifdef CSV_HAVE_PTHREADS
+  while ((b < br->count) && (br->ready[b % br->window] != b + 1) &&
+         !br->failed) {
+    pthread_cond_wait(&br->done, &br->lock);
+  }
+#else
+  if ((b < br->count) && !br->failed) {
+    if (csv_blocked_decompress(br, br->workers[0].state, b)) {
+      br->ready[b % br->window] = b + 1;
+    } else {
+      br->failed = true;
+    }
+  }
+#endif
+
+  if (b >= br->count) {
+    signal = CSV_EOF;
+  } else if (br->ready[b % br->window] != b + 1) {
+    signal = CSV_ERROR;
+  } else {
+    *block   = br->slots[b % br->window] + br->skip;
+    *length  = br->blocks[b].length - br->skip;
+    br->skip = 0;
+    br->held = true;
+  }
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_mutex_unlock(&br->lock);
+#endif
+
+  ZF_LOGD("block `%lu` length: `%lu` CSV_STREAM_SIGNAL: `%d`",
+          (long unsigned)b,
+          (long unsigned)*length,
+          (int)signal);
+  return signal;
+}
+
+bool csv_blocked_seek(csvstream_type streamdata, uint64_t offset) {
+  csvblockedreader br    = (csvblockedreader)streamdata;
+  size_t           lower = 0;
+  size_t           upper = 0;
+  size_t           b     = 0;
+
+  if ((br == NULL) || (offset > br->length)) {
+    ZF_LOGD("offset `%lu` is past the end of the input",
+            (long unsigned)offset);
+    return false;
+  }
+
+  /* first block starting after `offset`, the one before holds it */
+  upper = br->count;
+  while (lower < upper) {
+    b = lower + (upper - lower) / 2;
+
+    if (br->blocks[b].start <= offset) {
+      lower = b + 1;
+    } else {
+      upper = b;
+    }
+  }
+  b = (lower > 0) ? lower - 1 : 0;
+  if (offset == br->length) b = br->count;
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_mutex_lock(&br->lock);
+
+  /* no more blocks are claimed, and the blocks being decompressed finish */
+  br->claimed = br->count;
+  while (br->busy > 0) pthread_cond_wait(&br->done, &br->lock);
+#endif
+
+  for (size_t s = 0; s < br->window; ++s) br->ready[s] = 0;
+
+  br->consumed = b;
+  br->claimed  = b;
+  br->skip     = (b < br->count) ? (size_t)(offset - br->blocks[b].start) : 0;
+  br->held     = false;
+  br->failed   = false;
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_cond_broadcast(&br->work);
+  pthread_mutex_unlock(&br->lock);
+#endif
+
+  ZF_LOGD("offset `%lu` is in block `%lu`",
+          (long unsigned)offset,
+          (long unsigned)b);
+  return true;
+}
+
+void csv_blocked_close(csvstream_type streamdata) {
+  csvblockedreader br = (csvblockedreader)streamdata;
+
+  if (br == NULL) return;
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_mutex_lock(&br->lock);
+  br->stop = true;
+  pthread_cond_broadcast(&br->work);
+  pthread_mutex_unlock(&br->lock);
+
+  for (size_t w = 0; (br->workers != NULL) && (w < br->nworkers); ++w) {
+    if (br->workers[w].started) pthread_join(br->workers[w].thread, NULL);
+  }
+
+  pthread_cond_destroy(&br->work);
+  pthread_cond_destroy(&br->done);
+  pthread_mutex_destroy(&br->lock);
+#endif
+
+  for (size_t w = 0; (br->workers != NULL) && (w < br->nworkers); ++w) {
+    if (br->workers[w].state != NULL) {
+      (*br->codec->release)(br->workers[w].state);
+    }
+  }
+
+  for (size_t s = 0; (br->slots != NULL) && (s < br->window); ++s) {
+    csv_free(NULL, br->slots[s]);
+  }
+
+  if (br->map != NULL) csv_mmap_unmap(br->map, br->map_length);
+
+  csv_free(NULL, br->workers);
+  csv_free(NULL, br->slots);
+  csv_free(NULL, br->ready);
+  csv_free(NULL, br->blocks);
+  csv_free(NULL, br);
+}
+
+#ifdef CSV_HAVE_PTHREADS
+void *csv_blocked_work(void *arg) {
+  csvblockedworker *worker = (csvblockedworker *)arg;
+  csvblockedreader  br     = worker->br;
+  size_t            b      = 0;
+  bool              ok     = false;
+
+  pthread_mutex_lock(&br->lock);
+
+  while (!br->stop) {
+    /* the parser's block is `consumed`, its slot is only reused after it */
+    if (br->failed || (br->claimed >= br->count) ||
+        (br->claimed >= br->consumed + br->window)) {
+      pthread_cond_wait(&br->work, &br->lock);
+      continue;
+    }
+
+    b = br->claimed++;
+    br->busy++;
+    pthread_mutex_unlock(&br->lock);
+
+    ok = csv_blocked_decompress(br, worker->state, b);
+
+    pthread_mutex_lock(&br->lock);
+    br->busy--;
+
+    if (ok) {
+      br->ready[b % br->window] = b + 1;
+    } else {
+      br->failed = true;
+    }
+    pthread_cond_broadcast(&br->done);
+  }
+
+  pthread_mutex_unlock(&br->lock);
+  return NULL;
+}
+#endif /* CSV_HAVE_PTHREADS */
+
+uint32_t csv_blocked_le16(const unsigned char *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+uint32_t csv_blocked_le32(const unsigned char *p) {
+  return csv_blocked_le16(p) | (csv_blocked_le16(p + 2) << 16);
+}
+
+#ifdef CSV_HAVE_ZLIB
+bool csv_bgzf_table(csvblockedreader br) {
+  const unsigned char *data     = (const unsigned char *)br->map;
+  const unsigned char *member   = NULL;
+  const unsigned char *field    = NULL;
+  size_t               position = 0;
+  size_t               left     = 0;
+  size_t               xlen     = 0;
+  size_t               bsize    = 0;
+  size_t               slen     = 0;
+
+  while (position < br->map_length) {
+    member = data + position;
+    left   = br->map_length - position;
+
+    /* gzip magic, deflate, FEXTRA set */
+    if ((left < 12) || (member[0] != 0x1f) || (member[1] != 0x8b) ||
+        (member[2] != 8) || ((member[3] & 4) == 0)) {
+      ZF_LOGD("member at `%lu` has no BGZF header", (long unsigned)position);
+      return false;
+    }
+
+    xlen  = csv_blocked_le16(member + 10);
+    bsize = 0;
+
+    /* the `BC` subfield holds the member size less one */
+    for (size_t extra = 0; (extra + 4 <= xlen) && (12 + xlen <= left);
+         extra += 4 + slen) {
+      field = member + 12 + extra;
+      slen  = csv_blocked_le16(field + 2);
+
+      if (extra + 4 + slen > xlen) break;
+
+      if ((field[0] == 'B') && (field[1] == 'C') && (slen == 2)) {
+        bsize = csv_blocked_le16(field + 4) + 1;
+      }
+    }
+
+    if ((bsize < 12 + xlen + 8) || (bsize > left)) {
+      ZF_LOGD("member at `%lu` has no valid BSIZE", (long unsigned)position);
+      return false;
+    }
+
+    /* the trailer holds the CRC-32 and the uncompressed length */
+    if (csv_blocked_le32(member + bsize - 4) > CSV_BGZF_BLOCK_SIZE) {
+      ZF_LOGD("member at `%lu` is too long", (long unsigned)position);
+      return false;
+    }
+
+    /* the empty end of file member is skipped */
+    if ((csv_blocked_le32(member + bsize - 4) > 0) &&
+        !csv_blocked_append(br,
+                            position + 12 + xlen,
+                            bsize - 12 - xlen - 8,
+                            csv_blocked_le32(member + bsize - 4),
+                            csv_blocked_le32(member + bsize - 8))) {
+      return false;
+    }
+
+    position += bsize;
+  }
+  return true;
+}
+
+void *csv_bgzf_open(void) {
+  z_stream *stream = csv_calloc(NULL, 1, sizeof *stream);
+
+  if ((stream != NULL) && (inflateInit2(stream, -15) != Z_OK)) {
+    csv_free(NULL, stream);
+    return NULL;
+  }
+  return stream;
+}
+
+bool csv_bgzf_decompress(void *               state,
+                         const unsigned char *in,
+                         const csvblock *     block,
+                         char *               out) {
+  z_stream *stream = (z_stream *)state;
+
+  inflateReset(stream);
+  stream->next_in   = in;
+  stream->avail_in  = (uInt)block->size;
+  stream->next_out  = (Bytef *)out;
+  stream->avail_out = (uInt)block->length;
+
+  if ((inflate(stream, Z_FINISH) != Z_STREAM_END) ||
+      (stream->avail_out != 0)) {
+    ZF_LOGE("BGZF member at `%lu` could not be inflated",
+            (long unsigned)block->offset);
+    return false;
+  }
+
+  if (crc32(0L, (const Bytef *)out, (uInt)block->length) != block->crc) {
+    ZF_LOGE("BGZF member at `%lu` fails its CRC check",
+            (long unsigned)block->offset);
+    return false;
+  }
+  return true;
+}
+
+void csv_bgzf_release(void *state) {
+  inflateEnd((z_stream *)state);
+  csv_free(NULL, state);
+}
+#endif /* CSV_HAVE_ZLIB */
+
+#ifdef CSV_HAVE_ZSTD
+bool csv_zstd_seekable_table(csvblockedreader br) {
+  const unsigned char *data     = (const unsigned char *)br->map;
+  const unsigned char *footer   = NULL;
+  const unsigned char *entry    = NULL;
+  size_t               frames   = 0;
+  size_t               width    = 0;
+  size_t               table    = 0;
+  size_t               position = 0;
+
+  if (br->map_length < 8 + CSV_ZSTD_SEEKABLE_FOOTER) return false;
+
+  /* the footer holds the frame count, a descriptor and the magic number */
+  footer = data + br->map_length - CSV_ZSTD_SEEKABLE_FOOTER;
+
+  if ((csv_blocked_le32(footer + 5) != CSV_ZSTD_SEEKABLE_MAGIC) ||
+      ((footer[4] & 0x7c) != 0)) {
+    ZF_LOGD("file has no seek table footer");
+    return false;
+  }
+
+  frames = csv_blocked_le32(footer);
+  width  = (footer[4] & 0x80) ? 12 : 8;
+
+  if (frames > (br->map_length - 8 - CSV_ZSTD_SEEKABLE_FOOTER) / width) {
+    ZF_LOGD("seek table is larger than the file");
+    return false;
+  }
+
+  /* the table is a skippable frame ending with the footer */
+  table = 8 + frames * width + CSV_ZSTD_SEEKABLE_FOOTER;
+  entry = data + br->map_length - table;
+
+  if ((csv_blocked_le32(entry) != CSV_ZSTD_SKIPPABLE_MAGIC) ||
+      (csv_blocked_le32(entry + 4) != table - 8)) {
+    ZF_LOGD("seek table frame header is invalid");
+    return false;
+  }
+
+  for (entry += 8; frames > 0; --frames, entry += width) {
+    size_t size   = csv_blocked_le32(entry);
+    size_t length = csv_blocked_le32(entry + 4);
+
+    if (size > br->map_length - table - position) {
+      ZF_LOGD("seek table frame runs past the table");
+      return false;
+    }
+
+    if ((length > 0) && !csv_blocked_append(br, position, size, length, 0)) {
+      return false;
+    }
+    position += size;
+  }
+
+  if (position != br->map_length - table) {
+    ZF_LOGD("seek table does not cover the file");
+    return false;
+  }
+  return true;
+}
+
+void *csv_zstd_seekable_open(void) { return ZSTD_createDCtx(); }
+
+bool csv_zstd_seekable_decompress(void *               state,
+                                  const unsigned char *in,
+                                  const csvblock *     block,
+                                  char *               out) {
+  size_t rc = ZSTD_decompressDCtx(
+      (ZSTD_DCtx *)state, out, block->length, in, block->size);
+
+  if (ZSTD_isError(rc) || (rc != block->length)) {
+    ZF_LOGE("frame at `%lu` could not be decompressed: `%s`",
+            (long unsigned)block->offset,
+            ZSTD_isError(rc) ? ZSTD_getErrorName(rc) : "length mismatch");
+    return false;
+  }
+  return true;
+}
+
+void csv_zstd_seekable_release(void *state) {
+  ZSTD_freeDCtx((ZSTD_DCtx *)state);
+}
+#endif /* CSV_HAVE_ZSTD */
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,259 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_columns.c
+ * @author Robert W. Smith
+ * @brief Implementation of the columnar CSV Record batch
+ *
+ * Private documentation, API subject to change. Each record is taken from
+ * the reader as field views and every field is copied into the column for its
+ * position. The views of @c csvreader_mmap_init point into the mapped file,
+ * so with it each field is copied exactly once. The readers of
+ * @c csvreader_init and @c csvreader_file_init assemble the field in their
+ * record buffer first, so it is copied twice. The offsets, values and
+ * validity buffers of a column are grown by doubling and kept between
+ * batches.
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Add columns until @p columns has @p length of them
+ *
+ * The records already in the batch are marked as not having the new columns.
+ *
+ * @return @c false if the columns could not be allocated
+ */
+bool csvcolumns_widen(csvcolumns *columns, size_t length);
+
+/**
+ * @brief Append a record of field views to the end of every column
+ *
+ * @return @c false if a column could not be grown
+ */
+bool csvcolumns_append(csvcolumns *    columns,
+                       const csvfield *fields,
+                       size_t          length);
+
+/**
+ * @brief Append a single value, or a missing value if @p field is @c NULL,
+ * to @p column which holds @p record values
+ *
+ * @return @c false if the column could not be grown
+ */
+bool csvcolumn_append(csvcolumn *column, size_t record, const csvfield *field);
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreturn csvreader_next_columns(csvreader   reader,
+                                 size_t      max_records,
+                                 csvcolumns *columns) {
+  ZF_LOGI("called reader: `%p` max records: `%lu`",
+          (void *)reader,
+          (long unsigned)max_records);
+  const csvfield *fields = NULL;
+  size_t          length = 0;
+  csvreturn       rc     = csvreturn_init(false);
+
+  columns->size   = 0;
+  columns->length = 0;
+
+  while (columns->size < max_records) {
+    rc = csvreader_next_record_view(reader, &fields, &length);
+
+    if (csv_failure(rc)) break;
+
+    if (!csvcolumns_append(columns, fields, length)) {
+      ZF_LOGE("`csvcolumns` could not be grown");
+      rc          = csvreturn_init(false);
+      rc.io_error = 1;
+      return rc;
+    }
+
+    if (rc.io_eof) break;
+  }
+
+  ZF_LOGD("`%lu` columns filled with `%lu` records",
+          (long unsigned)columns->length,
+          (long unsigned)columns->size);
+
+  if ((columns->size > 0) && !rc.io_error) {
+    rc.succeeded = 1;
+  }
+  return rc;
+}
+
+void csvcolumns_init(csvcolumns *columns) {
+  columns->size             = 0;
+  columns->length           = 0;
+  columns->columns          = NULL;
+  columns->capacity_columns = 0;
+}
+
+csvfield csvcolumns_field(const csvcolumns *columns,
+                          size_t            column,
+                          size_t            record) {
+  csvfield         view = {NULL, 0};
+  const csvcolumn *col  = NULL;
+
+  if ((column >= columns->length) || (record >= columns->size)) return view;
+
+  col = &columns->columns[column];
+
+  if ((col->validity[record >> 3] & (1U << (record & 7))) == 0) return view;
+
+  view.data = col->values + col->offsets[record];
+  view.len  = (size_t)(col->offsets[record + 1] - col->offsets[record]);
+  return view;
+}
+
+void csvcolumns_close(csvcolumns *columns) {
+  for (size_t i = 0; i < columns->capacity_columns; ++i) {
+    csv_free(NULL, columns->columns[i].offsets);
+    csv_free(NULL, columns->columns[i].values);
+    csv_free(NULL, columns->columns[i].validity);
+  }
+  csv_free(NULL, columns->columns);
+  csvcolumns_init(columns);
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+bool csvcolumns_widen(csvcolumns *columns, size_t length) {
+  size_t     capacity = columns->capacity_columns;
+  csvcolumn *column   = NULL;
+  void *     buffer   = NULL;
+
+  if ((buffer = csvbatch_reserve(columns->columns,
+                                 &columns->capacity_columns,
+                                 length,
+                                 8,
+                                 sizeof *columns->columns)) == NULL) {
+    return false;
+  }
+  columns->columns = buffer;
+
+  /* columns never used before own no buffers yet */
+  memset(columns->columns + capacity,
+         0,
+         (columns->capacity_columns - capacity) * sizeof *columns->columns);
+
+  for (; columns->length < length; ++columns->length) {
+    column = &columns->columns[columns->length];
+
+    if ((buffer = csvbatch_reserve(column->offsets,
+                                   &column->capacity_offsets,
+                                   columns->size + 1,
+                                   1024,
+                                   sizeof *column->offsets)) == NULL) {
+      return false;
+    }
+    column->offsets = buffer;
+
+    if ((buffer = csvbatch_reserve(column->validity,
+                                   &column->capacity_validity,
+                                   (columns->size >> 3) + 1,
+                                   128,
+                                   sizeof *column->validity)) == NULL) {
+      return false;
+    }
+    column->validity = buffer;
+
+    memset(column->offsets, 0, (columns->size + 1) * sizeof *column->offsets);
+    memset(column->validity, 0, (columns->size >> 3) + 1);
+  }
+  return true;
+}
+
+bool csvcolumns_append(csvcolumns *    columns,
+                       const csvfield *fields,
+                       size_t          length) {
+  if ((length > columns->length) && !csvcolumns_widen(columns, length)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < columns->length; ++i) {
+    if (!csvcolumn_append(&columns->columns[i],
+                          columns->size,
+                          (i < length) ? &fields[i] : NULL)) {
+      return false;
+    }
+  }
+
+  columns->size++;
+  return true;
+}
+
+bool csvcolumn_append(csvcolumn *column, size_t record, const csvfield *field) {
+  size_t used  = (size_t)column->offsets[record];
+  size_t bytes = (field != NULL) ? field->len : 0;
+  void * buffer = NULL;
+
+  if ((buffer = csvbatch_reserve(column->offsets,
+                                 &column->capacity_offsets,
+                                 record + 2,
+                                 1024,
+                                 sizeof *column->offsets)) == NULL) {
+    return false;
+  }
+  column->offsets = buffer;
+
+  if ((buffer = csvbatch_reserve(column->validity,
+                                 &column->capacity_validity,
+                                 (record >> 3) + 1,
+                                 128,
+                                 sizeof *column->validity)) == NULL) {
+    return false;
+  }
+  column->validity = buffer;
+
+  /* valid empty values still need a non-NULL buffer to point into */
+  if ((buffer = csvbatch_reserve(column->values,
+                                 &column->capacity_values,
+                                 (used + bytes > 0) ? used + bytes : 1,
+                                 4096,
+                                 sizeof *column->values)) == NULL) {
+    return false;
+  }
+  column->values = buffer;
+
+  /* first record of a validity byte clears the stale bits */
+  if ((record & 7) == 0) column->validity[record >> 3] = 0;
+
+  if (field != NULL) {
+    if (bytes > 0) memcpy(column->values + used, field->data, bytes);
+    column->validity[record >> 3] |= (uint8_t)(1U << (record & 7));
+  }
+
+  column->offsets[record + 1] = (int64_t)(used + bytes);
+  return true;
+}
+
+/**
+ * @endcond
+ */
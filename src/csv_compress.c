@@ -0,0 +1,383 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_compress.c
+ * @author Robert W. Smith
+ * @brief Implementation of the compressed CSV Readers
+ *
+ * Private documentation, API subject to change. The compressed file is read
+ * and inflated by the fill callback of a @c csvpipeline, which runs on its own
+ * thread when thread support is available, and the inflated blocks are handed
+ * straight to the parser.
+ *
+ * Support for each format is compiled in when its library was found, zlib for
+ * gzip (@c CSV_HAVE_ZLIB) and libzstd for Zstandard (@c CSV_HAVE_ZSTD).
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef CSV_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef CSV_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+/*
+ * blocks in flight between the decompression thread and the parser
+ */
+#define CSV_COMPRESS_BLOCKS 4
+
+/*
+ * size of each decompressed block
+ */
+#define CSV_COMPRESS_BLOCK_SIZE ((size_t)1 << 18)
+
+/*
+ * size of the buffer compressed input is read into
+ */
+#define CSV_COMPRESS_INPUT_SIZE ((size_t)1 << 16)
+
+#ifdef CSV_HAVE_ZLIB
+
+typedef struct csv_gzip_source *csvgzipsource;
+
+struct csv_gzip_source {
+  FILE *        file;
+  z_stream      stream;
+  unsigned char input[CSV_COMPRESS_INPUT_SIZE];
+  bool          input_eof; /* the file has been read to its end */
+  bool          member;    /* a gzip member has been started, not finished */
+  bool          ended;     /* a gzip member has been finished */
+};
+
+#endif /* CSV_HAVE_ZLIB */
+
+#ifdef CSV_HAVE_ZSTD
+
+typedef struct csv_zstd_source *csvzstdsource;
+
+struct csv_zstd_source {
+  FILE *         file;
+  ZSTD_DStream * stream;
+  ZSTD_inBuffer  in;
+  unsigned char *input;
+  size_t         capacity_in;
+  bool           input_eof; /* the file has been read to its end */
+  bool           frame;     /* a frame has been started, not finished */
+};
+
+#endif /* CSV_HAVE_ZSTD */
+
+/*
+ * private forward declarations
+ */
+
+#ifdef CSV_HAVE_ZLIB
+/**
+ * @brief Inflate gzip or zlib members, concatenated members are read in turn
+ *
+ * @see csvpipeline_fill
+ */
+CSV_STREAM_SIGNAL csv_gzip_fill(csvstream_type context,
+                                char *         buffer,
+                                size_t         capacity,
+                                size_t *       length);
+
+/**
+ * @brief Close the file and release the inflate state
+ */
+void csv_gzip_close(csvstream_type context);
+#endif /* CSV_HAVE_ZLIB */
+
+#ifdef CSV_HAVE_ZSTD
+/**
+ * @brief Decompress Zstandard frames, concatenated frames are read in turn
+ *
+ * @see csvpipeline_fill
+ */
+CSV_STREAM_SIGNAL csv_zstd_fill(csvstream_type context,
+                                char *         buffer,
+                                size_t         capacity,
+                                size_t *       length);
+
+/**
+ * @brief Close the file and release the decompression state
+ */
+void csv_zstd_close(csvstream_type context);
+#endif /* CSV_HAVE_ZSTD */
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreader csvreader_gzip_init(csvdialect dialect, const char *filepath) {
+  ZF_LOGI("Initiailizing gzip CSV Reader from filepath `%s`", filepath);
+
+#ifdef CSV_HAVE_ZLIB
+  csvgzipsource source   = NULL;
+  csvpipeline   pipeline = NULL;
+
+  if ((filepath == NULL) ||
+      ((source = csv_calloc(NULL, 1, sizeof *source)) == NULL)) {
+    ZF_LOGE("`csvgzipsource` could not be allocated");
+    return NULL;
+  }
+
+  /* 32 added to the window bits detects gzip and zlib headers */
+  if (inflateInit2(&source->stream, 15 + 32) != Z_OK) {
+    ZF_LOGE("inflate state could not be initialized");
+    csv_free(NULL, source);
+    return NULL;
+  }
+
+  if ((source->file = fopen(filepath, "rb")) == NULL) {
+    ZF_LOGE("`%s` could not be opened", filepath);
+    csv_gzip_close((csvstream_type)source);
+    return NULL;
+  }
+
+  /* both initializers release the source on failure */
+  if ((pipeline = csvpipeline_init(&csv_gzip_fill,
+                                   &csv_gzip_close,
+                                   NULL,
+                                   (csvstream_type)source,
+                                   CSV_COMPRESS_BLOCKS,
+                                   CSV_COMPRESS_BLOCK_SIZE)) == NULL) {
+    return NULL;
+  }
+
+  return csvreader_source_init(dialect,
+                               &csvpipeline_getnextblock,
+                               NULL,
+                               &csvpipeline_close,
+                               (csvstream_type)pipeline);
+#else
+  (void)dialect;
+  ZF_LOGE("built without zlib, gzip input is not supported");
+  return NULL;
+#endif /* CSV_HAVE_ZLIB */
+}
+
+csvreader csvreader_zstd_init(csvdialect dialect, const char *filepath) {
+  ZF_LOGI("Initiailizing zstd CSV Reader from filepath `%s`", filepath);
+
+#ifdef CSV_HAVE_ZSTD
+  csvzstdsource source   = NULL;
+  csvpipeline   pipeline = NULL;
+
+  if ((filepath == NULL) ||
+      ((source = csv_calloc(NULL, 1, sizeof *source)) == NULL)) {
+    ZF_LOGE("`csvzstdsource` could not be allocated");
+    return NULL;
+  }
+
+  source->capacity_in = ZSTD_DStreamInSize();
+
+  if (((source->stream = ZSTD_createDStream()) == NULL) ||
+      ((source->input = csv_malloc(NULL, source->capacity_in)) == NULL)) {
+    ZF_LOGE("decompression state could not be allocated");
+    csv_zstd_close((csvstream_type)source);
+    return NULL;
+  }
+  source->in.src = source->input;
+
+  if ((source->file = fopen(filepath, "rb")) == NULL) {
+    ZF_LOGE("`%s` could not be opened", filepath);
+    csv_zstd_close((csvstream_type)source);
+    return NULL;
+  }
+
+  /* both initializers release the source on failure */
+  if ((pipeline = csvpipeline_init(&csv_zstd_fill,
+                                   &csv_zstd_close,
+                                   NULL,
+                                   (csvstream_type)source,
+                                   CSV_COMPRESS_BLOCKS,
+                                   CSV_COMPRESS_BLOCK_SIZE)) == NULL) {
+    return NULL;
+  }
+
+  return csvreader_source_init(dialect,
+                               &csvpipeline_getnextblock,
+                               NULL,
+                               &csvpipeline_close,
+                               (csvstream_type)pipeline);
+#else
+  (void)dialect;
+  ZF_LOGE("built without libzstd, zstd input is not supported");
+  return NULL;
+#endif /* CSV_HAVE_ZSTD */
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+#ifdef CSV_HAVE_ZLIB
+CSV_STREAM_SIGNAL csv_gzip_fill(csvstream_type context,
+                                char *         buffer,
+                                size_t         capacity,
+                                size_t *       length) {
+  csvgzipsource source = (csvgzipsource)context;
+  z_stream *    stream = &source->stream;
+  size_t        count  = 0;
+  int           rc     = Z_OK;
+
+  /* zlib counts in `uInt`, a smaller block is simply filled in full */
+  if (capacity > (size_t)UINT_MAX) capacity = (size_t)UINT_MAX;
+
+  stream->next_out  = (Bytef *)buffer;
+  stream->avail_out = (uInt)capacity;
+
+  while (stream->avail_out > 0) {
+    if ((stream->avail_in == 0) && !source->input_eof) {
+      count = fread(source->input, 1, sizeof source->input, source->file);
+
+      if (ferror(source->file)) {
+        ZF_LOGE("compressed input could not be read");
+        return CSV_ERROR;
+      }
+
+      source->input_eof = (count == 0);
+      stream->next_in   = source->input;
+      stream->avail_in  = (uInt)count;
+    }
+
+    /* a started member may still hold output without further input */
+    if ((stream->avail_in == 0) && !source->member) break;
+
+    /* as with `gzip -d`, padding or junk after the last member is ignored */
+    if (source->ended && !source->member &&
+        ((stream->next_in[0] != 0x1f) ||
+         ((stream->avail_in > 1) && (stream->next_in[1] != 0x8b)))) {
+      ZF_LOGW("trailing data after the last gzip member is ignored");
+      stream->avail_in  = 0;
+      source->input_eof = true;
+      break;
+    }
+
+    source->member = true;
+    rc             = inflate(stream, Z_NO_FLUSH);
+
+    if (rc == Z_STREAM_END) {
+      /* another member may follow */
+      source->member = false;
+      source->ended  = true;
+      inflateReset(stream);
+    } else if (rc == Z_BUF_ERROR) {
+      if ((stream->avail_in == 0) && source->input_eof) break;
+    } else if (rc != Z_OK) {
+      ZF_LOGE("inflate failed: `%s`", stream->msg ? stream->msg : "unknown");
+      return CSV_ERROR;
+    }
+  }
+
+  *length = capacity - stream->avail_out;
+  if (*length > 0) return CSV_GOOD;
+
+  if (source->member) {
+    ZF_LOGE("compressed input ends in the middle of a member");
+    return CSV_ERROR;
+  }
+  return CSV_EOF;
+}
+
+void csv_gzip_close(csvstream_type context) {
+  csvgzipsource source = (csvgzipsource)context;
+
+  if (source == NULL) return;
+
+  if (source->file != NULL) fclose(source->file);
+  inflateEnd(&source->stream);
+  csv_free(NULL, source);
+}
+#endif /* CSV_HAVE_ZLIB */
+
+#ifdef CSV_HAVE_ZSTD
+CSV_STREAM_SIGNAL csv_zstd_fill(csvstream_type context,
+                                char *         buffer,
+                                size_t         capacity,
+                                size_t *       length) {
+  csvzstdsource  source   = (csvzstdsource)context;
+  ZSTD_outBuffer out      = {buffer, capacity, 0};
+  size_t         produced = 0;
+  size_t         rc       = 0;
+
+  while (out.pos < out.size) {
+    if ((source->in.pos == source->in.size) && !source->input_eof) {
+      source->in.size =
+          fread(source->input, 1, source->capacity_in, source->file);
+      source->in.pos = 0;
+
+      if (ferror(source->file)) {
+        ZF_LOGE("compressed input could not be read");
+        return CSV_ERROR;
+      }
+      source->input_eof = (source->in.size == 0);
+    }
+
+    /* a started frame may still hold output without further input */
+    if ((source->in.pos == source->in.size) && !source->frame) break;
+
+    source->frame = true;
+    produced      = out.pos;
+    rc            = ZSTD_decompressStream(source->stream, &out, &source->in);
+
+    if (ZSTD_isError(rc)) {
+      ZF_LOGE("decompression failed: `%s`", ZSTD_getErrorName(rc));
+      return CSV_ERROR;
+    }
+
+    if (rc == 0) {
+      /* another frame may follow */
+      source->frame = false;
+    } else if ((out.pos == produced) && (source->in.pos == source->in.size) &&
+               source->input_eof) {
+      break;
+    }
+  }
+
+  *length = out.pos;
+  if (*length > 0) return CSV_GOOD;
+
+  if (source->frame) {
+    ZF_LOGE("compressed input ends in the middle of a frame");
+    return CSV_ERROR;
+  }
+  return CSV_EOF;
+}
+
+void csv_zstd_close(csvstream_type context) {
+  csvzstdsource source = (csvzstdsource)context;
+
+  if (source == NULL) return;
+
+  if (source->file != NULL) fclose(source->file);
+  ZSTD_freeDStream(source->stream);
+  csv_free(NULL, source->input);
+  csv_free(NULL, source);
+}
+#endif /* CSV_HAVE_ZSTD */
+
+/**
+ * @endcond
+ */
@@ -29,6 +29,7 @@
 // #include "csv/version.h"
 
 // #include "csv/dialect.h"
+#include "alloc_private.h"
 #include "dialect_private.h"
 
 /*
@@ -38,9 +39,19 @@
 /**
  * @brief CSV Dialect private allocator / default setup.
  *
+ * @param[in]  allocator  allocator of the dialect, @c NULL for the library
+ *                        allocator
+ *
  * @return  null / zero initialized CSV Dialect
  */
-csvdialect csvdialect_alloc(void);
+csvdialect csvdialect_alloc(const csvallocator *allocator);
+
+/**
+ * @brief Default initialized CSV Dialect, allocated with @p allocator
+ *
+ * @see csvdialect_init
+ */
+csvdialect csvdialect_allocator_init(const csvallocator *allocator);
 
 /*
  * private function declarations - end
@@ -58,12 +69,16 @@ struct csv_dialect {
   QUOTE_STYLE              quotestyle;
   bool                     doublequote;
   bool                     skipinitialspace;
+  csvallocator             origin;    /* allocated the dialect */
+  csvallocator             allocator; /* for readers, writers and copies */
 };
 
-csvdialect csvdialect_alloc(void) {
+csvdialect csvdialect_alloc(const csvallocator *allocator) {
   csvdialect dialect;
 
-  if ((dialect = malloc(sizeof *dialect)) == NULL) {
+  if (allocator == NULL) allocator = csv_get_allocator();
+
+  if ((dialect = csv_malloc(allocator, sizeof *dialect)) == NULL) {
     return NULL;
   }
 
@@ -75,14 +90,18 @@ csvdialect csvdialect_alloc(void) {
   dialect->quotestyle            = QUOTE_STYLE_MINIMAL;
   dialect->doublequote           = false;
   dialect->skipinitialspace      = false;
+  dialect->origin                = *allocator;
+  dialect->allocator             = *allocator;
 
   return dialect;
 }
 
-csvdialect csvdialect_init(void) {
+csvdialect csvdialect_init(void) { return csvdialect_allocator_init(NULL); }
+
+csvdialect csvdialect_allocator_init(const csvallocator *allocator) {
   csvdialect dialect;
 
-  if ((dialect = csvdialect_alloc()) == NULL) {
+  if ((dialect = csvdialect_alloc(allocator)) == NULL) {
     ZF_LOGE("default initialization failure - allocation");
     return NULL;
   }
@@ -153,7 +172,7 @@ csvdialect csvdialect_copy(csvdialect dialect) {
   bool                     doublequote;
   bool                     skipinitialspace;
 
-  if ((output = csvdialect_init()) == NULL) {
+  if ((output = csvdialect_allocator_init(&dialect->allocator)) == NULL) {
     ZF_LOGE("dialect copy failure - output allocation");
     return NULL;
   }
@@ -220,17 +239,63 @@ csvdialect csvdialect_copy(csvdialect dialect) {
   return output;
 }
 
+csvdialect csvdialect_worker_copy(csvdialect dialect) {
+  csvdialect output =
+      (dialect == NULL) ? csvdialect_init() : csvdialect_copy(dialect);
+
+  if ((output != NULL) &&
+      csv_failure(csvdialect_set_allocator(output, NULL, NULL, NULL, NULL))) {
+    csvdialect_close(&output);
+  }
+  return output;
+}
+
 void csvdialect_close(csvdialect *dialect) {
   if ((*dialect) == NULL) {
     ZF_LOGE("`dialect` value is NULL");
     return;
   }
 
+  /* the dialect holds its own allocator, keep it past the release */
+  csvallocator origin = (*dialect)->origin;
+
   ZF_LOGD("freeing dialect resources: %p", (void *)(*dialect));
-  free((*dialect));
+  csv_free(&origin, (void *)(*dialect)->lineterminator);
+  csv_free(&origin, (*dialect));
   *dialect = NULL;
 }
 
+csvreturn csvdialect_set_allocator(csvdialect     dialect,
+                                   csv_malloc_fn  malloc_fn,
+                                   csv_realloc_fn realloc_fn,
+                                   csv_free_fn    free_fn,
+                                   void *         context) {
+  if (dialect == NULL) {
+    ZF_LOGE("`dialect` value is NULL");
+    return csvreturn_init(false);
+  }
+
+  if ((malloc_fn == NULL) && (realloc_fn == NULL) && (free_fn == NULL)) {
+    dialect->allocator = *csv_get_allocator();
+    return csvreturn_init(true);
+  }
+
+  if ((malloc_fn == NULL) || (realloc_fn == NULL) || (free_fn == NULL)) {
+    ZF_LOGE("allocator functions must all be supplied, or all be NULL");
+    return csvreturn_init(false);
+  }
+
+  dialect->allocator.malloc_fn  = malloc_fn;
+  dialect->allocator.realloc_fn = realloc_fn;
+  dialect->allocator.free_fn    = free_fn;
+  dialect->allocator.context    = context;
+  return csvreturn_init(true);
+}
+
+const csvallocator *csvdialect_get_allocator(csvdialect dialect) {
+  return (dialect == NULL) ? csv_get_allocator() : &dialect->allocator;
+}
+
 /*
  * TODO: update and document...
  */
@@ -365,7 +430,7 @@ csvreturn csvdialect_set_lineterminator(csvdialect  dialect,
   }
 
   if (dialect->lineterminator != NULL) {
-    free((void *)dialect->lineterminator);
+    csv_free(&dialect->origin, (void *)dialect->lineterminator);
   }
   dialect->lineterminator        = NULL;
   dialect->lineterminator_length = 0;
@@ -377,14 +442,15 @@ csvreturn csvdialect_set_lineterminator(csvdialect  dialect,
 
   if (length == 0) length = strlen(lineterminator);
 
-  if ((buffer = malloc(sizeof *buffer * (length + 1))) == NULL) {
+  if ((buffer = csv_malloc(&dialect->origin, sizeof *buffer * (length + 1))) ==
+      NULL) {
     ZF_LOGE("Could not allocate new lineterminator buffer");
     return csvreturn_init(false);
   }
 
   if (strncpy(buffer, lineterminator, (length + 1)) == NULL) {
     ZF_LOGE("strncpy could not copy string");
-    free(buffer);
+    csv_free(&dialect->origin, buffer);
     return csvreturn_init(false);
   }
 
@@ -0,0 +1,269 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_fd.c
+ * @author Robert W. Smith
+ * @brief Implementation of the file descriptor and stdin CSV Readers
+ *
+ * Private documentation, API subject to change. The descriptor is read with
+ * large @c read calls by the fill callback of a @c csvpipeline, on its own
+ * thread when thread support is available, so a pipe is drained while the
+ * parser works through the blocks already read. Each call returns whatever
+ * the descriptor holds, up to a block, so records written slowly into a pipe
+ * reach the parser without waiting for the block to fill.
+ *
+ * Where the platform allows it the capacity of a pipe is raised to a block,
+ * so each @c read drains more of it.
+ *
+ * The reading thread waits for input with @c poll on the descriptor and on a
+ * wake-up pipe, which is written as the reader is closed. A reader closed
+ * early, for instance by a consumer stopping part way through a shell
+ * pipeline, does not wait for the writer of the descriptor to finish.
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+/*
+ * blocks in flight between the reading thread and the parser
+ */
+#define CSV_FD_BLOCKS 4
+
+/*
+ * size of each block, and of each read
+ */
+#define CSV_FD_BLOCK_SIZE ((size_t)1 << 20)
+
+typedef struct csv_fd_source *csvfdsource;
+
+struct csv_fd_source {
+  int fd;      /* not closed by the reader */
+  int wake[2]; /* wake-up pipe, or -1 without one */
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Read whatever the descriptor holds, up to @p capacity characters
+ *
+ * @see csvpipeline_fill
+ */
+CSV_STREAM_SIGNAL csv_fd_fill(csvstream_type context,
+                              char *         buffer,
+                              size_t         capacity,
+                              size_t *       length);
+
+/**
+ * @brief Release the source, the descriptor is left open
+ */
+void csv_fd_close(csvstream_type context);
+
+/**
+ * @brief Return a @c csv_fd_fill waiting for input with @c CSV_EOF
+ */
+void csv_fd_wake(csvstream_type context);
+
+/**
+ * @brief Wait until the descriptor can be read or the source is woken
+ *
+ * @return @c CSV_GOOD once readable, @c CSV_EOF once woken or @c CSV_ERROR
+ */
+CSV_STREAM_SIGNAL csv_fd_wait(csvfdsource source);
+
+/**
+ * @brief Raise the capacity of a pipe to a block, failures are ignored
+ */
+void csv_fd_grow_pipe(int fd);
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreader csvreader_fd_init(csvdialect dialect, int fd) {
+  ZF_LOGI("Initiailizing CSV Reader from file descriptor `%d`", fd);
+  csvfdsource source   = NULL;
+  csvpipeline pipeline = NULL;
+
+  if ((fd < 0) || ((source = csv_calloc(NULL, 1, sizeof *source)) == NULL)) {
+    ZF_LOGE("`csvfdsource` could not be allocated");
+    return NULL;
+  }
+
+  source->fd      = fd;
+  source->wake[0] = -1;
+  source->wake[1] = -1;
+  csv_fd_grow_pipe(fd);
+
+#ifndef _WIN32
+  if ((pipe(source->wake) != 0) ||
+      (fcntl(source->wake[0], F_SETFD, FD_CLOEXEC) != 0) ||
+      (fcntl(source->wake[1], F_SETFD, FD_CLOEXEC) != 0)) {
+    ZF_LOGE("wake-up pipe could not be created: `%s`", strerror(errno));
+    csv_fd_close((csvstream_type)source);
+    return NULL;
+  }
+#endif
+
+  /* both initializers release the source on failure */
+  if ((pipeline = csvpipeline_init(&csv_fd_fill,
+                                   &csv_fd_close,
+                                   &csv_fd_wake,
+                                   (csvstream_type)source,
+                                   CSV_FD_BLOCKS,
+                                   CSV_FD_BLOCK_SIZE)) == NULL) {
+    return NULL;
+  }
+
+  return csvreader_source_init(dialect,
+                               &csvpipeline_getnextblock,
+                               NULL,
+                               &csvpipeline_close,
+                               (csvstream_type)pipeline);
+}
+
+csvreader csvreader_stdin_init(csvdialect dialect) {
+#ifdef _WIN32
+  return csvreader_fd_init(dialect, _fileno(stdin));
+#else
+  return csvreader_fd_init(dialect, STDIN_FILENO);
+#endif
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+CSV_STREAM_SIGNAL csv_fd_fill(csvstream_type context,
+                              char *         buffer,
+                              size_t         capacity,
+                              size_t *       length) {
+  csvfdsource       source = (csvfdsource)context;
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+  long              count  = 0;
+
+  if ((signal = csv_fd_wait(source)) != CSV_GOOD) return signal;
+
+  do {
+#ifdef _WIN32
+    count = _read(source->fd, buffer, (unsigned)capacity);
+#else
+    count = (long)read(source->fd, buffer, capacity);
+#endif
+  } while ((count < 0) && (errno == EINTR));
+
+  if (count < 0) {
+    ZF_LOGE("file descriptor `%d` could not be read: `%s`",
+            source->fd,
+            strerror(errno));
+    return CSV_ERROR;
+  }
+
+  *length = (size_t)count;
+  return (count > 0) ? CSV_GOOD : CSV_EOF;
+}
+
+void csv_fd_close(csvstream_type context) {
+  csvfdsource source = (csvfdsource)context;
+
+#ifndef _WIN32
+  if (source->wake[0] >= 0) close(source->wake[0]);
+  if (source->wake[1] >= 0) close(source->wake[1]);
+#endif
+  csv_free(NULL, source);
+}
+
+void csv_fd_wake(csvstream_type context) {
+#ifndef _WIN32
+  csvfdsource source = (csvfdsource)context;
+  long        count  = 0;
+
+  /* the byte is never read, every later wait returns at once */
+  do {
+    count = (long)write(source->wake[1], "", 1);
+  } while ((count < 0) && (errno == EINTR));
+#else
+  (void)context;
+#endif
+}
+
+CSV_STREAM_SIGNAL csv_fd_wait(csvfdsource source) {
+#ifndef _WIN32
+  struct pollfd fds[2];
+  int           ready = 0;
+
+  fds[0].fd     = source->fd;
+  fds[0].events = POLLIN;
+  fds[1].fd     = source->wake[0];
+  fds[1].events = POLLIN;
+
+  do {
+    fds[0].revents = 0;
+    fds[1].revents = 0;
+    ready          = poll(fds, 2, -1);
+  } while ((ready < 0) && (errno == EINTR));
+
+  if (ready < 0) {
+    ZF_LOGE("file descriptor `%d` could not be polled: `%s`",
+            source->fd,
+            strerror(errno));
+    return CSV_ERROR;
+  }
+
+  if (fds[1].revents != 0) {
+    ZF_LOGD("file descriptor `%d` reader woken", source->fd);
+    return CSV_EOF;
+  }
+#else
+  /* without poll the read blocks, the descriptor's writer ends it */
+  (void)source;
+#endif
+  return CSV_GOOD;
+}
+
+void csv_fd_grow_pipe(int fd) {
+#ifdef F_SETPIPE_SZ
+  struct stat status;
+
+  if ((fstat(fd, &status) == 0) && S_ISFIFO(status.st_mode) &&
+      (fcntl(fd, F_SETPIPE_SZ, (int)CSV_FD_BLOCK_SIZE) < 0)) {
+    ZF_LOGD("pipe capacity could not be raised: `%s`", strerror(errno));
+  }
+#else
+  (void)fd;
+#endif
+}
+
+/**
+ * @endcond
+ */
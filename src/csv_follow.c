@@ -0,0 +1,345 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_follow.c
+ * @author Robert W. Smith
+ * @brief Implementation of the tail-follow CSV Reader
+ *
+ * Private documentation, API subject to change. The file is read in blocks
+ * through a block source. At the end of the file the source waits for the
+ * file to grow instead of ending the input: on Linux it sleeps on an inotify
+ * watch of the file's directory, which also reports the file being replaced,
+ * elsewhere it polls. When the wait times out the source answers
+ * @c CSV_AGAIN, which leaves the reader paused with any partial trailing
+ * record kept in its buffers, so the next call carries on with that record.
+ *
+ * At the end of the file the path is checked again. A file which was
+ * replaced, as by log rotation, is reopened and read from its start, a file
+ * which was truncated is read again from its start.
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+#ifndef _WIN32
+
+/*
+ * size of each read
+ */
+#define CSV_FOLLOW_BLOCK_SIZE ((size_t)1 << 16)
+
+/*
+ * milliseconds between checks of the file when it cannot be watched
+ */
+#define CSV_FOLLOW_POLL_INTERVAL 100
+
+/*
+ * milliseconds between checks of a watched file, in case an event is missed
+ */
+#define CSV_FOLLOW_WATCH_INTERVAL 1000
+
+typedef struct csv_follow_source *csvfollowsource;
+
+struct csv_follow_source {
+  char *filepath;
+  int   fd;
+  int   notify;  /* inotify descriptor, -1 when polling */
+  int   timeout; /* milliseconds to wait for input, negative for no limit */
+
+  char block[CSV_FOLLOW_BLOCK_SIZE];
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Read the next block of the file, waiting at its end for more
+ *
+ * @return @c CSV_GOOD with a block, @c CSV_AGAIN if the wait timed out or
+ *         @c CSV_ERROR
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csv_follow_getnextblock(csvstream_type streamdata,
+                                          const char **  block,
+                                          size_t *       length);
+
+/**
+ * @brief Release the source and close the file
+ */
+void csv_follow_close(csvstream_type streamdata);
+
+/**
+ * @brief Watch the directory of the file for changes, failures are ignored
+ */
+void csv_follow_watch(csvfollowsource source);
+
+/**
+ * @brief Start over on a file which was replaced or truncated
+ *
+ * @return @c true if there is new input to read
+ */
+bool csv_follow_reopen(csvfollowsource source);
+
+/**
+ * @brief Wait up to @p timeout milliseconds for the file to change
+ *
+ * May return early, the file is checked again either way.
+ */
+void csv_follow_wait(csvfollowsource source, int timeout);
+
+/**
+ * @brief Milliseconds on a monotonic clock
+ */
+int64_t csv_follow_now(void);
+
+/*
+ * end of private forward declarations
+ */
+
+#endif /* _WIN32 */
+
+/*
+ * API implementation
+ */
+csvreader csvreader_follow_init(csvdialect  dialect,
+                                const char *filepath,
+                                int         timeout) {
+  ZF_LOGI("Initiailizing following CSV Reader for filepath `%s`", filepath);
+#ifdef _WIN32
+  (void)dialect;
+  (void)timeout;
+  ZF_LOGE("following a file is not supported on this platform");
+  return NULL;
+#else
+  csvfollowsource source = NULL;
+  size_t          length = 0;
+
+  if ((filepath == NULL) ||
+      ((source = csv_calloc(NULL, 1, sizeof *source)) == NULL)) {
+    ZF_LOGE("`csvfollowsource` could not be allocated");
+    return NULL;
+  }
+
+  source->fd      = -1;
+  source->notify  = -1;
+  source->timeout = timeout;
+
+  length = strlen(filepath);
+  if ((source->filepath = csv_malloc(NULL, length + 1)) == NULL) {
+    ZF_LOGE("`filepath` could not be copied");
+    csv_follow_close((csvstream_type)source);
+    return NULL;
+  }
+  memcpy(source->filepath, filepath, length + 1);
+
+  /* watch before opening, no change after the open can be missed */
+  csv_follow_watch(source);
+
+  if ((source->fd = open(filepath, O_RDONLY)) < 0) {
+    ZF_LOGE("`%s` could not be opened: `%s`", filepath, strerror(errno));
+    csv_follow_close((csvstream_type)source);
+    return NULL;
+  }
+
+  /* releases the source on failure */
+  return csvreader_source_init(dialect,
+                               &csv_follow_getnextblock,
+                               NULL,
+                               &csv_follow_close,
+                               (csvstream_type)source);
+#endif
+}
+
+/*
+ * end of API implementations
+ */
+
+#ifndef _WIN32
+
+/*
+ * private implementations
+ */
+CSV_STREAM_SIGNAL csv_follow_getnextblock(csvstream_type streamdata,
+                                          const char **  block,
+                                          size_t *       length) {
+  csvfollowsource source   = (csvfollowsource)streamdata;
+  int64_t         deadline = -1;
+  int64_t         wait     = 0;
+  ssize_t         count    = 0;
+
+  *block  = NULL;
+  *length = 0;
+
+  while (true) {
+    do {
+      count = read(source->fd, source->block, CSV_FOLLOW_BLOCK_SIZE);
+    } while ((count < 0) && (errno == EINTR));
+
+    if (count < 0) {
+      ZF_LOGE("`%s` could not be read: `%s`",
+              source->filepath,
+              strerror(errno));
+      return CSV_ERROR;
+    }
+
+    if (count > 0) {
+      *block  = source->block;
+      *length = (size_t)count;
+      return CSV_GOOD;
+    }
+
+    if (csv_follow_reopen(source)) continue;
+
+    wait = (source->notify >= 0) ? CSV_FOLLOW_WATCH_INTERVAL
+                                 : CSV_FOLLOW_POLL_INTERVAL;
+
+    if (source->timeout >= 0) {
+      if (deadline < 0) deadline = csv_follow_now() + source->timeout;
+      if (deadline - csv_follow_now() < wait) {
+        wait = deadline - csv_follow_now();
+      }
+      if (wait <= 0) {
+        ZF_LOGD("no input for `%s` within the timeout", source->filepath);
+        return CSV_AGAIN;
+      }
+    }
+
+    csv_follow_wait(source, (int)wait);
+  }
+}
+
+void csv_follow_close(csvstream_type streamdata) {
+  csvfollowsource source = (csvfollowsource)streamdata;
+
+  if (source == NULL) return;
+
+  if (source->fd >= 0) close(source->fd);
+  if (source->notify >= 0) close(source->notify);
+  csv_free(NULL, source->filepath);
+  csv_free(NULL, source);
+}
+
+void csv_follow_watch(csvfollowsource source) {
+#ifdef __linux__
+  const char *slash = strrchr(source->filepath, '/');
+  char *      dir   = NULL;
+  size_t      size  = 0;
+
+  /* the directory, so a file created in place of ours is reported too */
+  if (slash == NULL) {
+    if ((dir = csv_malloc(NULL, 2)) != NULL) memcpy(dir, ".", 2);
+  } else {
+    size = (size_t)(slash - source->filepath);
+    if (size == 0) size = 1;
+    if ((dir = csv_malloc(NULL, size + 1)) != NULL) {
+      memcpy(dir, source->filepath, size);
+      dir[size] = '\0';
+    }
+  }
+
+  if ((dir != NULL) &&
+      ((source->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) >= 0) &&
+      (inotify_add_watch(source->notify,
+                         dir,
+                         IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE |
+                             IN_MOVED_TO | IN_ATTRIB) < 0)) {
+    close(source->notify);
+    source->notify = -1;
+  }
+
+  if (source->notify < 0) {
+    ZF_LOGD("`%s` cannot be watched, polling", source->filepath);
+  }
+  csv_free(NULL, dir);
+#else
+  (void)source;
+#endif
+}
+
+bool csv_follow_reopen(csvfollowsource source) {
+  struct stat opened;
+  struct stat named;
+  off_t       position = 0;
+  int         fd       = -1;
+
+  if (fstat(source->fd, &opened) != 0) return false;
+
+  /* a missing path may be between rotation steps, keep the open file */
+  if ((stat(source->filepath, &named) == 0) &&
+      ((named.st_dev != opened.st_dev) || (named.st_ino != opened.st_ino))) {
+    if ((fd = open(source->filepath, O_RDONLY)) < 0) return false;
+
+    ZF_LOGD("`%s` was replaced, reading the new file", source->filepath);
+    close(source->fd);
+    source->fd = fd;
+    return true;
+  }
+
+  position = lseek(source->fd, 0, SEEK_CUR);
+  if ((position > 0) && (opened.st_size < position)) {
+    ZF_LOGD("`%s` was truncated, reading from its start", source->filepath);
+    return lseek(source->fd, 0, SEEK_SET) == 0;
+  }
+  return false;
+}
+
+void csv_follow_wait(csvfollowsource source, int timeout) {
+  struct pollfd watch;
+  char          events[4096];
+
+  if (source->notify < 0) {
+    poll(NULL, 0, timeout);
+    return;
+  }
+
+  watch.fd      = source->notify;
+  watch.events  = POLLIN;
+  watch.revents = 0;
+
+  if (poll(&watch, 1, timeout) > 0) {
+    /* the events only wake the reader, the file is checked by reading */
+    while (read(source->notify, events, sizeof events) > 0) continue;
+  }
+}
+
+int64_t csv_follow_now(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000 + (int64_t)(now.tv_nsec / 1000000);
+}
+
+#endif /* _WIN32 */
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,373 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_index.c
+ * @author Robert W. Smith
+ * @brief Implementation of the CSV Record offset index
+ *
+ * Private documentation, API subject to change. The index is built by a
+ * single structural scan of the memory mapped file, an entry is kept for
+ * every @c interval records. Each entry is the offset of the first character
+ * of its record together with the parser state just before it, so the parser
+ * can be restarted there without reading anything before the record.
+ *
+ * An index is extended after the input has grown by scanning again from its
+ * last entry. The checksum of the last @c CSV_INDEX_CHECKED characters
+ * covered by the index is kept to detect an input which was rewritten rather
+ * than appended to.
+ *
+ * The sidecar file is a fixed header followed by the offsets and then the
+ * states of every entry, all in native byte order:
+ *
+ * | bytes        | content                                  |
+ * |--------------|------------------------------------------|
+ * | 8            | magic @c "CSVIDX1"                       |
+ * | 8            | interval                                 |
+ * | 8            | records                                  |
+ * | 8            | length of the input in characters        |
+ * | 8            | checksum                                 |
+ * | 8            | size, the number of entries              |
+ * | 8 * size     | offsets                                  |
+ * | size         | states                                   |
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+/**
+ * @brief Identifies an index sidecar file and its version
+ */
+static const char csvindex_magic[8] = "CSVIDX1";
+
+/**
+ * @brief Number of characters before the end of the indexed input covered by
+ * the checksum
+ */
+#define CSV_INDEX_CHECKED 65536
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Allocate an empty index with entries every @p interval records
+ *
+ * @return @c NULL if the index could not be allocated
+ */
+csvindex *csvindex_init(uint64_t interval);
+
+/**
+ * @brief Scan the file at @p filepath into @p index and write it to
+ * @p indexpath
+ *
+ * An @p index with entries is only extended, after checking the file still
+ * begins with the input it was built from.
+ */
+csvreturn csvindex_scan(csvdialect  dialect,
+                        const char *filepath,
+                        const char *indexpath,
+                        csvindex *  index);
+
+/**
+ * @brief FNV-1a hash of the last @c CSV_INDEX_CHECKED characters of the first
+ * @p length characters of @p data
+ */
+uint64_t csvindex_checksum(const char *data, uint64_t length);
+
+/**
+ * @brief Write @p index to the sidecar file at @p indexpath
+ *
+ * @return @c false if the file could not be written
+ */
+bool csvindex_write(const csvindex *index, const char *indexpath);
+
+/**
+ * @brief Read an index from the sidecar file at @p indexpath
+ *
+ * @return @c NULL if the file could not be read or is not an index
+ */
+csvindex *csvindex_read(const char *indexpath);
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreturn csvreader_build_index(csvdialect  dialect,
+                                const char *filepath,
+                                const char *indexpath,
+                                uint64_t    interval) {
+  ZF_LOGI("indexing filepath `%s` into `%s` every `%lu` records",
+          filepath,
+          indexpath,
+          (long unsigned)interval);
+  csvindex *index = NULL;
+  csvreturn rc    = csvreturn_init(false);
+
+  if (interval == 0) {
+    ZF_LOGE("an index needs an interval of at least one record");
+    return rc;
+  }
+
+  if ((index = csvindex_init(interval)) == NULL) {
+    ZF_LOGE("`csvindex` could not be allocated");
+    return rc;
+  }
+
+  rc = csvindex_scan(dialect, filepath, indexpath, index);
+  csvindex_close(index);
+  return rc;
+}
+
+csvreturn csvreader_update_index(csvdialect  dialect,
+                                 const char *filepath,
+                                 const char *indexpath) {
+  ZF_LOGI("extending index `%s` of filepath `%s`", indexpath, filepath);
+  csvindex *index = NULL;
+  csvreturn rc    = csvreturn_init(false);
+
+  if ((indexpath == NULL) || ((index = csvindex_read(indexpath)) == NULL)) {
+    ZF_LOGE("`%s` is not a readable index", indexpath);
+    rc.io_error = 1;
+    return rc;
+  }
+
+  rc = csvindex_scan(dialect, filepath, indexpath, index);
+  csvindex_close(index);
+  return rc;
+}
+
+csvreturn csvreader_load_index(csvreader reader, const char *indexpath) {
+  ZF_LOGI("called reader: `%p` indexpath: `%s`", (void *)reader, indexpath);
+  csvindex *index = NULL;
+  csvreturn rc    = csvreturn_init(false);
+
+  if ((reader == NULL) || (indexpath == NULL)) return rc;
+
+  if ((index = csvindex_read(indexpath)) == NULL) {
+    ZF_LOGE("`%s` is not a readable index", indexpath);
+    rc.io_error = 1;
+    return rc;
+  }
+
+  csvreader_set_index(reader, index);
+  return csvreturn_init(true);
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+csvindex *csvindex_init(uint64_t interval) {
+  csvindex *index = NULL;
+
+  if ((index = csv_calloc(NULL, 1, sizeof *index)) == NULL) return NULL;
+
+  index->interval = interval;
+  return index;
+}
+
+bool csvindex_append(csvindex *index, uint64_t offset, uint8_t state) {
+  uint64_t capacity = index->capacity;
+  void *   buffer   = NULL;
+
+  if (index->size == capacity) {
+    capacity = (capacity > 0) ? capacity * 2 : 256;
+
+    if ((buffer = csv_realloc(NULL,
+                              index->offsets,
+                              (size_t)capacity * sizeof *index->offsets)) ==
+        NULL) {
+      return false;
+    }
+    index->offsets = buffer;
+
+    if ((buffer = csv_realloc(NULL,
+                              index->states,
+                              (size_t)capacity * sizeof *index->states)) ==
+        NULL) {
+      return false;
+    }
+    index->states   = buffer;
+    index->capacity = capacity;
+  }
+
+  index->offsets[index->size] = offset;
+  index->states[index->size]  = state;
+  index->size++;
+  return true;
+}
+
+void csvindex_close(csvindex *index) {
+  if (index == NULL) return;
+
+  csv_free(NULL, index->offsets);
+  csv_free(NULL, index->states);
+  csv_free(NULL, index);
+}
+
+csvreturn csvindex_scan(csvdialect  dialect,
+                        const char *filepath,
+                        const char *indexpath,
+                        csvindex *  index) {
+  const char *map     = NULL;
+  size_t      length  = 0;
+  uint64_t    records = 0;
+  uint64_t    fields  = 0;
+  csvreader   reader  = NULL;
+  csvreturn   rc      = csvreturn_init(false);
+
+  if ((filepath == NULL) || (indexpath == NULL) ||
+      !csv_mmap_map(filepath, &map, &length)) {
+    ZF_LOGE("`%s` could not be mapped", filepath);
+    rc.io_error = 1;
+    return rc;
+  }
+
+  if ((index->size > 0) &&
+      ((length < index->length) ||
+       (csvindex_checksum(map, index->length) != index->checksum))) {
+    ZF_LOGE("`%s` has changed since it was indexed", filepath);
+    csv_mmap_unmap(map, length);
+    return rc;
+  }
+
+  if ((index->size > 0) && (length == index->length)) {
+    ZF_LOGD("`%s` has not grown since it was indexed", filepath);
+    csv_mmap_unmap(map, length);
+    return csvreturn_init(true);
+  }
+
+  /* the reader only provides the compiled dialect */
+  if ((reader = csvreader_memory_init(dialect, NULL, 0)) == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    csv_mmap_unmap(map, length);
+    return rc;
+  }
+
+  if (csvreader_scan_block(reader, map, length, &records, &fields, index)) {
+    index->records  = records;
+    index->length   = length;
+    index->checksum = csvindex_checksum(map, length);
+    rc.succeeded    = csvindex_write(index, indexpath);
+  }
+  rc.io_error = !rc.succeeded;
+
+  ZF_LOGD("indexed `%lu` records with `%lu` entries",
+          (long unsigned)records,
+          (long unsigned)index->size);
+
+  csvreader_close(&reader);
+  csv_mmap_unmap(map, length);
+  return rc;
+}
+
+uint64_t csvindex_checksum(const char *data, uint64_t length) {
+  uint64_t hash = UINT64_C(14695981039346656037);
+  uint64_t i    = (length > CSV_INDEX_CHECKED) ? length - CSV_INDEX_CHECKED : 0;
+
+  for (; i < length; ++i) {
+    hash = (hash ^ (unsigned char)data[i]) * UINT64_C(1099511628211);
+  }
+  return hash;
+}
+
+bool csvindex_write(const csvindex *index, const char *indexpath) {
+  const uint64_t header[5] = {index->interval,
+                              index->records,
+                              index->length,
+                              index->checksum,
+                              index->size};
+  FILE *file = NULL;
+  bool  good = false;
+
+  if ((file = fopen(indexpath, "wb")) == NULL) {
+    ZF_LOGE("`%s` could not be opened for writing", indexpath);
+    return false;
+  }
+
+  good = (fwrite(csvindex_magic, sizeof csvindex_magic, 1, file) == 1) &&
+         (fwrite(header, sizeof header, 1, file) == 1) &&
+         (fwrite(index->offsets,
+                 sizeof *index->offsets,
+                 (size_t)index->size,
+                 file) == index->size) &&
+         (fwrite(index->states,
+                 sizeof *index->states,
+                 (size_t)index->size,
+                 file) == index->size);
+
+  if ((fclose(file) != 0) || !good) {
+    ZF_LOGE("`%s` could not be written", indexpath);
+    return false;
+  }
+  return true;
+}
+
+csvindex *csvindex_read(const char *indexpath) {
+  char      magic[sizeof csvindex_magic];
+  uint64_t  header[5];
+  FILE *    file  = NULL;
+  csvindex *index = NULL;
+  bool      good  = false;
+
+  if ((file = fopen(indexpath, "rb")) == NULL) return NULL;
+
+  if ((fread(magic, sizeof magic, 1, file) != 1) ||
+      (memcmp(magic, csvindex_magic, sizeof magic) != 0) ||
+      (fread(header, sizeof header, 1, file) != 1) || (header[0] == 0) ||
+      (header[4] > header[1]) ||
+      ((index = csvindex_init(header[0])) == NULL)) {
+    fclose(file);
+    return NULL;
+  }
+
+  index->records  = header[1];
+  index->length   = header[2];
+  index->checksum = header[3];
+  index->size     = header[4];
+  index->capacity = header[4];
+
+  /* an index of an empty input has no entries to read */
+  good = (index->size == 0) ||
+         (((index->offsets = csv_malloc(
+                NULL, (size_t)index->size * sizeof *index->offsets)) != NULL) &&
+          ((index->states = csv_malloc(
+                NULL, (size_t)index->size * sizeof *index->states)) != NULL) &&
+          (fread(index->offsets,
+                 sizeof *index->offsets,
+                 (size_t)index->size,
+                 file) == index->size) &&
+          (fread(index->states,
+                 sizeof *index->states,
+                 (size_t)index->size,
+                 file) == index->size));
+
+  fclose(file);
+
+  if (!good) {
+    csvindex_close(index);
+    return NULL;
+  }
+  return index;
+}
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,684 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_mmap.c
+ * @author Robert W. Smith
+ * @brief Implementation of the memory mapped CSV Reader stream
+ *
+ * Private documentation, API subject to change. The whole file is handed to
+ * the parser as a single block, so runs of field characters arrive through
+ * the @c appendslice callback as references into the mapping. Those slices are
+ * kept as-is, a field is only copied into the reader's buffer once the parser
+ * needs to change its contents (escapes and doubled quotes).
+ *
+ * @see csv/read.h
+ * @see csv/stream.h
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#ifndef __STDC_WANT_LIB_EXT1__
+#define __STDC_WANT_LIB_EXT1__ 1
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "dialect_private.h"
+#include "read_private.h"
+
+/*
+ * private forward declarations
+ */
+typedef struct csv_mmap_reader *csvmmapreader;
+
+/**
+ * @brief Map @p filepath and allocate the field and record buffers
+ *
+ * @return Fully initialized @c csvmmapreader, or NULL on error
+ */
+csvmmapreader csv_mmap_open(const char *        filepath,
+                            const csvallocator *allocator);
+
+/**
+ * @brief Allocate the field and record buffers, without any input
+ *
+ * @return Initialized @c csvmmapreader, or NULL on error
+ */
+csvmmapreader csv_mmap_alloc(const csvallocator *allocator);
+
+/**
+ * @brief Hands the rest of the mapping to the parser as a single block
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csv_mmap_getnextblock(csvstream_type streamdata,
+                                        const char **  block,
+                                        size_t *       length);
+
+/**
+ * @brief Append a single character, copying the current field if needed
+ *
+ * @see csvstream_appendfield
+ */
+void csv_mmap_appendchar(csvstream_type           streamdata,
+                         csv_comparison_char_type value);
+
+/**
+ * @brief Append a run of the mapping, extending the current slice if possible
+ *
+ * @see csvstream_appendslice
+ */
+void csv_mmap_appendslice(csvstream_type streamdata,
+                          const char *   data,
+                          size_t         length);
+
+/**
+ * @brief Save the current field as the next field of the record
+ *
+ * @see csvstream_savefield
+ */
+void csv_mmap_savefield(csvstream_type streamdata);
+
+/**
+ * @brief Copy the record into caller owned strings
+ *
+ * @see csvstream_saverecord
+ */
+void csv_mmap_saverecord(csvstream_type streamdata,
+                         char ***       fields,
+                         size_t *       length);
+
+/**
+ * @brief Return the record as views into the mapping and field buffer
+ *
+ * @see csvstream_saverecordview
+ */
+void csv_mmap_saverecordview(csvstream_type   streamdata,
+                             const csvfield **fields,
+                             size_t *         length);
+
+/**
+ * @brief Hand out the mapping from @p offset next, discarding the current
+ * record
+ *
+ * @see csvstream_seek
+ */
+bool csv_mmap_seek(csvstream_type streamdata, uint64_t offset);
+
+/**
+ * @brief Unmap the file and release the buffers
+ *
+ * @see csvstream_close
+ */
+void csv_mmap_close(csvstream_type streamdata);
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * field of the record being parsed, either a slice of the mapping or a range
+ * of the field buffer. Buffer ranges are stored as offsets because the buffer
+ * may move while the record is being parsed.
+ */
+struct csv_mmap_field {
+  const char *slice;
+  size_t      offset;
+  size_t      length;
+};
+
+struct csv_mmap_reader {
+  csvallocator allocator; /* the dialect's, records are returned with it */
+
+  const char *filepath;
+  const char *map;
+  size_t      map_length;
+  size_t      offset; /* start of the block handed out next */
+  bool        mapped_out;
+  bool        owns_map; /* false for `csvreader_memory_init` input */
+
+  /* current field, a slice until it has to be copied into `buffer` */
+  const char *slice;
+  size_t      slice_length;
+  size_t      offset_f;
+  bool        copied_f;
+
+  /* current record */
+  struct csv_mmap_field *record;
+  size_t                 size_r;
+  size_t                 capacity_r;
+
+  /* characters of copied fields for the current record */
+  char * buffer;
+  size_t size_b;
+  size_t capacity_b;
+
+  /* views handed back by `csv_mmap_saverecordview` */
+  csvfield *view;
+  size_t    capacity_v;
+};
+
+/*
+ * API implementation
+ */
+csvreader csvreader_mmap_init(csvdialect dialect, const char *filepath) {
+  ZF_LOGI("Initiailizing memory mapped CSV Reader from filepath `%s`",
+          filepath);
+
+  csvreader     reader     = NULL;
+  csvmmapreader mmapreader = NULL;
+
+  mmapreader = csv_mmap_open(filepath, csvdialect_get_allocator(dialect));
+  if (mmapreader == NULL) {
+    ZF_LOGE("`csvmmapreader` could not be allocated");
+    return NULL;
+  }
+
+  reader = csvreader_advanced_block_init(dialect,
+                                         &csv_mmap_getnextblock,
+                                         &csv_mmap_appendchar,
+                                         &csv_mmap_savefield,
+                                         &csv_mmap_saverecord,
+                                         (csvstream_type)mmapreader);
+
+  /* setters are NULL safe */
+  reader = csvreader_set_appendslice(reader, &csv_mmap_appendslice);
+  reader = csvreader_set_saverecordview(reader, &csv_mmap_saverecordview);
+  reader = csvreader_set_closer(reader, &csv_mmap_close);
+  reader = csvreader_set_seek(reader, &csv_mmap_seek);
+
+  if (reader == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    csv_mmap_close((csvstream_type)mmapreader);
+    return NULL;
+  }
+
+  ZF_LOGD("`csvreader` successfully allocated `%p`", (void *)reader);
+  return reader;
+}
+
+csvreader csvreader_memory_init(csvdialect  dialect,
+                                const char *data,
+                                size_t      length) {
+  ZF_LOGI("Initiailizing CSV Reader over `%lu` bytes of memory",
+          (long unsigned)length);
+
+  csvreader     reader     = NULL;
+  csvmmapreader mmapreader = NULL;
+
+  mmapreader = csv_mmap_alloc(csvdialect_get_allocator(dialect));
+  if (mmapreader == NULL) {
+    ZF_LOGE("`csvmmapreader` could not be allocated");
+    return NULL;
+  }
+
+  mmapreader->map        = data;
+  mmapreader->map_length = length;
+
+  reader = csvreader_advanced_block_init(dialect,
+                                         &csv_mmap_getnextblock,
+                                         &csv_mmap_appendchar,
+                                         &csv_mmap_savefield,
+                                         &csv_mmap_saverecord,
+                                         (csvstream_type)mmapreader);
+
+  /* setters are NULL safe */
+  reader = csvreader_set_appendslice(reader, &csv_mmap_appendslice);
+  reader = csvreader_set_saverecordview(reader, &csv_mmap_saverecordview);
+  reader = csvreader_set_closer(reader, &csv_mmap_close);
+  reader = csvreader_set_seek(reader, &csv_mmap_seek);
+
+  if (reader == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    csv_mmap_close((csvstream_type)mmapreader);
+    return NULL;
+  }
+
+  return reader;
+}
+
+void csvreader_memory_reset(csvreader reader, const char *data, size_t length) {
+  csvmmapreader mr = (csvmmapreader)csvreader_get_streamdata(reader);
+
+  if (mr == NULL) return;
+
+  csvreader_rewind(reader);
+
+  mr->map        = data;
+  mr->map_length = length;
+  csv_mmap_seek((csvstream_type)mr, 0);
+}
+
+/*
+ * private implementations
+ */
+
+bool csv_mmap_map(const char *filepath, const char **map, size_t *length) {
+  *map    = NULL;
+  *length = 0;
+
+#if defined(_WIN32)
+  HANDLE        file    = INVALID_HANDLE_VALUE;
+  HANDLE        mapping = NULL;
+  LARGE_INTEGER size;
+
+  file = CreateFileA(filepath,
+                     GENERIC_READ,
+                     FILE_SHARE_READ,
+                     NULL,
+                     OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                     NULL);
+
+  if (file == INVALID_HANDLE_VALUE) {
+    ZF_LOGD("`CreateFileA` could not open `%s`", filepath);
+    return false;
+  }
+
+  if (!GetFileSizeEx(file, &size) || ((uint64_t)size.QuadPart > SIZE_MAX)) {
+    ZF_LOGD("file size of `%s` could not be determined or mapped", filepath);
+    CloseHandle(file);
+    return false;
+  }
+
+  if ((*length = (size_t)size.QuadPart) > 0) {
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (mapping != NULL) {
+      *map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+  }
+
+  /* the view holds its own reference to the file */
+  CloseHandle(file);
+#else
+  int         fd = -1;
+  struct stat st;
+  void *      mapped = NULL;
+
+  if ((fd = open(filepath, O_RDONLY)) < 0) {
+    ZF_LOGD("`open` could not open `%s`", filepath);
+    return false;
+  }
+
+  if ((fstat(fd, &st) != 0) || ((uint64_t)st.st_size > SIZE_MAX)) {
+    ZF_LOGD("file size of `%s` could not be determined or mapped", filepath);
+    close(fd);
+    return false;
+  }
+
+  if ((*length = (size_t)st.st_size) > 0) {
+    mapped = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (mapped != MAP_FAILED) {
+      *map = (const char *)mapped;
+      posix_madvise(mapped, *length, POSIX_MADV_SEQUENTIAL);
+    }
+  }
+
+  /* the mapping holds its own reference to the file */
+  close(fd);
+#endif
+
+  if ((*length > 0) && (*map == NULL)) {
+    ZF_LOGD("`%s` could not be mapped", filepath);
+    *length = 0;
+    return false;
+  }
+  return true;
+}
+
+void csv_mmap_unmap(const char *map, size_t length) {
+  if (map == NULL) return;
+
+#if defined(_WIN32)
+  (void)length;
+  UnmapViewOfFile((LPCVOID)map);
+#else
+  munmap((void *)map, length);
+#endif
+}
+
+csvmmapreader csv_mmap_alloc(const csvallocator *allocator) {
+  csvmmapreader mr = NULL;
+
+  if ((mr = csv_calloc(allocator, 1, sizeof *mr)) == NULL) {
+    ZF_LOGD("`csvmmapreader` could not be allocated");
+    return NULL;
+  }
+
+  mr->allocator = *allocator;
+
+  /* same defaults as the stdio reader, see `csvfilereader_init` */
+  mr->capacity_r = 8;
+  mr->capacity_b = 256;
+  mr->capacity_v = 8;
+
+  if (((mr->record = csv_malloc(allocator,
+                                 sizeof *mr->record * mr->capacity_r)) ==
+       NULL) ||
+      ((mr->buffer = csv_malloc(allocator,
+                                 sizeof *mr->buffer * mr->capacity_b)) ==
+       NULL) ||
+      ((mr->view = csv_malloc(allocator, sizeof *mr->view * mr->capacity_v)) ==
+       NULL)) {
+    ZF_LOGD("`csvmmapreader` buffers could not be allocated");
+    csv_mmap_close((csvstream_type)mr);
+    return NULL;
+  }
+  return mr;
+}
+
+csvmmapreader csv_mmap_open(const char *        filepath,
+                            const csvallocator *allocator) {
+  ZF_LOGI("`csv_mmap_open` called with filepath: `%s`", filepath);
+
+  if (filepath == NULL) {
+    ZF_LOGD("`csvmmapreader` filepath cannot be a NULL string, returning NULL");
+    return NULL;
+  }
+
+  csvmmapreader mr = NULL;
+
+  if ((mr = csv_mmap_alloc(allocator)) == NULL) return NULL;
+
+  mr->filepath = filepath;
+
+  if (!csv_mmap_map(filepath, &mr->map, &mr->map_length)) {
+    csv_mmap_close((csvstream_type)mr);
+    return NULL;
+  }
+  mr->owns_map = true;
+
+  ZF_LOGD("`csvmmapreader` successfully mapped `%lu` bytes",
+          (long unsigned)mr->map_length);
+  return mr;
+}
+
+CSV_STREAM_SIGNAL csv_mmap_getnextblock(csvstream_type streamdata,
+                                        const char **  block,
+                                        size_t *       length) {
+  *block  = NULL;
+  *length = 0;
+
+  if (streamdata == NULL) {
+    ZF_LOGD("`csvstream_type` provided was NULL");
+    return CSV_ERROR;
+  }
+
+  csvmmapreader mr = (csvmmapreader)streamdata;
+
+  if (mr->mapped_out || (mr->offset >= mr->map_length)) {
+    ZF_LOGD("End of mapping reached");
+    return CSV_EOF;
+  }
+
+  mr->mapped_out = true;
+  *block         = mr->map + mr->offset;
+  *length        = mr->map_length - mr->offset;
+  return CSV_GOOD;
+}
+
+bool csv_mmap_seek(csvstream_type streamdata, uint64_t offset) {
+  csvmmapreader mr = (csvmmapreader)streamdata;
+
+  if ((mr == NULL) || (offset > mr->map_length)) {
+    ZF_LOGD("`csv_mmap_seek` offset `%lu` is outside of the mapping",
+            (long unsigned)offset);
+    return false;
+  }
+
+  mr->offset       = (size_t)offset;
+  mr->mapped_out   = false;
+  mr->slice        = NULL;
+  mr->slice_length = 0;
+  mr->copied_f     = false;
+  mr->size_r       = 0;
+  mr->size_b       = 0;
+  return true;
+}
+
+/*
+ * append to the field buffer, growing it with the same policy as
+ * `csv_file_appendchar`
+ */
+static bool csv_mmap_buffer_append(csvmmapreader mr,
+                                   const char *  data,
+                                   size_t        length) {
+  char * temp     = NULL;
+  size_t capacity = mr->capacity_b;
+
+  while ((mr->size_b + length) > capacity) {
+    capacity = (capacity > 4096) ? (capacity + 1024) : (capacity * 2);
+  }
+
+  if (capacity != mr->capacity_b) {
+    if ((temp = csv_realloc(&mr->allocator, mr->buffer, capacity)) == NULL) {
+      ZF_LOGE("`csvmmapreader` field buffer could not be expanded");
+      return false;
+    }
+    mr->buffer     = temp;
+    mr->capacity_b = capacity;
+  }
+
+  memcpy(mr->buffer + mr->size_b, data, length);
+  mr->size_b += length;
+  return true;
+}
+
+/*
+ * the field can no longer be represented as a slice of the mapping
+ */
+static void csv_mmap_copy_field(csvmmapreader mr) {
+  mr->copied_f = true;
+  mr->offset_f = mr->size_b;
+
+  if (mr->slice != NULL) {
+    csv_mmap_buffer_append(mr, mr->slice, mr->slice_length);
+    mr->slice        = NULL;
+    mr->slice_length = 0;
+  }
+}
+
+void csv_mmap_appendchar(csvstream_type           streamdata,
+                         csv_comparison_char_type value) {
+  if (streamdata == NULL) {
+    ZF_LOGD("`csvstream_type` provided was NULL, bad value");
+    return;
+  }
+
+  csvmmapreader mr        = (csvmmapreader)streamdata;
+  char          character = (char)value;
+
+  if (!mr->copied_f) csv_mmap_copy_field(mr);
+  csv_mmap_buffer_append(mr, &character, 1);
+}
+
+void csv_mmap_appendslice(csvstream_type streamdata,
+                          const char *   data,
+                          size_t         length) {
+  if (streamdata == NULL) {
+    ZF_LOGD("`csvstream_type` provided was NULL, bad value");
+    return;
+  }
+
+  csvmmapreader mr = (csvmmapreader)streamdata;
+
+  if (!mr->copied_f) {
+    if (mr->slice == NULL) {
+      mr->slice        = data;
+      mr->slice_length = length;
+      return;
+    }
+
+    if (data == (mr->slice + mr->slice_length)) {
+      mr->slice_length += length;
+      return;
+    }
+
+    /* characters were dropped between runs, e.g. a closing quote */
+    csv_mmap_copy_field(mr);
+  }
+  csv_mmap_buffer_append(mr, data, length);
+}
+
+void csv_mmap_savefield(csvstream_type streamdata) {
+  if (streamdata == NULL) {
+    ZF_LOGD("`csvstream_type` provided was NULL, bad value");
+    return;
+  }
+
+  csvmmapreader          mr    = (csvmmapreader)streamdata;
+  struct csv_mmap_field *temp  = NULL;
+  struct csv_mmap_field *field = NULL;
+
+  if (mr->size_r >= mr->capacity_r) {
+    size_t capacity =
+        (mr->capacity_r > 128) ? (mr->capacity_r + 128) : (mr->capacity_r * 2);
+
+    temp = csv_realloc(&mr->allocator, mr->record, sizeof *temp * capacity);
+    if (temp == NULL) {
+      ZF_LOGE("`csvmmapreader` record could not be expanded");
+      return;
+    }
+    mr->record     = temp;
+    mr->capacity_r = capacity;
+  }
+
+  field = &mr->record[mr->size_r++];
+
+  if (mr->copied_f) {
+    field->slice  = NULL;
+    field->offset = mr->offset_f;
+    field->length = mr->size_b - mr->offset_f;
+  } else {
+    field->slice  = mr->slice;
+    field->offset = 0;
+    field->length = mr->slice_length;
+  }
+
+  /* reset the current field */
+  mr->slice        = NULL;
+  mr->slice_length = 0;
+  mr->copied_f     = false;
+}
+
+void csv_mmap_saverecord(csvstream_type streamdata,
+                         char ***       fields,
+                         size_t *       length) {
+  *fields = NULL;
+  *length = 0;
+
+  if (streamdata == NULL) {
+    ZF_LOGD("`csv_mmap_saverecord` streamdata is NULL");
+    return;
+  }
+
+  csvmmapreader   mr     = (csvmmapreader)streamdata;
+  const csvfield *view   = NULL;
+  size_t          count  = 0;
+  char **         record = NULL;
+
+  csv_mmap_saverecordview(streamdata, &view, &count);
+
+  if ((record = csv_malloc(&mr->allocator, sizeof *record * count)) == NULL) {
+    ZF_LOGD("`csv_mmap_saverecord` record could not be allocated");
+    return;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if ((record[i] = csv_malloc(&mr->allocator, view[i].len + 1)) == NULL) {
+      ZF_LOGD("`csv_mmap_saverecord` field could not be allocated");
+
+      while (i > 0) csv_free(&mr->allocator, record[--i]);
+      csv_free(&mr->allocator, record);
+      return;
+    }
+    memcpy(record[i], view[i].data, view[i].len);
+    record[i][view[i].len] = '\0';
+  }
+
+  *fields = record;
+  *length = count;
+}
+
+void csv_mmap_saverecordview(csvstream_type   streamdata,
+                             const csvfield **fields,
+                             size_t *         length) {
+  *fields = NULL;
+  *length = 0;
+
+  if (streamdata == NULL) {
+    ZF_LOGD("`csv_mmap_saverecordview` streamdata is NULL");
+    return;
+  }
+
+  csvmmapreader mr   = (csvmmapreader)streamdata;
+  csvfield *    temp = NULL;
+
+  if (mr->size_r > mr->capacity_v) {
+    temp = csv_realloc(&mr->allocator, mr->view, sizeof *temp * mr->capacity_r);
+    if (temp == NULL) {
+      ZF_LOGE("`csvmmapreader` view could not be expanded");
+      mr->size_r = 0;
+      mr->size_b = 0;
+      return;
+    }
+    mr->view       = temp;
+    mr->capacity_v = mr->capacity_r;
+  }
+
+  for (size_t i = 0; i < mr->size_r; ++i) {
+    const struct csv_mmap_field *field = &mr->record[i];
+
+    mr->view[i].data =
+        (field->slice != NULL) ? field->slice : (mr->buffer + field->offset);
+    mr->view[i].len = field->length;
+  }
+
+  *fields = mr->view;
+  *length = mr->size_r;
+
+  /* buffer contents stay valid until the next record overwrites them */
+  mr->size_r = 0;
+  mr->size_b = 0;
+}
+
+void csv_mmap_close(csvstream_type streamdata) {
+  ZF_LOGI("streamdata is %s", streamdata == NULL ? "NULL" : "NOT NULL");
+
+  if (streamdata == NULL) return;
+
+  csvmmapreader mr        = (csvmmapreader)streamdata;
+  csvallocator  allocator = mr->allocator;
+
+  /* mr->filepath is allocated externally, not freed here */
+  if (mr->owns_map) csv_mmap_unmap(mr->map, mr->map_length);
+  csv_free(&allocator, mr->record);
+  csv_free(&allocator, mr->buffer);
+  csv_free(&allocator, mr->view);
+  csv_free(&allocator, mr);
+}
+
+/**
+ * @endcond
+ */
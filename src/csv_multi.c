@@ -0,0 +1,664 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_multi.c
+ * @author Robert W. Smith
+ * @brief Implementation of the multi-file CSV Reader
+ *
+ * Private documentation, API subject to change. Worker threads claim whole
+ * files in list order and parse each one with its own memory mapped reader
+ * into a short queue of @c csvbatch, so several files are parsed at once
+ * while the consumer delivers records in list order. A worker may only run a
+ * bounded number of files ahead of the consumer, and stops while the queue of
+ * its file is full, which keeps memory use proportional to the number of
+ * threads rather than the number of files.
+ *
+ * Without workers the files are read one after another by the consumer.
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CSV_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#ifndef _WIN32
+#include <glob.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "dialect_private.h"
+#include "read_private.h"
+
+/*
+ * records parsed into each batch
+ */
+#define CSV_MULTI_BATCH_RECORDS 4096
+
+/*
+ * batches queued per file
+ */
+#define CSV_MULTI_QUEUE 4
+
+/*
+ * files parsed ahead of the consumer per worker thread
+ */
+#define CSV_MULTI_WINDOW 2
+
+typedef struct csv_multi_reader *csvmultireader;
+
+/**
+ * @brief Queue of the batches parsed from a single file
+ */
+struct csv_multi_file {
+  bool     done;     /**< every record of the file has been queued */
+  bool     failed;   /**< the file could not be read */
+  size_t   produced; /**< batches queued */
+  size_t   consumed; /**< batches delivered */
+  csvbatch batches[CSV_MULTI_QUEUE]; /**< batch `b` in `batches[b % QUEUE]` */
+};
+
+struct csv_multi_reader {
+  csvdialect dialect; /* copied, used by every file's reader */
+  char **    paths;
+  size_t     npaths;
+  bool       skip_headers;
+
+  /* file being delivered, and the record of its batch to deliver next */
+  size_t          current;
+  const csvbatch *active;
+  size_t          record;
+  bool            first; /* the next record is the first of its file */
+
+  /* first record of the input, compared with the first of each file */
+  csvbatch header;
+  bool     have_header;
+
+  /* reader of `current` when there are no workers */
+  csvreader sequential;
+
+#ifdef CSV_HAVE_PTHREADS
+  /* file `f` is queued in `files[f % window]` */
+  struct csv_multi_file *files;
+  size_t                 window;
+  size_t                 next_file; /* next file to hand to a worker */
+  bool                   stop;
+
+  pthread_mutex_t lock;
+  pthread_cond_t  work; /* signalled when files or queue entries free up */
+  pthread_cond_t  done; /* signalled when batches are queued */
+  pthread_t *     threads;
+  size_t          nthreads;
+#endif
+
+  /* record handed out by `csv_multi_saverecordview` */
+  const csvfield *current_fields;
+  size_t          current_length;
+  csvfield *      view;
+  size_t          capacity_v;
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Copy the dialect and file list and start the worker threads
+ *
+ * @return Fully initialized @c csvmultireader, or NULL on error
+ */
+csvmultireader csv_multi_open(csvdialect   dialect,
+                              const char **paths,
+                              size_t       npaths,
+                              size_t       nthreads,
+                              bool         skip_headers);
+
+/**
+ * @brief Whether a record is delivered or dropped as a repeated header
+ *
+ * Keeps the first record of the input to compare with the first record of
+ * each later file.
+ *
+ * @return @c false if the record is dropped
+ */
+bool csv_multi_keep(csvmultireader  mr,
+                    const csvfield *fields,
+                    size_t          length);
+
+/**
+ * @brief Produce the next record from the files read one after another
+ */
+CSV_STREAM_SIGNAL csv_multi_sequential_record(csvmultireader mr);
+
+/**
+ * @brief Produce the next record in list order
+ *
+ * @see csvstream_getnextrecord
+ */
+CSV_STREAM_SIGNAL csv_multi_getnextrecord(csvstream_type streamdata);
+
+/**
+ * @brief Return the record produced by @c csv_multi_getnextrecord
+ *
+ * @see csvstream_saverecordview
+ */
+void csv_multi_saverecordview(csvstream_type   streamdata,
+                              const csvfield **fields,
+                              size_t *         length);
+
+/**
+ * @brief Stop the workers and release the files and buffers
+ *
+ * @see csvstream_close
+ */
+void csv_multi_close(csvstream_type streamdata);
+
+#ifdef CSV_HAVE_PTHREADS
+
+/**
+ * @brief Worker thread, parses the files it claims until stopped
+ */
+void *csv_multi_worker(void *arg);
+
+/**
+ * @brief Parse file @p f into the queue of @p file
+ */
+void csv_multi_parse_file(csvmultireader         mr,
+                          size_t                 f,
+                          struct csv_multi_file *file);
+
+/**
+ * @brief Take the next queued batch of the current file as the active one
+ *
+ * @return @c CSV_GOOD with a batch, @c CSV_EOF once every file has been
+ *         delivered, or @c CSV_ERROR if the current file could not be read
+ */
+CSV_STREAM_SIGNAL csv_multi_next_batch(csvmultireader mr);
+
+/**
+ * @brief Stop the worker threads and wait for them to exit
+ */
+void csv_multi_stop(csvmultireader mr);
+
+#endif /* CSV_HAVE_PTHREADS */
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreader csvreader_multi_init(csvdialect   dialect,
+                               const char **paths,
+                               size_t       npaths,
+                               size_t       nthreads,
+                               bool         skip_headers) {
+  ZF_LOGI("Initiailizing multi-file CSV Reader over `%lu` files with `%lu` "
+          "threads",
+          (long unsigned)npaths,
+          (long unsigned)nthreads);
+  csvreader      reader = NULL;
+  csvmultireader mr     = NULL;
+
+  if ((mr = csv_multi_open(dialect, paths, npaths, nthreads, skip_headers)) ==
+      NULL) {
+    ZF_LOGE("`csvmultireader` could not be allocated");
+    return NULL;
+  }
+
+  reader = csvreader_record_source_init(dialect,
+                                        &csv_multi_getnextrecord,
+                                        &csv_multi_saverecordview,
+                                        (csvstream_type)mr);
+  reader = csvreader_set_closer(reader, &csv_multi_close);
+
+  if (reader == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    csv_multi_close((csvstream_type)mr);
+    return NULL;
+  }
+  return reader;
+}
+
+csvreader csvreader_multi_glob_init(csvdialect  dialect,
+                                    const char *pattern,
+                                    size_t      nthreads,
+                                    bool        skip_headers) {
+  ZF_LOGI("Initiailizing multi-file CSV Reader from pattern `%s`", pattern);
+#ifdef _WIN32
+  (void)dialect;
+  (void)nthreads;
+  (void)skip_headers;
+  ZF_LOGE("file patterns are not supported on this platform");
+  return NULL;
+#else
+  csvreader reader = NULL;
+  glob_t    found;
+
+  if ((pattern == NULL) || (glob(pattern, 0, NULL, &found) != 0)) {
+    ZF_LOGE("no files match `%s`", pattern);
+    return NULL;
+  }
+
+  /* the matches are sorted, the paths are copied */
+  reader = csvreader_multi_init(dialect,
+                                (const char **)found.gl_pathv,
+                                found.gl_pathc,
+                                nthreads,
+                                skip_headers);
+  globfree(&found);
+  return reader;
+#endif
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+csvmultireader csv_multi_open(csvdialect   dialect,
+                              const char **paths,
+                              size_t       npaths,
+                              size_t       nthreads,
+                              bool         skip_headers) {
+  csvmultireader mr     = NULL;
+  size_t         length = 0;
+
+  if ((paths == NULL) && (npaths > 0)) {
+    ZF_LOGD("`csvmultireader` paths cannot be NULL");
+    return NULL;
+  }
+
+  if ((mr = csv_calloc(NULL, 1, sizeof *mr)) == NULL) {
+    ZF_LOGD("`csvmultireader` could not be allocated");
+    return NULL;
+  }
+
+  mr->dialect      = csvdialect_worker_copy(dialect);
+  mr->skip_headers = skip_headers;
+  mr->first        = true;
+  csvbatch_init(&mr->header);
+
+  if ((mr->dialect == NULL) ||
+      ((npaths > 0) &&
+       ((mr->paths = csv_calloc(NULL, npaths, sizeof *mr->paths)) == NULL))) {
+    ZF_LOGD("`csvmultireader` could not be initialized");
+    csv_multi_close((csvstream_type)mr);
+    return NULL;
+  }
+
+  for (; mr->npaths < npaths; ++mr->npaths) {
+    if ((paths[mr->npaths] == NULL) ||
+        ((mr->paths[mr->npaths] = csv_malloc(
+              NULL, (length = strlen(paths[mr->npaths])) + 1)) == NULL)) {
+      ZF_LOGD("path `%lu` could not be copied", (long unsigned)mr->npaths);
+      csv_multi_close((csvstream_type)mr);
+      return NULL;
+    }
+    memcpy(mr->paths[mr->npaths], paths[mr->npaths], length + 1);
+  }
+
+#ifdef CSV_HAVE_PTHREADS
+  /* a single file is not worth the threads */
+  if ((nthreads < 2) || (npaths < 2)) return mr;
+
+  mr->window = nthreads * CSV_MULTI_WINDOW;
+
+  if (((mr->files = csv_calloc(NULL, mr->window, sizeof *mr->files)) == NULL) ||
+      ((mr->threads = csv_calloc(NULL, nthreads, sizeof *mr->threads)) ==
+       NULL)) {
+    ZF_LOGD("`csvmultireader` queues could not be allocated");
+    csv_free(NULL, mr->files);
+    mr->files = NULL;
+    return mr;
+  }
+
+  for (size_t i = 0; i < mr->window; ++i) {
+    for (size_t b = 0; b < CSV_MULTI_QUEUE; ++b) {
+      csvbatch_init(&mr->files[i].batches[b]);
+    }
+  }
+
+  pthread_mutex_init(&mr->lock, NULL);
+  pthread_cond_init(&mr->work, NULL);
+  pthread_cond_init(&mr->done, NULL);
+
+  for (mr->nthreads = 0; mr->nthreads < nthreads; ++mr->nthreads) {
+    if (pthread_create(&mr->threads[mr->nthreads],
+                       NULL,
+                       &csv_multi_worker,
+                       mr) != 0) {
+      ZF_LOGE("worker thread could not be created");
+      break;
+    }
+  }
+
+  ZF_LOGD("`csvmultireader` started `%lu` workers",
+          (long unsigned)mr->nthreads);
+#else
+  (void)nthreads;
+#endif
+  return mr;
+}
+
+bool csv_multi_keep(csvmultireader  mr,
+                    const csvfield *fields,
+                    size_t          length) {
+  bool   first  = mr->first;
+  size_t header = 0;
+
+  mr->first = false;
+
+  if (!mr->skip_headers || !first) return true;
+
+  if (!mr->have_header) {
+    mr->have_header = csvbatch_begin(&mr->header, 1) &&
+                      csvbatch_append(&mr->header, fields, length);
+    return true;
+  }
+
+  /* only a record equal to the first one is a repeated header */
+  if ((header = csvbatch_record_length(&mr->header, 0)) != length) return true;
+
+  for (size_t i = 0; i < length; ++i) {
+    csvfield field = csvbatch_field(&mr->header, 0, i);
+
+    if ((field.len != fields[i].len) ||
+        (memcmp(field.data, fields[i].data, field.len) != 0)) {
+      return true;
+    }
+  }
+
+  ZF_LOGD("repeated header of file `%lu` dropped", (long unsigned)mr->current);
+  return false;
+}
+
+CSV_STREAM_SIGNAL csv_multi_sequential_record(csvmultireader mr) {
+  csvreturn rc;
+
+  while (mr->current < mr->npaths) {
+    if ((mr->sequential == NULL) &&
+        ((mr->sequential = csvreader_mmap_init(
+              mr->dialect, mr->paths[mr->current])) == NULL)) {
+      ZF_LOGE("`%s` could not be read", mr->paths[mr->current]);
+      return CSV_ERROR;
+    }
+
+    rc = csvreader_next_record_view(
+        mr->sequential, &mr->current_fields, &mr->current_length);
+
+    if (csv_success(rc)) {
+      if (csv_multi_keep(mr, mr->current_fields, mr->current_length)) {
+        return CSV_EOR;
+      }
+      continue;
+    }
+
+    if (rc.io_error) return CSV_ERROR;
+
+    csvreader_close(&mr->sequential);
+    mr->current++;
+    mr->first = true;
+  }
+  return CSV_EOF;
+}
+
+CSV_STREAM_SIGNAL csv_multi_getnextrecord(csvstream_type streamdata) {
+  csvmultireader mr     = (csvmultireader)streamdata;
+  csvfield *     view   = NULL;
+  size_t         length = 0;
+
+#ifdef CSV_HAVE_PTHREADS
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+
+  if (mr->nthreads == 0) return csv_multi_sequential_record(mr);
+
+  while (true) {
+    if ((mr->active == NULL) || (mr->record == mr->active->size)) {
+      if ((signal = csv_multi_next_batch(mr)) != CSV_GOOD) return signal;
+    }
+
+    length = csvbatch_record_length(mr->active, mr->record);
+
+    if (length > mr->capacity_v) {
+      if ((view = csv_realloc(NULL, mr->view, sizeof *view * length)) == NULL) {
+        ZF_LOGE("`csvmultireader` view could not be expanded");
+        return CSV_ERROR;
+      }
+      mr->view       = view;
+      mr->capacity_v = length;
+    }
+
+    for (size_t i = 0; i < length; ++i) {
+      mr->view[i] = csvbatch_field(mr->active, mr->record, i);
+    }
+    mr->record++;
+
+    mr->current_fields = mr->view;
+    mr->current_length = length;
+    if (csv_multi_keep(mr, mr->view, length)) return CSV_EOR;
+  }
+#else
+  (void)view;
+  (void)length;
+  return csv_multi_sequential_record(mr);
+#endif
+}
+
+void csv_multi_saverecordview(csvstream_type   streamdata,
+                              const csvfield **fields,
+                              size_t *         length) {
+  csvmultireader mr = (csvmultireader)streamdata;
+
+  *fields = mr->current_fields;
+  *length = mr->current_length;
+}
+
+void csv_multi_close(csvstream_type streamdata) {
+  ZF_LOGI("streamdata is %s", streamdata == NULL ? "NULL" : "NOT NULL");
+
+  if (streamdata == NULL) return;
+
+  csvmultireader mr = (csvmultireader)streamdata;
+
+#ifdef CSV_HAVE_PTHREADS
+  if (mr->files != NULL) {
+    csv_multi_stop(mr);
+
+    pthread_cond_destroy(&mr->done);
+    pthread_cond_destroy(&mr->work);
+    pthread_mutex_destroy(&mr->lock);
+
+    for (size_t i = 0; i < mr->window; ++i) {
+      for (size_t b = 0; b < CSV_MULTI_QUEUE; ++b) {
+        csvbatch_close(&mr->files[i].batches[b]);
+      }
+    }
+  }
+  csv_free(NULL, mr->files);
+  csv_free(NULL, mr->threads);
+#endif
+
+  csvreader_close(&mr->sequential);
+  for (size_t i = 0; i < mr->npaths; ++i) csv_free(NULL, mr->paths[i]);
+  csv_free(NULL, mr->paths);
+  csvbatch_close(&mr->header);
+  csvdialect_close(&mr->dialect);
+  csv_free(NULL, mr->view);
+  csv_free(NULL, mr);
+}
+
+#ifdef CSV_HAVE_PTHREADS
+
+void *csv_multi_worker(void *arg) {
+  csvmultireader         mr   = (csvmultireader)arg;
+  struct csv_multi_file *file = NULL;
+  size_t                 f    = 0;
+
+  pthread_mutex_lock(&mr->lock);
+
+  while (!mr->stop) {
+    /* the slot of file `f - window` is free once the consumer is past it */
+    if ((mr->next_file < mr->npaths) &&
+        (mr->next_file < mr->current + mr->window)) {
+      f    = mr->next_file++;
+      file = &mr->files[f % mr->window];
+
+      file->done     = false;
+      file->failed   = false;
+      file->produced = 0;
+      file->consumed = 0;
+      pthread_mutex_unlock(&mr->lock);
+
+      csv_multi_parse_file(mr, f, file);
+
+      pthread_mutex_lock(&mr->lock);
+      continue;
+    }
+
+    pthread_cond_wait(&mr->work, &mr->lock);
+  }
+
+  pthread_mutex_unlock(&mr->lock);
+  return NULL;
+}
+
+void csv_multi_parse_file(csvmultireader         mr,
+                          size_t                 f,
+                          struct csv_multi_file *file) {
+  csvreader       reader = csvreader_mmap_init(mr->dialect, mr->paths[f]);
+  csvbatch *      batch  = NULL;
+  const csvfield *fields = NULL;
+  size_t          length = 0;
+  bool            ended  = false;
+  bool            failed = (reader == NULL);
+  csvreturn       rc;
+
+  while (!ended && !failed) {
+    pthread_mutex_lock(&mr->lock);
+    while (!mr->stop &&
+           (file->produced - file->consumed == CSV_MULTI_QUEUE)) {
+      pthread_cond_wait(&mr->work, &mr->lock);
+    }
+    batch = &file->batches[file->produced % CSV_MULTI_QUEUE];
+    ended = mr->stop;
+    pthread_mutex_unlock(&mr->lock);
+
+    if (ended) break;
+
+    /* the queue entry is not read by the consumer until it is produced */
+    failed = !csvbatch_begin(batch, CSV_MULTI_BATCH_RECORDS);
+
+    while (!failed && !ended && (batch->size < CSV_MULTI_BATCH_RECORDS)) {
+      rc = csvreader_next_record_view(reader, &fields, &length);
+
+      if (csv_failure(rc)) {
+        ended  = true;
+        failed = rc.io_error;
+        break;
+      }
+
+      failed = !csvbatch_append(batch, fields, length);
+      ended  = rc.io_eof;
+    }
+
+    pthread_mutex_lock(&mr->lock);
+    if (!failed && (batch->size > 0)) file->produced++;
+    pthread_cond_broadcast(&mr->done);
+    pthread_mutex_unlock(&mr->lock);
+  }
+
+  if (failed) ZF_LOGE("`%s` could not be read", mr->paths[f]);
+  csvreader_close(&reader);
+
+  pthread_mutex_lock(&mr->lock);
+  file->failed = failed;
+  file->done   = true;
+  pthread_cond_broadcast(&mr->done);
+  pthread_mutex_unlock(&mr->lock);
+}
+
+CSV_STREAM_SIGNAL csv_multi_next_batch(csvmultireader mr) {
+  struct csv_multi_file *file   = NULL;
+  CSV_STREAM_SIGNAL      signal = CSV_GOOD;
+
+  pthread_mutex_lock(&mr->lock);
+
+  /* the active batch has been delivered, its queue entry is free */
+  if (mr->active != NULL) {
+    mr->files[mr->current % mr->window].consumed++;
+    mr->active = NULL;
+    pthread_cond_broadcast(&mr->work);
+  }
+
+  while (mr->active == NULL) {
+    if (mr->current == mr->npaths) {
+      signal = CSV_EOF;
+      break;
+    }
+
+    file = &mr->files[mr->current % mr->window];
+
+    if (mr->current >= mr->next_file) {
+      pthread_cond_wait(&mr->done, &mr->lock);
+      continue;
+    }
+
+    if (file->consumed < file->produced) {
+      mr->active = &file->batches[file->consumed % CSV_MULTI_QUEUE];
+      mr->record = 0;
+      break;
+    }
+
+    if (!file->done) {
+      pthread_cond_wait(&mr->done, &mr->lock);
+      continue;
+    }
+
+    if (file->failed) {
+      signal = CSV_ERROR;
+      break;
+    }
+
+    /* the file has been delivered, its slot can take another file */
+    mr->current++;
+    mr->first = true;
+    pthread_cond_broadcast(&mr->work);
+  }
+
+  pthread_mutex_unlock(&mr->lock);
+  return signal;
+}
+
+void csv_multi_stop(csvmultireader mr) {
+  pthread_mutex_lock(&mr->lock);
+  mr->stop = true;
+  pthread_cond_broadcast(&mr->work);
+  pthread_mutex_unlock(&mr->lock);
+
+  for (size_t i = 0; i < mr->nthreads; ++i) {
+    pthread_join(mr->threads[i], NULL);
+  }
+  mr->nthreads = 0;
+}
+
+#endif /* CSV_HAVE_PTHREADS */
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,689 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_parallel.c
+ * @author Robert W. Smith
+ * @brief Implementation of the multi-threaded CSV Reader
+ *
+ * Private documentation, API subject to change. The file is memory mapped and
+ * divided into fixed size chunks. Worker threads handle two kinds of work:
+ *
+ * - scanning a chunk, which counts its quote characters and notes the first
+ *   line terminator reached with an even and with an odd number of quote
+ *   characters since the start of the chunk.
+ * - parsing a unit, a range of the file starting and ending on what should be
+ *   record boundaries, into a @c csvbatch.
+ *
+ * Scans are resolved in file order, the parity of all quote characters before
+ * a chunk tells which of its two line terminators is outside of quotes. That
+ * line terminator closes the current unit and opens the next one. A chunk
+ * without a suitable line terminator is absorbed into the open unit.
+ *
+ * The quote parity rule is speculative, it does not understand escape
+ * characters or quotes inside unquoted fields. Each unit therefore verifies
+ * that its parse ended exactly on a record boundary. The first unit which does
+ * not stops the workers, and the remainder of the file from the start of that
+ * unit is parsed sequentially by the consumer. Records are always delivered in
+ * file order.
+ *
+ * A bounded ring of scans and units keeps memory use proportional to the
+ * number of threads rather than the size of the file.
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CSV_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "dialect_private.h"
+#include "read_private.h"
+#include "scan_private.h"
+
+/*
+ * size of the chunks the file is scanned in, units are at least this long
+ */
+#define CSV_PARALLEL_CHUNK_SIZE ((size_t)1 << 22)
+
+/*
+ * scans and units held in flight per worker thread
+ */
+#define CSV_PARALLEL_WINDOW 4
+
+/*
+ * no line terminator found at the requested parity
+ */
+#define CSV_PARALLEL_NONE SIZE_MAX
+
+#ifdef CSV_HAVE_PTHREADS
+
+typedef struct csv_parallel_reader *csvparallelreader;
+
+/**
+ * @brief Parity scan of a single chunk
+ */
+struct csv_parallel_scan {
+  bool   scanned; /**< results are ready to be resolved */
+  bool   odd;     /**< the chunk holds an odd number of quote characters */
+  size_t newline[2]; /**< offset just past the first line terminator reached
+                        with an even (0) or odd (1) number of quote
+                        characters since the start of the chunk */
+};
+
+/**
+ * @brief Progress of a unit of work
+ */
+typedef enum CSV_PARALLEL_UNIT_STATE {
+  UNIT_READY,   /**< range is known, waiting for a worker */
+  UNIT_PARSING, /**< a worker is parsing the range */
+  UNIT_DONE,    /**< records are available to the consumer */
+} CSV_PARALLEL_UNIT_STATE;
+
+/**
+ * @brief Range of the file parsed by a single worker
+ */
+struct csv_parallel_unit {
+  CSV_PARALLEL_UNIT_STATE state;
+  size_t                  start;    /**< offset of the first character */
+  size_t                  end;      /**< offset past the last character */
+  bool                    verified; /**< parse ended on a record boundary */
+  csvbatch                batch;    /**< records parsed from the range */
+};
+
+struct csv_parallel_reader {
+  csvdialect  dialect; /* copied, used by the worker's readers */
+  const char *map;
+  size_t      map_length;
+
+  /* characters the chunk scan stops at */
+  csvscanset               structural;
+  csv_comparison_char_type quotechar;
+
+  size_t chunks; /* number of chunks in the file */
+  size_t window; /* entries in `scans` and `units` */
+
+  /* chunk scans, chunk `c` is held in `scans[c % window]` */
+  struct csv_parallel_scan *scans;
+  size_t                    next_scan;    /* next chunk to scan */
+  size_t                    next_resolve; /* next chunk to resolve */
+  bool                      parity;       /* quote parity before it */
+  size_t                    open_start;   /* start of the open unit */
+
+  /* units, unit `u` is held in `units[u % window]` */
+  struct csv_parallel_unit *units;
+  size_t                    closed;   /* units whose range is known */
+  bool                      resolved; /* every unit has been closed */
+  size_t                    next_parse; /* next unit to hand to a worker */
+  size_t                    consumed;   /* unit being delivered */
+
+  /* unit owned by the consumer until its records are delivered */
+  struct csv_parallel_unit *active;
+  size_t                    record; /* next record of `active` */
+  bool                      stop;
+
+  pthread_mutex_t lock;
+  pthread_cond_t  work; /* signalled when scans or units become available */
+  pthread_cond_t  done; /* signalled when units are closed or parsed */
+  pthread_t *     threads;
+  size_t          nthreads;
+
+  /* one reader per worker, created before the workers are started */
+  csvreader *readers;
+  size_t     nreaders;
+  size_t     claimed; /* readers taken by started workers */
+
+  /* sequential reader used once speculation fails */
+  csvreader fallback;
+
+  /* record handed out by `csv_parallel_saverecordview` */
+  const csvfield *current;
+  size_t          current_length;
+  csvfield *      view;
+  size_t          capacity_v;
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Map the file, create the workers' readers and start the workers
+ *
+ * @return Fully initialized @c csvparallelreader, or NULL on error
+ */
+csvparallelreader csv_parallel_open(csvdialect  dialect,
+                                    const char *filepath,
+                                    size_t      nthreads);
+
+/**
+ * @brief Worker thread, scans chunks and parses units until stopped
+ */
+void *csv_parallel_worker(void *arg);
+
+/**
+ * @brief Count the quote characters and find the candidate line terminators of
+ * chunk @p c
+ */
+void csv_parallel_scan_chunk(csvparallelreader         pr,
+                             size_t                    c,
+                             struct csv_parallel_scan *scan);
+
+/**
+ * @brief Resolve scanned chunks in order, closing units at record boundaries
+ *
+ * Called with the lock held.
+ */
+void csv_parallel_resolve(csvparallelreader pr);
+
+/**
+ * @brief Close the open unit at @p end. Called with the lock held.
+ */
+void csv_parallel_close_unit(csvparallelreader pr, size_t end);
+
+/**
+ * @brief Parse a unit's range into its batch, verifying the boundaries
+ */
+void csv_parallel_parse_unit(csvparallelreader         pr,
+                             csvreader                 reader,
+                             struct csv_parallel_unit *unit);
+
+/**
+ * @brief Stop the worker threads and wait for them to exit
+ */
+void csv_parallel_stop(csvparallelreader pr);
+
+/**
+ * @brief Deliver the next record from the sequential fallback reader
+ */
+CSV_STREAM_SIGNAL csv_parallel_fallback_record(csvparallelreader pr);
+
+/**
+ * @brief Produce the next record in file order
+ *
+ * @see csvstream_getnextrecord
+ */
+CSV_STREAM_SIGNAL csv_parallel_getnextrecord(csvstream_type streamdata);
+
+/**
+ * @brief Return the record produced by @c csv_parallel_getnextrecord
+ *
+ * @see csvstream_saverecordview
+ */
+void csv_parallel_saverecordview(csvstream_type   streamdata,
+                                 const csvfield **fields,
+                                 size_t *         length);
+
+/**
+ * @brief Stop the workers, unmap the file and release the buffers
+ *
+ * @see csvstream_close
+ */
+void csv_parallel_close(csvstream_type streamdata);
+
+/*
+ * end of private forward declarations
+ */
+
+#endif /* CSV_HAVE_PTHREADS */
+
+/*
+ * API implementation
+ */
+csvreader csvreader_parallel_init(csvdialect  dialect,
+                                  const char *filepath,
+                                  size_t      nthreads) {
+  ZF_LOGI("Initiailizing parallel CSV Reader from filepath `%s` with `%lu` "
+          "threads",
+          filepath,
+          (long unsigned)nthreads);
+
+#ifdef CSV_HAVE_PTHREADS
+  csvreader         reader = NULL;
+  csvparallelreader pr     = NULL;
+
+  if (nthreads > 1) {
+    if ((pr = csv_parallel_open(dialect, filepath, nthreads)) == NULL) {
+      ZF_LOGE("`csvparallelreader` could not be allocated");
+      return NULL;
+    }
+
+    reader = csvreader_record_source_init(dialect,
+                                          &csv_parallel_getnextrecord,
+                                          &csv_parallel_saverecordview,
+                                          (csvstream_type)pr);
+    reader = csvreader_set_closer(reader, &csv_parallel_close);
+
+    if (reader == NULL) {
+      ZF_LOGE("`csvreader` could not be allocated");
+      csv_parallel_close((csvstream_type)pr);
+      return NULL;
+    }
+    return reader;
+  }
+#endif
+
+  ZF_LOGI("single threaded, using the memory mapped reader");
+  return csvreader_mmap_init(dialect, filepath);
+}
+
+#ifdef CSV_HAVE_PTHREADS
+
+/*
+ * private implementations
+ */
+csvparallelreader csv_parallel_open(csvdialect  dialect,
+                                    const char *filepath,
+                                    size_t      nthreads) {
+  csvparallelreader        pr = NULL;
+  csv_comparison_char_type structural[3];
+
+  if (filepath == NULL) {
+    ZF_LOGD("`csvparallelreader` filepath cannot be a NULL string");
+    return NULL;
+  }
+
+  if ((pr = csv_calloc(NULL, 1, sizeof *pr)) == NULL) {
+    ZF_LOGD("`csvparallelreader` could not be allocated");
+    return NULL;
+  }
+
+  pr->dialect = csvdialect_worker_copy(dialect);
+  pr->window  = nthreads * CSV_PARALLEL_WINDOW;
+
+  if ((pr->dialect == NULL) ||
+      !csv_mmap_map(filepath, &pr->map, &pr->map_length) ||
+      ((pr->scans = csv_calloc(NULL, pr->window, sizeof *pr->scans)) == NULL) ||
+      ((pr->units = csv_calloc(NULL, pr->window, sizeof *pr->units)) == NULL) ||
+      ((pr->threads = csv_calloc(NULL, nthreads, sizeof *pr->threads)) ==
+       NULL)) {
+    ZF_LOGD("`csvparallelreader` could not be initialized");
+    csvdialect_close(&pr->dialect);
+    csv_mmap_unmap(pr->map, pr->map_length);
+    csv_free(NULL, pr->scans);
+    csv_free(NULL, pr->units);
+    csv_free(NULL, pr);
+    return NULL;
+  }
+
+  for (size_t i = 0; i < pr->window; ++i) csvbatch_init(&pr->units[i].batch);
+
+  pr->quotechar =
+      (csvdialect_get_quotestyle(pr->dialect) != QUOTE_STYLE_NONE)
+          ? csvdialect_get_quotechar(pr->dialect)
+          : CSV_UNDEFINED_CHAR;
+  structural[0] = pr->quotechar;
+  structural[1] = '\n';
+  structural[2] = '\r';
+  csvscanset_init(&pr->structural, structural, 3);
+
+  pr->chunks =
+      (pr->map_length + CSV_PARALLEL_CHUNK_SIZE - 1) / CSV_PARALLEL_CHUNK_SIZE;
+
+  pthread_mutex_init(&pr->lock, NULL);
+  pthread_cond_init(&pr->work, NULL);
+  pthread_cond_init(&pr->done, NULL);
+
+  /* a file of a single chunk is not worth the threads */
+  if (pr->chunks < 2) nthreads = 0;
+
+  /* a worker without a reader could never finish its units */
+  if ((nthreads > 0) &&
+      ((pr->readers = csv_calloc(NULL, nthreads, sizeof *pr->readers)) ==
+       NULL)) {
+    ZF_LOGE("worker readers could not be allocated");
+    csv_parallel_close((csvstream_type)pr);
+    return NULL;
+  }
+
+  for (pr->nreaders = 0; pr->nreaders < nthreads; ++pr->nreaders) {
+    if ((pr->readers[pr->nreaders] =
+             csvreader_memory_init(pr->dialect, NULL, 0)) == NULL) {
+      ZF_LOGE("worker reader could not be created");
+      csv_parallel_close((csvstream_type)pr);
+      return NULL;
+    }
+  }
+
+  for (pr->nthreads = 0; pr->nthreads < nthreads; ++pr->nthreads) {
+    if (pthread_create(&pr->threads[pr->nthreads],
+                       NULL,
+                       &csv_parallel_worker,
+                       pr) != 0) {
+      ZF_LOGE("worker thread could not be created");
+      break;
+    }
+  }
+
+  /* without workers the consumer parses the whole file itself */
+  if (pr->nthreads == 0) {
+    pr->fallback = csvreader_memory_init(pr->dialect, pr->map, pr->map_length);
+
+    if (pr->fallback == NULL) {
+      csv_parallel_close((csvstream_type)pr);
+      return NULL;
+    }
+  }
+
+  ZF_LOGD("`csvparallelreader` mapped `%lu` bytes in `%lu` chunks",
+          (long unsigned)pr->map_length,
+          (long unsigned)pr->chunks);
+  return pr;
+}
+
+void *csv_parallel_worker(void *arg) {
+  csvparallelreader         pr     = (csvparallelreader)arg;
+  csvreader                 reader = NULL;
+  struct csv_parallel_unit *unit   = NULL;
+  struct csv_parallel_scan  scan;
+  size_t                    chunk = 0;
+
+  pthread_mutex_lock(&pr->lock);
+  reader = pr->readers[pr->claimed++];
+
+  while (!pr->stop) {
+    if (pr->next_parse < pr->closed) {
+      unit        = &pr->units[pr->next_parse++ % pr->window];
+      unit->state = UNIT_PARSING;
+      pthread_mutex_unlock(&pr->lock);
+
+      csv_parallel_parse_unit(pr, reader, unit);
+
+      pthread_mutex_lock(&pr->lock);
+      unit->state = UNIT_DONE;
+      pthread_cond_broadcast(&pr->done);
+      continue;
+    }
+
+    if ((pr->next_scan < pr->chunks) &&
+        (pr->next_scan < (pr->next_resolve + pr->window))) {
+      chunk = pr->next_scan++;
+      pthread_mutex_unlock(&pr->lock);
+
+      csv_parallel_scan_chunk(pr, chunk, &scan);
+
+      pthread_mutex_lock(&pr->lock);
+      pr->scans[chunk % pr->window] = scan;
+      csv_parallel_resolve(pr);
+      continue;
+    }
+
+    pthread_cond_wait(&pr->work, &pr->lock);
+  }
+
+  pthread_mutex_unlock(&pr->lock);
+  return NULL;
+}
+
+void csv_parallel_scan_chunk(csvparallelreader         pr,
+                             size_t                    c,
+                             struct csv_parallel_scan *scan) {
+  const char *data   = pr->map + (c * CSV_PARALLEL_CHUNK_SIZE);
+  size_t      length = pr->map_length - (c * CSV_PARALLEL_CHUNK_SIZE);
+  size_t      i      = 0;
+
+  if (length > CSV_PARALLEL_CHUNK_SIZE) length = CSV_PARALLEL_CHUNK_SIZE;
+
+  scan->scanned    = true;
+  scan->odd        = false;
+  scan->newline[0] = CSV_PARALLEL_NONE;
+  scan->newline[1] = CSV_PARALLEL_NONE;
+
+  while ((i += csvscanset_find(&pr->structural, data + i, length - i)) <
+         length) {
+    if ((unsigned char)data[i] == pr->quotechar) {
+      scan->odd = !scan->odd;
+    } else if (scan->newline[scan->odd] == CSV_PARALLEL_NONE) {
+      scan->newline[scan->odd] = i + 1;
+
+      /* without quoting the parity never changes */
+      if (pr->quotechar == CSV_UNDEFINED_CHAR) return;
+    }
+    ++i;
+  }
+}
+
+void csv_parallel_resolve(csvparallelreader pr) {
+  struct csv_parallel_scan *scan = NULL;
+  size_t                    newline;
+
+  while ((pr->next_resolve < pr->chunks) &&
+         (pr->closed - pr->consumed < pr->window)) {
+    scan = &pr->scans[pr->next_resolve % pr->window];
+
+    if (!scan->scanned) return;
+
+    newline = scan->newline[pr->parity];
+
+    if ((pr->next_resolve > 0) && (newline != CSV_PARALLEL_NONE)) {
+      csv_parallel_close_unit(
+          pr, (pr->next_resolve * CSV_PARALLEL_CHUNK_SIZE) + newline);
+    }
+
+    pr->parity ^= scan->odd;
+    scan->scanned = false;
+    pr->next_resolve++;
+
+    /* the scan slot is free again */
+    pthread_cond_broadcast(&pr->work);
+  }
+
+  if ((pr->next_resolve == pr->chunks) && !pr->resolved &&
+      (pr->closed - pr->consumed < pr->window)) {
+    csv_parallel_close_unit(pr, pr->map_length);
+    pr->resolved = true;
+    pthread_cond_broadcast(&pr->done);
+  }
+}
+
+void csv_parallel_close_unit(csvparallelreader pr, size_t end) {
+  struct csv_parallel_unit *unit = &pr->units[pr->closed++ % pr->window];
+
+  ZF_LOGD("unit closed over [`%lu`, `%lu`)",
+          (long unsigned)pr->open_start,
+          (long unsigned)end);
+
+  unit->state    = UNIT_READY;
+  unit->start    = pr->open_start;
+  unit->end      = end;
+  unit->verified = false;
+  pr->open_start = end;
+
+  pthread_cond_broadcast(&pr->work);
+  pthread_cond_broadcast(&pr->done);
+}
+
+void csv_parallel_parse_unit(csvparallelreader         pr,
+                             csvreader                 reader,
+                             struct csv_parallel_unit *unit) {
+  const csvfield *fields = NULL;
+  size_t          length = 0;
+  csvreturn       rc;
+
+  csvreader_memory_reset(
+      reader, pr->map + unit->start, unit->end - unit->start);
+  unit->verified = csvbatch_begin(&unit->batch, 1024);
+
+  while (unit->verified) {
+    rc = csvreader_next_record_view(reader, &fields, &length);
+
+    if (csv_failure(rc)) {
+      /* a clean end of input is only reached on a record boundary */
+      unit->verified = rc.io_eof && !rc.io_error;
+      break;
+    }
+
+    if (rc.io_eof && (unit->end != pr->map_length)) {
+      ZF_LOGD("unit at `%lu` ended inside a record",
+              (long unsigned)unit->start);
+      unit->verified = false;
+      break;
+    }
+
+    unit->verified = csvbatch_append(&unit->batch, fields, length);
+  }
+}
+
+void csv_parallel_stop(csvparallelreader pr) {
+  pthread_mutex_lock(&pr->lock);
+  pr->stop = true;
+  pthread_cond_broadcast(&pr->work);
+  pthread_mutex_unlock(&pr->lock);
+
+  for (size_t i = 0; i < pr->nthreads; ++i) {
+    pthread_join(pr->threads[i], NULL);
+  }
+  pr->nthreads = 0;
+}
+
+CSV_STREAM_SIGNAL csv_parallel_fallback_record(csvparallelreader pr) {
+  csvreturn rc = csvreader_next_record_view(
+      pr->fallback, &pr->current, &pr->current_length);
+
+  if (csv_success(rc)) return CSV_EOR;
+
+  return rc.io_error ? CSV_ERROR : CSV_EOF;
+}
+
+CSV_STREAM_SIGNAL csv_parallel_getnextrecord(csvstream_type streamdata) {
+  csvparallelreader         pr     = (csvparallelreader)streamdata;
+  struct csv_parallel_unit *unit   = pr->active;
+  csvfield *                view   = NULL;
+  size_t                    record = 0;
+  size_t                    length = 0;
+
+  if (pr->fallback != NULL) return csv_parallel_fallback_record(pr);
+
+  if ((unit == NULL) || (pr->record == unit->batch.size)) {
+    pthread_mutex_lock(&pr->lock);
+
+    /* active unit exhausted, release its slot */
+    if (unit != NULL) {
+      pr->active = NULL;
+      pr->consumed++;
+      csv_parallel_resolve(pr);
+      pthread_cond_broadcast(&pr->work);
+    }
+
+    while ((unit = pr->active) == NULL) {
+      if (pr->consumed == pr->closed) {
+        if (pr->resolved) break;
+
+        pthread_cond_wait(&pr->done, &pr->lock);
+        continue;
+      }
+
+      unit = &pr->units[pr->consumed % pr->window];
+
+      if (unit->state != UNIT_DONE) {
+        pthread_cond_wait(&pr->done, &pr->lock);
+        continue;
+      }
+
+      if (!unit->verified) {
+        ZF_LOGI("speculation failed at `%lu`, continuing sequentially",
+                (long unsigned)unit->start);
+        pthread_mutex_unlock(&pr->lock);
+        csv_parallel_stop(pr);
+
+        pr->fallback = csvreader_memory_init(
+            pr->dialect, pr->map + unit->start, pr->map_length - unit->start);
+
+        if (pr->fallback == NULL) return CSV_ERROR;
+        return csv_parallel_fallback_record(pr);
+      }
+
+      if (unit->batch.size > 0) {
+        pr->active = unit;
+        pr->record = 0;
+        break;
+      }
+
+      /* unit held no records, release its slot */
+      pr->consumed++;
+      csv_parallel_resolve(pr);
+      pthread_cond_broadcast(&pr->work);
+    }
+
+    pthread_mutex_unlock(&pr->lock);
+
+    if (unit == NULL) return CSV_EOF;
+  }
+
+  record = pr->record++;
+  length = csvbatch_record_length(&unit->batch, record);
+
+  if (length > pr->capacity_v) {
+    if ((view = csv_realloc(NULL, pr->view, sizeof *view * length)) == NULL) {
+      ZF_LOGE("`csvparallelreader` view could not be expanded");
+      return CSV_ERROR;
+    }
+    pr->view       = view;
+    pr->capacity_v = length;
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    pr->view[i] = csvbatch_field(&unit->batch, record, i);
+  }
+
+  pr->current        = pr->view;
+  pr->current_length = length;
+  return CSV_EOR;
+}
+
+void csv_parallel_saverecordview(csvstream_type   streamdata,
+                                 const csvfield **fields,
+                                 size_t *         length) {
+  csvparallelreader pr = (csvparallelreader)streamdata;
+
+  *fields = pr->current;
+  *length = pr->current_length;
+}
+
+void csv_parallel_close(csvstream_type streamdata) {
+  ZF_LOGI("streamdata is %s", streamdata == NULL ? "NULL" : "NOT NULL");
+
+  if (streamdata == NULL) return;
+
+  csvparallelreader pr = (csvparallelreader)streamdata;
+
+  csv_parallel_stop(pr);
+  csvreader_close(&pr->fallback);
+
+  for (size_t i = 0; i < pr->nreaders; ++i) {
+    csvreader_close(&pr->readers[i]);
+  }
+
+  pthread_cond_destroy(&pr->done);
+  pthread_cond_destroy(&pr->work);
+  pthread_mutex_destroy(&pr->lock);
+
+  for (size_t i = 0; i < pr->window; ++i) csvbatch_close(&pr->units[i].batch);
+
+  csv_mmap_unmap(pr->map, pr->map_length);
+  csvdialect_close(&pr->dialect);
+  csv_free(NULL, pr->threads);
+  csv_free(NULL, pr->readers);
+  csv_free(NULL, pr->scans);
+  csv_free(NULL, pr->units);
+  csv_free(NULL, pr->view);
+  csv_free(NULL, pr);
+}
+
+#endif /* CSV_HAVE_PTHREADS */
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,190 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_parser.c
+ * @author Robert W. Smith
+ * @brief Implementation of the CSV Push Parser
+ *
+ * Private documentation, API subject to change. The parser wraps a reader
+ * made by @c csvreader_source_init, whose block source hands out the chunk
+ * being fed once and then answers @c CSV_AGAIN, which pauses the reader with
+ * its state intact. The reader copies partial fields into its own buffers, so
+ * nothing refers to a chunk once it has been fed.
+ *
+ * @see csv/parser.h
+ * @see read_private.h
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+struct csv_parser {
+  csvreader reader;
+
+  const char *chunk;    /* input fed and not yet handed to the reader */
+  size_t      length;   /* characters in `chunk` */
+  bool        finished; /* `csvparser_finish` was called */
+
+  csvparser_field_callback  on_field;
+  csvparser_record_callback on_record;
+  void *                    context;
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Hand the chunk being fed to the reader once
+ *
+ * @return @c CSV_GOOD with the chunk, then @c CSV_AGAIN until more is fed,
+ *         or @c CSV_EOF once the parser is finished
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csv_parser_getnextblock(csvstream_type streamdata,
+                                          const char **  block,
+                                          size_t *       length);
+
+/**
+ * @brief Pass every record the reader can complete to the callbacks
+ *
+ * @return success once the reader runs out of input, with @c io_eof set if
+ *         the input has ended
+ */
+csvreturn csv_parser_drain(csvparser parser);
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvparser csvparser_init(csvdialect                dialect,
+                         csvparser_field_callback  on_field,
+                         csvparser_record_callback on_record,
+                         void *                    context) {
+  ZF_LOGI("CSV Push Parser Initializer called");
+  csvparser parser = NULL;
+
+  if ((parser = csv_calloc(NULL, 1, sizeof *parser)) == NULL) {
+    ZF_LOGE("`csvparser` could not be allocated");
+    return NULL;
+  }
+
+  parser->on_field  = on_field;
+  parser->on_record = on_record;
+  parser->context   = context;
+
+  /* the parser owns itself, the reader has nothing to release */
+  if ((parser->reader = csvreader_source_init(dialect,
+                                              &csv_parser_getnextblock,
+                                              NULL,
+                                              NULL,
+                                              (csvstream_type)parser)) ==
+      NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    csv_free(NULL, parser);
+    return NULL;
+  }
+  return parser;
+}
+
+csvreturn csvparser_feed(csvparser parser, const char *bytes, size_t len) {
+  ZF_LOGI("called parser: `%p` length: `%lu`",
+          (void *)parser,
+          (long unsigned)len);
+
+  if ((parser == NULL) || parser->finished || ((bytes == NULL) && (len > 0))) {
+    ZF_LOGE("`csvparser` cannot be fed");
+    return csvreturn_init(false);
+  }
+
+  parser->chunk  = bytes;
+  parser->length = len;
+  return csv_parser_drain(parser);
+}
+
+csvreturn csvparser_finish(csvparser parser) {
+  ZF_LOGI("called parser: `%p`", (void *)parser);
+
+  if ((parser == NULL) || parser->finished) {
+    ZF_LOGE("`csvparser` is already finished");
+    return csvreturn_init(false);
+  }
+
+  parser->finished = true;
+  return csv_parser_drain(parser);
+}
+
+void csvparser_close(csvparser *parser) {
+  if ((parser == NULL) || (*parser == NULL)) return;
+
+  csvreader_close(&(*parser)->reader);
+  csv_free(NULL, *parser);
+  *parser = NULL;
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+CSV_STREAM_SIGNAL csv_parser_getnextblock(csvstream_type streamdata,
+                                          const char **  block,
+                                          size_t *       length) {
+  csvparser parser = (csvparser)streamdata;
+
+  *block  = NULL;
+  *length = 0;
+
+  if (parser->length > 0) {
+    *block         = parser->chunk;
+    *length        = parser->length;
+    parser->chunk  = NULL;
+    parser->length = 0;
+    return CSV_GOOD;
+  }
+  return parser->finished ? CSV_EOF : CSV_AGAIN;
+}
+
+csvreturn csv_parser_drain(csvparser parser) {
+  const csvfield *fields = NULL;
+  size_t          length = 0;
+  csvreturn       rc;
+
+  while (true) {
+    rc = csvreader_next_record_view(parser->reader, &fields, &length);
+
+    if (csv_failure(rc)) break;
+
+    for (size_t i = 0; (parser->on_field != NULL) && (i < length); ++i) {
+      (*parser->on_field)(parser->context, &fields[i], i);
+    }
+
+    if (parser->on_record != NULL) {
+      (*parser->on_record)(parser->context, fields, length);
+    }
+
+    if (rc.io_eof) break;
+  }
+
+  /* running out of input is how a feed ends */
+  if (rc.io_again || rc.io_eof) {
+    rc.succeeded = 1;
+    rc.io_again  = 0;
+  }
+  return rc;
+}
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,308 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_pipeline.c
+ * @author Robert W. Smith
+ * @brief Implementation of the block pipeline feeding a CSV Reader
+ *
+ * Private documentation, API subject to change. A producer thread fills a
+ * bounded ring of blocks while the parser works through the blocks already
+ * filled, so producing the input, for instance inflating it, overlaps with
+ * parsing it. The block handed to the parser is held until the parser asks
+ * for the next one, the producer never writes to it.
+ *
+ * Without thread support, or when the producer thread cannot be created, the
+ * fill callback is called for each block as the parser requests it.
+ *
+ * @see read_private.h
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifdef CSV_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+struct csv_pipeline {
+  csvpipeline_fill fill;
+  csvstream_close  closer;
+  csvstream_close  wake;
+  csvstream_type   context;
+
+  /* block `b` is held in `buffers[b % blocks]` */
+  char ** buffers;
+  size_t *lengths;
+  size_t  blocks;
+  size_t  block_size;
+
+  size_t            produced; /* blocks filled */
+  size_t            consumed; /* blocks released by the parser */
+  bool              held;     /* the parser holds block `consumed` */
+  bool              done;     /* the producer has stopped */
+  bool              stop;     /* the producer has been asked to stop */
+  CSV_STREAM_SIGNAL status;   /* how the input ended */
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_t       thread;
+  bool            started;
+  pthread_mutex_t lock;
+  pthread_cond_t  filled; /* signalled when a block is filled or on `done` */
+  pthread_cond_t  freed;  /* signalled when a block is released or `stop` */
+#endif
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Fill the next block on the parser's thread, without a producer
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csv_pipeline_fill_next(csvpipeline  pl,
+                                         const char **block,
+                                         size_t *     length);
+
+#ifdef CSV_HAVE_PTHREADS
+/**
+ * @brief Take the next block filled by the producer thread
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csv_pipeline_take_next(csvpipeline  pl,
+                                         const char **block,
+                                         size_t *     length);
+
+/**
+ * @brief Producer thread, fills free blocks until the input is exhausted
+ */
+void *csv_pipeline_produce(void *arg);
+#endif
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * private implementations, see 'read_private.h'
+ */
+csvpipeline csvpipeline_init(csvpipeline_fill fill,
+                             csvstream_close  closer,
+                             csvstream_close  wake,
+                             csvstream_type   context,
+                             size_t           blocks,
+                             size_t           block_size) {
+  ZF_LOGI("pipeline of `%lu` blocks of `%lu` characters",
+          (long unsigned)blocks,
+          (long unsigned)block_size);
+  csvpipeline pl = NULL;
+
+  if ((fill == NULL) || (blocks < 2) || (block_size == 0) ||
+      ((pl = csv_calloc(NULL, 1, sizeof *pl)) == NULL)) {
+    ZF_LOGE("`csvpipeline` could not be allocated");
+    if (closer != NULL) (*closer)(context);
+    return NULL;
+  }
+
+  pl->fill       = fill;
+  pl->closer     = closer;
+  pl->wake       = wake;
+  pl->context    = context;
+  pl->blocks     = blocks;
+  pl->block_size = block_size;
+  pl->status     = CSV_EOF;
+
+#ifdef CSV_HAVE_PTHREADS
+  pthread_mutex_init(&pl->lock, NULL);
+  pthread_cond_init(&pl->filled, NULL);
+  pthread_cond_init(&pl->freed, NULL);
+#endif
+
+  if (((pl->buffers = csv_calloc(NULL, blocks, sizeof *pl->buffers)) == NULL) ||
+      ((pl->lengths = csv_calloc(NULL, blocks, sizeof *pl->lengths)) == NULL)) {
+    ZF_LOGE("`csvpipeline` ring could not be allocated");
+    csvpipeline_close((csvstream_type)pl);
+    return NULL;
+  }
+
+  for (size_t b = 0; b < blocks; ++b) {
+    if ((pl->buffers[b] = csv_malloc(NULL, block_size)) == NULL) {
+      ZF_LOGE("`csvpipeline` block could not be allocated");
+      csvpipeline_close((csvstream_type)pl);
+      return NULL;
+    }
+  }
+
+#ifdef CSV_HAVE_PTHREADS
+  /* without a producer the blocks are filled on demand, as without threads */
+  if (pthread_create(&pl->thread, NULL, &csv_pipeline_produce, pl) != 0) {
+    ZF_LOGW("`csvpipeline` producer could not be started, filling on demand");
+    return pl;
+  }
+  pl->started = true;
+#endif
+
+  return pl;
+}
+
+CSV_STREAM_SIGNAL csvpipeline_getnextblock(csvstream_type pipeline,
+                                           const char **  block,
+                                           size_t *       length) {
+  csvpipeline       pl     = (csvpipeline)pipeline;
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+
+  *block  = NULL;
+  *length = 0;
+
+#ifdef CSV_HAVE_PTHREADS
+  if (pl->started) {
+    signal = csv_pipeline_take_next(pl, block, length);
+  } else {
+    signal = csv_pipeline_fill_next(pl, block, length);
+  }
+#else
+  signal = csv_pipeline_fill_next(pl, block, length);
+#endif
+
+  ZF_LOGD("block length: `%lu` CSV_STREAM_SIGNAL: `%d`",
+          (long unsigned)*length,
+          (int)signal);
+  return signal;
+}
+
+void csvpipeline_close(csvstream_type pipeline) {
+  csvpipeline pl = (csvpipeline)pipeline;
+
+  if (pl == NULL) return;
+
+#ifdef CSV_HAVE_PTHREADS
+  if (pl->started) {
+    pthread_mutex_lock(&pl->lock);
+    pl->stop = true;
+    pthread_cond_signal(&pl->freed);
+    pthread_mutex_unlock(&pl->lock);
+
+    /* the producer may be blocked in `fill` waiting for input */
+    if (pl->wake != NULL) (*pl->wake)(pl->context);
+    pthread_join(pl->thread, NULL);
+  }
+
+  pthread_cond_destroy(&pl->freed);
+  pthread_cond_destroy(&pl->filled);
+  pthread_mutex_destroy(&pl->lock);
+#endif
+
+  if (pl->closer != NULL) (*pl->closer)(pl->context);
+
+  for (size_t b = 0; (pl->buffers != NULL) && (b < pl->blocks); ++b) {
+    csv_free(NULL, pl->buffers[b]);
+  }
+  csv_free(NULL, pl->buffers);
+  csv_free(NULL, pl->lengths);
+  csv_free(NULL, pl);
+}
+
+CSV_STREAM_SIGNAL csv_pipeline_fill_next(csvpipeline  pl,
+                                         const char **block,
+                                         size_t *     length) {
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+
+  if (pl->done) return pl->status;
+
+  if ((signal = (*pl->fill)(
+           pl->context, pl->buffers[0], pl->block_size, length)) == CSV_GOOD) {
+    *block = pl->buffers[0];
+  } else {
+    pl->done   = true;
+    pl->status = signal;
+    *length    = 0;
+  }
+  return signal;
+}
+
+#ifdef CSV_HAVE_PTHREADS
+CSV_STREAM_SIGNAL csv_pipeline_take_next(csvpipeline  pl,
+                                         const char **block,
+                                         size_t *     length) {
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+  size_t            slot   = 0;
+
+  pthread_mutex_lock(&pl->lock);
+
+  if (pl->held) {
+    pl->held = false;
+    pl->consumed++;
+    pthread_cond_signal(&pl->freed);
+  }
+
+  while ((pl->produced == pl->consumed) && !pl->done) {
+    pthread_cond_wait(&pl->filled, &pl->lock);
+  }
+
+  if (pl->produced > pl->consumed) {
+    slot     = pl->consumed % pl->blocks;
+    *block   = pl->buffers[slot];
+    *length  = pl->lengths[slot];
+    pl->held = true;
+  } else {
+    signal = pl->status;
+  }
+
+  pthread_mutex_unlock(&pl->lock);
+  return signal;
+}
+
+void *csv_pipeline_produce(void *arg) {
+  csvpipeline       pl     = (csvpipeline)arg;
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+  size_t            slot   = 0;
+  size_t            length = 0;
+
+  pthread_mutex_lock(&pl->lock);
+
+  while (!pl->stop) {
+    if (pl->produced - pl->consumed == pl->blocks) {
+      pthread_cond_wait(&pl->freed, &pl->lock);
+      continue;
+    }
+
+    /* the slot is neither held nor filled, it is written unlocked */
+    slot = pl->produced % pl->blocks;
+    pthread_mutex_unlock(&pl->lock);
+
+    signal = (*pl->fill)(
+        pl->context, pl->buffers[slot], pl->block_size, &length);
+
+    pthread_mutex_lock(&pl->lock);
+
+    if (signal != CSV_GOOD) {
+      pl->status = signal;
+      break;
+    }
+
+    pl->lengths[slot] = length;
+    pl->produced++;
+    pthread_cond_signal(&pl->filled);
+  }
+
+  pl->done = true;
+  pthread_cond_signal(&pl->filled);
+  pthread_mutex_unlock(&pl->lock);
+  return NULL;
+}
+#endif /* CSV_HAVE_PTHREADS */
+
+/**
+ * @endcond
+ */
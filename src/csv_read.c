@@ -24,12 +24,18 @@
 #define __STDC_WANT_LIB_EXT1__ 1
 #endif
 
+#include <limits.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "csv.h"
+#include "alloc_private.h"
+#include "dialect_private.h"
+#include "read_private.h"
+#include "scan_private.h"
 
 // #include "csv/definitions.h"
 // #include "csv/version.h"
@@ -99,8 +105,52 @@ const char *csv_reader_parser_state(CSV_READER_PARSER_STATE state) {
     case EAT_CRNL: return "EAT_CRNL";
     case AFTER_ESCAPED_CRNL: return "AFTER_ESCAPED_CRNL";
   }
+  return "";
 }
 
+/**
+ * @brief Number of @c CSV_READER_PARSER_STATE values
+ */
+#define CSV_READER_PARSER_STATE_COUNT (AFTER_ESCAPED_CRNL + 1)
+
+/**
+ * @brief Character classes of the parser's transition table
+ *
+ * Every input character maps to exactly one class, the characters in a class
+ * are treated identically by the parser in every state.
+ */
+typedef enum CSV_READER_CHAR_CLASS {
+  CLASS_OTHER,        /**< Ordinary field character */
+  CLASS_SPACE,        /**< Space, when the dialect skips initial spaces */
+  CLASS_DELIMITER,    /**< Dialect delimiter */
+  CLASS_ESCAPE,       /**< Dialect escape character */
+  CLASS_QUOTE,        /**< Dialect quote character, unless quoting is off */
+  CLASS_QUOTE_ESCAPE, /**< Quote character which is also the escape
+                         character */
+  CLASS_NEWLINE,      /**< Carriage Return or New Line */
+  CLASS_NUL,          /**< NULL byte, which is never valid input */
+  CLASS_COUNT,        /**< Number of character classes */
+} CSV_READER_CHAR_CLASS;
+
+/**
+ * @brief Side effects of a parser transition, combined as flags
+ */
+typedef enum CSV_READER_PARSER_ACTION {
+  ACTION_NONE       = 0,      /**< Only the parser state changes */
+  ACTION_APPEND     = 1 << 0, /**< Append the character to the field */
+  ACTION_SAVE_FIELD = 1 << 1, /**< Save the current field to the record */
+  ACTION_END_RECORD = 1 << 2, /**< The current record is complete */
+  ACTION_ERROR      = 1 << 3, /**< The character is invalid input */
+} CSV_READER_PARSER_ACTION;
+
+/**
+ * @brief Entry of the parser's transition table
+ */
+typedef struct csv_reader_transition {
+  unsigned char state;   /**< @c CSV_READER_PARSER_STATE after the character */
+  unsigned char actions; /**< @c CSV_READER_PARSER_ACTION flags */
+} csvtransition;
+
 /**
  * @brief Implementation of the CSV Reader.
  *
@@ -128,16 +178,66 @@ struct csv_reader {
                                 See description above */
   csvstream_getnextchar getnextchar; /**< Callback which supplies the next
                                         character in the stream */
+  csvstream_getnextblock getnextblock; /**< Callback which supplies the next
+                                          block of characters in the stream,
+                                          used in place of @p getnextchar when
+                                          not @c NULL */
+  csvstream_getnextrecord getnextrecord; /**< Callback which supplies already
+                                            parsed records, used in place of
+                                            the parser when not @c NULL */
   csvstream_appendfield appendchar;  /**< Callback which appends the supplied
                       character to the end  of the current field buffer */
+  csvstream_appendslice appendslice; /**< Optional callback which appends a run
+                                        of characters from the current block to
+                                        the end of the current field buffer */
   csvstream_savefield savefield; /**< Callback which finalizes the current field
                     and appends the string to the end of the record array */
   csvstream_saverecord saverecord; /**< Callback which finalizes the record and
                                       prepares it to return to the caller */
+  csvstream_saverecordview saverecordview; /**< Optional callback which
+                                              finalizes the record as views
+                                              owned by @p streamdata */
   csvstream_close closer; /**< Optional callback which releases the resources
                              held by @p streamdata */
   CSV_READER_PARSER_STATE parser_state; /**< Holds the parser state, which
                                            controls the parser algorithm */
+  const char *block; /**< Current block supplied by @p getnextblock, owned by
+                        @p streamdata */
+  size_t block_length;   /**< Number of characters in @p block */
+  size_t block_position; /**< Index of the next unparsed character in
+                            @p block */
+  unsigned char classes[256]; /**< @c CSV_READER_CHAR_CLASS of every
+                                 character, compiled from @p dialect */
+  csvtransition transitions[CSV_READER_PARSER_STATE_COUNT]
+                           [CLASS_COUNT]; /**< Parser transition for each state
+                                             and character class, compiled
+                                             from @p dialect */
+  csvscanset field_stops;  /**< Characters which end a run in @c IN_FIELD */
+  csvscanset quoted_stops; /**< Characters which end a run in
+                              @c IN_QUOTED_FIELD */
+  csvscanset field_starts; /**< Characters which cannot begin a run of
+                              ordinary characters in a new field */
+  bool * projection; /**< Whether each column is kept, @c NULL to keep every
+                        column */
+  size_t projection_length; /**< Number of entries in @p projection */
+  size_t field_index;       /**< Column of the field being parsed */
+  bool   keep_field; /**< Whether the field being parsed is passed to the
+                        callbacks */
+  csvreader_filter filter; /**< Optional predicate which drops records before
+                              they are returned */
+  void *           filter_context; /**< Passed to @p filter */
+  const csvfield * view;        /**< Record view taken for @p filter */
+  size_t           view_length; /**< Number of fields in @p view */
+  bool             view_saved;  /**< @p view holds the current record */
+  csvstream_seek   seek;  /**< Optional callback which positions the stream */
+  csvindex *       index; /**< Optional record offset index */
+  uint64_t block_offset;  /**< Offset of @p block within the input */
+  uint64_t record_offset; /**< Offset of the first character after the last
+                             complete record */
+  CSV_READER_PARSER_STATE record_state; /**< Parser state at
+                                           @p record_offset */
+  csvallocator allocator; /**< Allocates the reader and the records it
+                             returns, taken from the dialect */
 };
 
 /**
@@ -154,9 +254,11 @@ typedef struct csv_file_reader *csvfilereader;
  * This function initializes the @c csvfilereader state to NULL on the stream
  * and filepath values, and a default allocated field buffer and record buffer.
  *
+ * @param[in] allocator allocator of the buffers
+ *
  * @return Default initialized @c csvfilereader
  */
-csvfilereader csvfilereader_init(void);
+csvfilereader csvfilereader_init(const csvallocator *allocator);
 
 /**
  * @brief Initializes the private struct used to read from a filepath
@@ -167,13 +269,15 @@ csvfilereader csvfilereader_init(void);
  * This initializer works with standard C @c char types.
  *
  * @param[in] filepath  path to the input file
+ * @param[in] allocator allocator of the buffers
  *
  * @return              Fully initialized @c csvfilereader, if NULL is returned
  *                      then an IO error was encountered.
  *
  * @see csvfilereader_init
  */
-csvfilereader csv_filepath_open(char const *filepath);
+csvfilereader csv_filepath_open(char const *        filepath,
+                                const csvallocator *allocator);
 
 /**
  * @brief Initializes the private struct used to read from a @c FILE*
@@ -184,13 +288,37 @@ csvfilereader csv_filepath_open(char const *filepath);
  * are closed. This initializer works with standard C @c char types.
  *
  * @param[in] fileobj   path to the input file
+ * @param[in] allocator allocator of the buffers
  *
  * @return              Fully initialized @c csvfilereader, if NULL is returned
  *                      then an IO error was encountered.
  *
  * @see csvfilereader_init
  */
-csvfilereader csv_file_open(FILE *fileobj);
+csvfilereader csv_file_open(FILE *fileobj, const csvallocator *allocator);
+
+/**
+ * @brief Initializes the private struct used to read from a block source
+ *
+ * Blocks are taken from @p getnextblock rather than read from a @c FILE*,
+ * the read buffer is released. The source is not released on failure.
+ *
+ * @param[in] getnextblock  produces the next block of input
+ * @param[in] seek          optionally positions @p source, may be @c NULL
+ * @param[in] closer        releases @p source
+ * @param[in] source        passed to @p getnextblock, @p seek and @p closer
+ * @param[in] allocator     allocator of the buffers
+ *
+ * @return                  Fully initialized @c csvfilereader, or NULL if it
+ *                          could not be allocated
+ *
+ * @see csvfilereader_init
+ */
+csvfilereader csv_source_open(csvstream_getnextblock getnextblock,
+                              csvstream_seek         seek,
+                              csvstream_close        closer,
+                              csvstream_type         source,
+                              const csvallocator *   allocator);
 
 /**
  * @brief Get next character in the input stream
@@ -214,6 +342,29 @@ csvfilereader csv_file_open(FILE *fileobj);
 CSV_STREAM_SIGNAL csv_file_getnextchar(csvstream_type            streamdata,
                                        csv_comparison_char_type *value);
 
+/**
+ * @brief Get next block of characters in the input stream
+ *
+ * Callback conforming to the @c csvstream_getnextblock definition
+ *
+ * This callback was designed for the @c csvfilereader as the @p streamdata
+ * value. Each call fills the reader's block buffer with a single @c fread and
+ * hands a reference to it back to the parser, so the per-character cost of
+ * @c csv_file_getnextchar is paid once per block instead.
+ *
+ * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
+ * @param[out]    block       reference to the filled block buffer
+ * @param[out]    length      number of characters stored in @p block
+ *
+ * @return                    @c CSV_GOOD if @p block holds data, otherwise
+ *                            @c CSV_EOF or @c CSV_ERROR
+ *
+ * @see csv/stream.h
+ */
+CSV_STREAM_SIGNAL csv_file_getnextblock(csvstream_type streamdata,
+                                        const char **  block,
+                                        size_t *       length);
+
 /**
  * @brief Append a character to the end of the current field buffer
  *
@@ -231,15 +382,29 @@ CSV_STREAM_SIGNAL csv_file_getnextchar(csvstream_type            streamdata,
 void csv_file_appendchar(csvstream_type           streamdata,
                          csv_comparison_char_type value);
 
+/**
+ * @brief Append a run of characters to the end of the current field buffer
+ *
+ * Callback conforming to the @c csvstream_appendslice definition
+ *
+ * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
+ * @param[in]     data        first character of the run
+ * @param[in]     length      number of characters in the run
+ *
+ * @see csv/stream.h
+ */
+void csv_file_appendslice(csvstream_type streamdata,
+                          const char *   data,
+                          size_t         length);
+
 /**
  * @brief Save field as next value in current record buffer
  *
  * Callback conforming to the @c csvstream_savefield definition
  *
- * When this function is called, the internal field buffer data is used to
- * create a record buffer field of appropriate size. The record buffer's size
- * tracker increments by one, and the field buffer's position is set back to
- * zero.
+ * The fields of a record are stored one after another in the field buffer,
+ * each followed by a @c '\0'. Saving a field terminates it and records its
+ * offset, the next field begins immediately after it.
  *
  * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
  *
@@ -269,6 +434,88 @@ void csv_file_saverecord(csvstream_type streamdata,
                          char ***       fields,
                          size_t *       length);
 
+/**
+ * @brief Save record as views into the reader's field buffer
+ *
+ * Callback conforming to the @c csvstream_saverecordview definition
+ *
+ * Nothing is allocated once the buffers have grown to fit the widest record,
+ * the views remain valid until the next field is appended.
+ *
+ * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
+ * @param[out]    fields      reference to the array of field views
+ * @param[out]    length      the number of fields stored in @p fields
+ *
+ * @see csv/stream.h
+ */
+void csv_file_saverecordview(csvstream_type   streamdata,
+                             const csvfield **fields,
+                             size_t *         length);
+
+/**
+ * @brief Ensure the field buffer can hold @p extra more characters
+ *
+ * @return @c false if the buffer could not be grown
+ */
+bool csv_file_reserve(csvfilereader fr, size_t extra);
+
+/**
+ * @brief Position the stream for @c csvreader_seek_record
+ *
+ * Callback conforming to the @c csvstream_seek definition, the current field
+ * and record are discarded.
+ *
+ * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
+ * @param[in]     offset      offset from the start of the file
+ */
+bool csv_file_seek(csvstream_type streamdata, uint64_t offset);
+
+/**
+ * @brief Start reading @p blocks blocks ahead of the parser on a thread
+ *
+ * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
+ * @param[in]     blocks      number of blocks in the read-ahead ring
+ *
+ * @return @c false if the reader has no @c FILE*, already reads ahead, or
+ *         the thread could not be started
+ *
+ * @see csvreader_set_readahead
+ */
+bool csv_file_readahead(csvstream_type streamdata, size_t blocks);
+
+/**
+ * @brief Replace the @c FILE* read, keeping the buffers and the read-ahead
+ *
+ * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
+ * @param[in]     fileobj     stream to read next
+ * @param[in]     filepath    path @p fileobj was opened from, may be @c NULL
+ * @param[in]     owned       the current stream is closed
+ */
+void csv_file_reset(csvstream_type streamdata,
+                    FILE *         fileobj,
+                    const char *   filepath,
+                    bool           owned);
+
+/**
+ * @brief Start the read-ahead pipeline from the current file position
+ */
+bool csv_file_start_readahead(csvfilereader fr);
+
+/**
+ * @brief Stop the read-ahead thread, the file position is then unspecified
+ */
+void csv_file_stop_readahead(csvfilereader fr);
+
+/**
+ * @brief Fill a read-ahead block from a @c FILE*
+ *
+ * @see csvpipeline_fill
+ */
+CSV_STREAM_SIGNAL csv_file_fill(csvstream_type context,
+                                char *         buffer,
+                                size_t         capacity,
+                                size_t *       length);
+
 /**
  * @brief Release resources for CSV readers initialized with a filepath
  *
@@ -292,6 +539,17 @@ void csv_read_filepath_close(csvstream_type streamdata);
  */
 void csv_read_file_close(csvstream_type streamdata);
 
+/**
+ * @brief Release resources for CSV readers initialized with a block source
+ *
+ * Releases the source with its closer, then the allocated buffers.
+ *
+ * @param[in,out] streamdata  opaque pointer to @c csvfilereader object
+ *
+ * @see csvreader_source_init
+ */
+void csv_read_source_close(csvstream_type streamdata);
+
 /**
  * @brief Default initializer for the CSV Reader
  *
@@ -309,12 +567,174 @@ csvreader _csvreader_init(csvdialect dialect);
 /**
  * @brief Determine what should be done with the next character in the stream
  *
- * This function takes into account the current state of the parser and then
- * uses the supplied character to determine if it should be added to the current
- * field, if it indicates a field boundary has been determined, a record
- * boundary or the end of the stream.
+ * Looks up the transition for the current parser state and the class of
+ * @p value, then applies it: the character may be appended to the current
+ * field, the field saved, and the record completed.
+ *
+ * @return @c CSV_EOR if @p value completed the current record, @c CSV_ERROR if
+ *         @p value is invalid input, otherwise @c CSV_GOOD
+ */
+CSV_STREAM_SIGNAL parse_value(csvreader reader, csv_comparison_char_type value);
+
+/**
+ * @brief Complete any record left open when the stream is exhausted
+ *
+ * @return @c true if a record was pending and has been completed
+ */
+bool parse_end_of_stream(csvreader reader);
+
+/**
+ * @brief Parse the stream until the next record kept by the filter is complete
+ *
+ * @return success if a record is ready to be saved, @c io_eof and @c io_error
+ *         are set when the stream ended or failed.
+ */
+csvreturn csvreader_parse_record(csvreader reader);
+
+/**
+ * @brief Parse the stream until the next record is complete
+ *
+ * @see csvreader_parse_record
+ */
+csvreturn csvreader_parse_next(csvreader reader);
+
+/**
+ * @brief Take the view of the record just parsed and pass it to the filter
+ *
+ * @return @c true if the record is kept
+ */
+bool csvreader_filter_record(csvreader reader);
+
+/**
+ * @brief Return the record just parsed as views
+ *
+ * Hands back the view taken by @c csvreader_filter_record if there is one,
+ * otherwise calls @c saverecordview.
+ */
+void csvreader_saverecordview(csvreader        reader,
+                              const csvfield **fields,
+                              size_t *         length);
+
+/**
+ * @brief Parse characters from @c getnextchar until a record is complete
+ *
+ * @return @c CSV_EOR when a record has been completed, otherwise the
+ *         @c CSV_EOF or @c CSV_ERROR signal which ended the stream
+ */
+CSV_STREAM_SIGNAL csvreader_parse_chars(csvreader reader);
+
+/**
+ * @brief Length of the run of ordinary field characters at @p data
+ *
+ * Ordinary characters are those which the parser would append to the current
+ * field without a change in state, so the whole run can be passed along to the
+ * @c appendslice callback at once. Only meaningful for the @c IN_FIELD and
+ * @c IN_QUOTED_FIELD states.
+ *
+ * @return number of leading characters in @p data which are ordinary
+ */
+size_t parse_field_run(csvreader reader, const char *data, size_t length);
+
+/**
+ * @brief Whether @p value starts an unquoted field of ordinary characters
+ *
+ * Valid in the states which begin a new field, used to start a field run
+ * with its first character rather than appending it alone.
+ */
+bool parse_starts_field_run(csvreader reader, unsigned char value);
+
+/**
+ * @brief Compile the reader's dialect into its class map, transition table
+ * and scan sets
+ */
+void csvreader_init_parser(csvreader reader);
+
+/**
+ * @brief Transition for a character of class @p value_class in @p state
+ *
+ * The parser rules themselves, only evaluated while the transition table is
+ * being built.
+ */
+csvtransition parse_transition(CSV_READER_PARSER_STATE state,
+                               CSV_READER_CHAR_CLASS   value_class,
+                               bool                    doublequote);
+
+/**
+ * @brief Build @p set from the characters which leave @p state other than by
+ * being appended to the field and moving to @p run_state
+ */
+void csvreader_init_scan_set(csvreader               reader,
+                             csvscanset *            set,
+                             CSV_READER_PARSER_STATE state,
+                             CSV_READER_PARSER_STATE run_state);
+
+/**
+ * @brief Append characters to the current field, in one call when possible
+ */
+void csvreader_appendslice(csvreader reader, const char *data, size_t length);
+
+/**
+ * @brief Finish the current field, passing it to @c savefield if it is kept
+ *
+ * Moves on to the next column, or back to the first one at @p end_record.
+ */
+void csvreader_savefield(csvreader reader, bool end_record);
+
+/**
+ * @brief Whether the projection keeps the column of the current field
+ */
+bool csvreader_keeps_field(csvreader reader);
+
+/**
+ * @brief Parse blocks from @c getnextblock until a record is complete
+ *
+ * Parsing resumes from the unconsumed remainder of the current block, so a
+ * block may span any number of records and a record any number of blocks.
+ *
+ * @return @c CSV_EOR when a record has been completed, otherwise the
+ *         @c CSV_EOF or @c CSV_ERROR signal which ended the stream, or
+ *         @c CSV_AGAIN if it has no input yet
+ */
+CSV_STREAM_SIGNAL csvreader_parse_blocks(csvreader reader);
+
+/**
+ * @brief Move the stream to @p offset and continue parsing in @p state
+ *
+ * @return @c false if the reader cannot seek or the stream cannot be
+ *         positioned
+ */
+bool csvreader_position(csvreader               reader,
+                        uint64_t                offset,
+                        CSV_READER_PARSER_STATE state);
+
+/**
+ * @brief Whether the reader was made by @c csvreader_init or
+ * @c csvreader_file_init
+ */
+bool csvreader_is_stdio(csvreader reader);
+
+/**
+ * @brief Point a @c stdio reader at @p fileobj, keeping its buffers
+ *
+ * A file opened by the reader is closed. @p fileobj is closed by
+ * @c csvreader_close if @p filepath is given, as for @c csvreader_init.
  */
-void parse_value(csvreader reader, csv_comparison_char_type value);
+csvreturn csvreader_reset_file(csvreader   reader,
+                               FILE *      fileobj,
+                               const char *filepath);
+
+/**
+ * @brief Copy a record of field views into caller owned strings
+ *
+ * Used by @c csvreader_next_record for readers without a @c saverecord
+ * callback, and for records the filter has already taken as a view.
+ */
+void csvreader_copy_view(csvreader reader, char ***record, size_t *length);
+
+/**
+ * @brief Release the record just parsed without returning it
+ */
+void csvreader_discard_record(csvreader reader);
 
 /*
  * end of private forward declarations
@@ -330,20 +750,24 @@ csvreader csvreader_init(csvdialect dialect, const char *filepath) {
   csvreader     reader     = NULL;
   csvfilereader filereader = NULL;
 
-  if ((filereader = csv_filepath_open(filepath)) == NULL) {
+  if ((filereader = csv_filepath_open(
+           filepath, csvdialect_get_allocator(dialect))) == NULL) {
     ZF_LOGE("`csvfilereader` could not be allocated");
     return NULL;
   }
 
   /* broke out of if statement because I find that visually difficult to read */
-  reader = csvreader_advanced_init(dialect,
-                                   &csv_file_getnextchar,
-                                   &csv_file_appendchar,
-                                   &csv_file_savefield,
-                                   &csv_file_saverecord,
-                                   (csvstream_type)filereader);
+  reader = csvreader_advanced_block_init(dialect,
+                                         &csv_file_getnextblock,
+                                         &csv_file_appendchar,
+                                         &csv_file_savefield,
+                                         &csv_file_saverecord,
+                                         (csvstream_type)filereader);
 
   reader = csvreader_set_closer(reader, &csv_read_filepath_close);
+  reader = csvreader_set_appendslice(reader, &csv_file_appendslice);
+  reader = csvreader_set_saverecordview(reader, &csv_file_saverecordview);
+  reader = csvreader_set_seek(reader, &csv_file_seek);
 
   /* final validation */
   if (reader == NULL) {
@@ -364,20 +788,24 @@ csvreader csvreader_file_init(csvdialect dialect, FILE *fileobj) {
   csvreader     reader     = NULL;
   csvfilereader filereader = NULL;
 
-  if ((filereader = csv_file_open(fileobj)) == NULL) {
+  if ((filereader = csv_file_open(
+           fileobj, csvdialect_get_allocator(dialect))) == NULL) {
     ZF_LOGE("`csvfilereader` could not be allocated");
     return NULL;
   }
 
   /* broke out of if statement because I find that visually difficult to read */
-  reader = csvreader_advanced_init(dialect,
-                                   &csv_file_getnextchar,
-                                   &csv_file_appendchar,
-                                   &csv_file_savefield,
-                                   &csv_file_saverecord,
-                                   (csvstream_type)filereader);
+  reader = csvreader_advanced_block_init(dialect,
+                                         &csv_file_getnextblock,
+                                         &csv_file_appendchar,
+                                         &csv_file_savefield,
+                                         &csv_file_saverecord,
+                                         (csvstream_type)filereader);
 
   reader = csvreader_set_closer(reader, &csv_read_file_close);
+  reader = csvreader_set_appendslice(reader, &csv_file_appendslice);
+  reader = csvreader_set_saverecordview(reader, &csv_file_saverecordview);
+  reader = csvreader_set_seek(reader, &csv_file_seek);
 
   /* final validation */
   if (reader == NULL) {
@@ -420,6 +848,11 @@ csvreader csvreader_advanced_init(csvdialect            dialect,
 
   csvreader reader = _csvreader_init(dialect);
 
+  if (reader == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    return NULL;
+  }
+
   reader->streamdata  = streamdata;
   reader->getnextchar = getnextchar;
   reader->appendchar  = appendchar;
@@ -429,6 +862,50 @@ csvreader csvreader_advanced_init(csvdialect            dialect,
   return reader;
 }
 
+csvreader csvreader_advanced_block_init(csvdialect             dialect,
+                                        csvstream_getnextblock getnextblock,
+                                        csvstream_appendfield  appendchar,
+                                        csvstream_savefield    savefield,
+                                        csvstream_saverecord   saverecord,
+                                        csvstream_type         streamdata) {
+  ZF_LOGI("CSV Reader Advanced Block Initializer called");
+  ZF_LOGD("dialect:     `%p`", (void *)dialect);
+  ZF_LOGD("streamdata:  `%p`", (void *)streamdata);
+
+  /* validation step */
+  /* other than dialect, all arguments must be non-null */
+  if ((getnextblock == NULL) || (appendchar == NULL) || (savefield == NULL) ||
+      (saverecord == NULL) || (streamdata == NULL)) {
+    ZF_LOGE("At least one required advanced initializer argument is NULL");
+    ZF_LOGD("NULL getnextblock: `%s`",
+            (getnextblock == NULL) ? "NULL" : "NOT NULL");
+    ZF_LOGD("NULL appendchar:   `%s`",
+            (appendchar == NULL) ? "NULL" : "NOT NULL");
+    ZF_LOGD("NULL savefield:    `%s`",
+            (savefield == NULL) ? "NULL" : "NOT NULL");
+    ZF_LOGD("NULL saverecord:   `%s`",
+            (saverecord == NULL) ? "NULL" : "NOT NULL");
+    ZF_LOGD("NULL streamdata:   `%s`",
+            (streamdata == NULL) ? "NULL" : "NOT NULL");
+    return NULL;
+  }
+
+  csvreader reader = _csvreader_init(dialect);
+
+  if (reader == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    return NULL;
+  }
+
+  reader->streamdata   = streamdata;
+  reader->getnextblock = getnextblock;
+  reader->appendchar   = appendchar;
+  reader->savefield    = savefield;
+  reader->saverecord   = saverecord;
+
+  return reader;
+}
+
 csvreader csvreader_set_closer(csvreader reader, csvstream_close closer) {
   if (reader == NULL) {
     ZF_LOGE("`called with NULL `reader`");
@@ -439,161 +916,883 @@ csvreader csvreader_set_closer(csvreader reader, csvstream_close closer) {
   return reader;
 }
 
-void csvreader_close(csvreader *reader) {
-  ZF_LOGI("called reader: `%p`", (void *)(*reader));
+csvreader csvreader_set_appendslice(csvreader             reader,
+                                    csvstream_appendslice appendslice) {
+  if (reader == NULL) {
+    ZF_LOGE("`called with NULL `reader`");
+    return NULL;
+  }
 
-  if ((*reader) == NULL) {
-    ZF_LOGI("`reader` referenced a NULL pointer, exiting function early");
-    return;
+  reader->appendslice = appendslice;
+  return reader;
+}
+
+csvreader csvreader_set_saverecordview(
+    csvreader reader, csvstream_saverecordview saverecordview) {
+  if (reader == NULL) {
+    ZF_LOGE("`called with NULL `reader`");
+    return NULL;
   }
 
-  csvdialect_close(&((*reader)->dialect));
+  reader->saverecordview = saverecordview;
+  return reader;
+}
 
-  if (((*reader)->closer) != NULL) {
-    ZF_LOGI(
-        "Calling the `csvstream_close` function supplied to close the stream "
-        "data");
-    (*((*reader)->closer))((*reader)->streamdata);
+csvreturn csvreader_set_filter(csvreader        reader,
+                               csvreader_filter filter,
+                               void *           context) {
+  if (reader == NULL) {
+    ZF_LOGE("`called with NULL `reader`");
+    return csvreturn_init(false);
   }
 
-  ZF_LOGD("Freeing the `csvreader`");
-  free((*reader));
-  *reader = NULL;
+  if ((filter != NULL) && (reader->saverecordview == NULL)) {
+    ZF_LOGE("`csvreader` does not provide record views");
+    return csvreturn_init(false);
+  }
+
+  reader->filter         = filter;
+  reader->filter_context = context;
+  return csvreturn_init(true);
 }
 
-csvreturn csvreader_next_record(csvreader reader,
-                                char ***  record,
-                                size_t *  record_length) {
-  ZF_LOGI("called reader: `%p`", (void *)reader);
-  csv_comparison_char_type value  = 0;
-  CSV_STREAM_SIGNAL        signal = CSV_GOOD;
-  csvreturn                rc;
+csvreturn csvreader_set_projection(csvreader     reader,
+                                   const size_t *indices,
+                                   size_t        length) {
+  bool * projection = NULL;
+  size_t width      = 0;
 
-  ZF_LOGD("Beginning `getnextchar` loop");
+  if (reader == NULL) {
+    ZF_LOGE("`called with NULL `reader`");
+    return csvreturn_init(false);
+  }
 
-  /* burn through any chars that exist at the beginning of the record which
-     don't add to a field */
-  while (reader->parser_state == START_RECORD) {
-    signal = (*reader->getnextchar)(reader->streamdata, &value);
-    ZF_LOGD(
-        "signal returned: `%d`, character returned: `%c`", signal, (char)value);
+  if (reader->getnextrecord != NULL) {
+    ZF_LOGE("`csvreader` records are parsed before they are requested");
+    return csvreturn_init(false);
+  }
 
-    if (value == '\0') {
-      ZF_LOGI("line contains NULL byte");
-      rc          = csvreturn_init(false);
-      rc.io_error = 1;
-      return rc;
+  if ((indices != NULL) && (length > 0)) {
+    for (size_t i = 0; i < length; ++i) {
+      if (indices[i] >= width) width = indices[i] + 1;
     }
 
-    if (signal == CSV_GOOD) {
-      ZF_LOGD("Signal indicates good value returned, beginning to parse");
-      parse_value(reader, value);
-    } else {
-      ZF_LOGD("Signal indicates EOF or Error, ending loop");
-      break;
+    if ((projection = csv_calloc(&reader->allocator,
+                                 width,
+                                 sizeof *projection)) == NULL) {
+      ZF_LOGE("projection of `%lu` columns could not be allocated",
+              (long unsigned)width);
+      return csvreturn_init(false);
     }
-  }
 
-  /* as long as the input is in a good state, extract chars until we hit the
-     next start of record */
-  if (signal == CSV_GOOD) {
-    do {
-      signal = (*reader->getnextchar)(reader->streamdata, &value);
-      ZF_LOGD("signal returned: `%d`, character returned: `%c`",
-              signal,
-              (char)value);
-
-      if (value == '\0') {
-        ZF_LOGI("line contains NULL byte");
-        rc          = csvreturn_init(false);
-        rc.io_error = 1;
-        return rc;
-      }
-
-      if (signal == CSV_GOOD) {
-        ZF_LOGD("Signal indicates good value returned, beginning to parse");
-        parse_value(reader, value);
-      } else {
-        ZF_LOGD("Signal indicates EOF or Error, ending loop");
-        break;
-      }
-    } while (reader->parser_state != START_RECORD);
+    for (size_t i = 0; i < length; ++i) projection[indices[i]] = true;
   }
 
-  // size_t len = 0;
-  // &len
-  (*reader->saverecord)(reader->streamdata, record, record_length);
-  // *record_length = len;
+  ZF_LOGI("projection keeps `%lu` of the first `%lu` columns",
+          (long unsigned)length,
+          (long unsigned)width);
 
-  if (signal == CSV_EOF) {
-    ZF_LOGI("CSV Reader found EOF reached");
-    rc        = csvreturn_init(true);
-    rc.io_eof = 1;
-    return rc;
-  } else if (signal != CSV_GOOD) {
-    ZF_LOGI("CSV Reader found IO error state encountered");
-    rc          = csvreturn_init(false);
-    rc.io_error = 1;
-    return rc;
-  }
-  ZF_LOGI("CSV Reader end of record, IO state is good");
+  csv_free(&reader->allocator, reader->projection);
+  reader->projection        = projection;
+  reader->projection_length = width;
+  reader->keep_field        = csvreader_keeps_field(reader);
   return csvreturn_init(true);
 }
 
+csvreturn csvreader_set_projection_names(csvreader          reader,
+                                         const char *const *names,
+                                         size_t             length) {
+  const csvfield *fields        = NULL;
+  size_t          header_length = 0;
+  size_t *        indices       = NULL;
+  size_t          i, j;
+  csvreturn       rc = csvreader_set_projection(reader, NULL, 0);
+
+  if (csv_failure(rc)) return rc;
+
+  rc = csvreader_next_record_view(reader, &fields, &header_length);
+
+  if (csv_failure(rc)) {
+    ZF_LOGE("header record could not be read");
+    return rc;
+  }
+
+  if ((names == NULL) || (length == 0)) return rc;
+
+  if ((indices = csv_malloc(&reader->allocator, sizeof *indices * length)) ==
+      NULL) {
+    ZF_LOGE("projection indices could not be allocated");
+    return csvreturn_init(false);
+  }
+
+  for (i = 0; i < length; ++i) {
+    for (j = 0; j < header_length; ++j) {
+      if ((strlen(names[i]) == fields[j].len) &&
+          (memcmp(names[i], fields[j].data, fields[j].len) == 0)) {
+        break;
+      }
+    }
+
+    if (j == header_length) {
+      ZF_LOGE("column `%s` is not in the header", names[i]);
+      csv_free(&reader->allocator, indices);
+      return csvreturn_init(false);
+    }
+    indices[i] = j;
+  }
+
+  rc = csvreader_set_projection(reader, indices, length);
+  csv_free(&reader->allocator, indices);
+  return rc;
+}
+
+void csvreader_close(csvreader *reader) {
+  ZF_LOGI("called reader: `%p`", (void *)(*reader));
+
+  if ((*reader) == NULL) {
+    ZF_LOGI("`reader` referenced a NULL pointer, exiting function early");
+    return;
+  }
+
+  csvdialect_close(&((*reader)->dialect));
+
+  if (((*reader)->closer) != NULL) {
+    ZF_LOGI(
+        "Calling the `csvstream_close` function supplied to close the stream "
+        "data");
+    (*((*reader)->closer))((*reader)->streamdata);
+  }
+
+  /* the reader holds its own allocator, keep it past the release */
+  csvallocator allocator = (*reader)->allocator;
+
+  ZF_LOGD("Freeing the `csvreader`");
+  csv_free(&allocator, (*reader)->projection);
+  csvindex_close((*reader)->index);
+  csv_free(&allocator, (*reader));
+  *reader = NULL;
+}
+
+csvreturn csvreader_next_record(csvreader reader,
+                                char ***  record,
+                                size_t *  record_length) {
+  ZF_LOGI("called reader: `%p`", (void *)reader);
+  csvreturn rc = csvreader_parse_record(reader);
+
+  /* a record already taken as a view by the filter is copied from it */
+  if (csv_success(rc) &&
+      ((reader->saverecord == NULL) || reader->view_saved)) {
+    csvreader_copy_view(reader, record, record_length);
+  } else if (csv_success(rc)) {
+    (*reader->saverecord)(reader->streamdata, record, record_length);
+  } else {
+    *record        = NULL;
+    *record_length = 0;
+  }
+  return rc;
+}
+
+csvreturn csvreader_next_record_view(csvreader        reader,
+                                     const csvfield **fields,
+                                     size_t *         record_length) {
+  ZF_LOGI("called reader: `%p`", (void *)reader);
+  csvreturn rc;
+
+  *fields        = NULL;
+  *record_length = 0;
+
+  if (reader->saverecordview == NULL) {
+    ZF_LOGE("`csvreader` does not provide record views");
+    return csvreturn_init(false);
+  }
+
+  rc = csvreader_parse_record(reader);
+
+  if (csv_success(rc)) {
+    csvreader_saverecordview(reader, fields, record_length);
+  }
+  return rc;
+}
+
+csvreturn csvreader_next_batch(csvreader reader,
+                               size_t    max_records,
+                               csvbatch *batch) {
+  ZF_LOGI("called reader: `%p` max records: `%lu`",
+          (void *)reader,
+          (long unsigned)max_records);
+  const csvfield *fields = NULL;
+  size_t          length = 0;
+  csvreturn       rc     = csvreturn_init(false);
+
+  batch->size = 0;
+
+  if (reader->saverecordview == NULL) {
+    ZF_LOGE("`csvreader` does not provide record views");
+    return rc;
+  }
+
+  if (!csvbatch_begin(batch, max_records)) return rc;
+
+  while (batch->size < max_records) {
+    rc = csvreader_parse_record(reader);
+
+    if (csv_failure(rc)) break;
+
+    csvreader_saverecordview(reader, &fields, &length);
+
+    if (!csvbatch_append(batch, fields, length)) {
+      ZF_LOGE("`csvbatch` could not be grown");
+      rc          = csvreturn_init(false);
+      rc.io_error = 1;
+      return rc;
+    }
+
+    if (rc.io_eof) break;
+  }
+
+  ZF_LOGD("batch filled with `%lu` records", (long unsigned)batch->size);
+
+  if ((batch->size > 0) && !rc.io_error) {
+    rc.succeeded = 1;
+  }
+  return rc;
+}
+
+void csvbatch_init(csvbatch *batch) {
+  batch->size             = 0;
+  batch->records          = NULL;
+  batch->fields           = NULL;
+  batch->heap             = NULL;
+  batch->capacity_records = 0;
+  batch->capacity_fields  = 0;
+  batch->capacity_heap    = 0;
+}
+
+csvfield csvbatch_field(const csvbatch *batch, size_t record, size_t field) {
+  csvfield view = {NULL, 0};
+  size_t   index;
+
+  if (field >= csvbatch_record_length(batch, record)) return view;
+
+  index     = batch->records[record] + field;
+  view.data = batch->heap + batch->fields[index];
+  view.len  = batch->fields[index + 1] - batch->fields[index] - 1;
+  return view;
+}
+
+size_t csvbatch_record_length(const csvbatch *batch, size_t record) {
+  if (record >= batch->size) return 0;
+
+  return batch->records[record + 1] - batch->records[record];
+}
+
+void csvbatch_close(csvbatch *batch) {
+  csv_free(NULL, batch->records);
+  csv_free(NULL, batch->fields);
+  csv_free(NULL, batch->heap);
+  csvbatch_init(batch);
+}
+
+csvreturn csvreader_count_records(csvdialect  dialect,
+                                  const char *filepath,
+                                  uint64_t *  records,
+                                  uint64_t *  fields) {
+  ZF_LOGI("counting records of filepath `%s`", filepath);
+  const char *map    = NULL;
+  size_t      length = 0;
+  csvreader   reader = NULL;
+  csvreturn   rc     = csvreturn_init(false);
+
+  *records = 0;
+  *fields  = 0;
+
+  if ((filepath == NULL) || !csv_mmap_map(filepath, &map, &length)) {
+    ZF_LOGE("`%s` could not be mapped", filepath);
+    rc.io_error = 1;
+    return rc;
+  }
+
+  if (((reader = _csvreader_init(dialect)) == NULL) ||
+      (reader->dialect == NULL)) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    csvreader_close(&reader);
+    csv_mmap_unmap(map, length);
+    return rc;
+  }
+
+  rc.succeeded =
+      csvreader_scan_block(reader, map, length, records, fields, NULL);
+  rc.io_eof    = 1;
+  rc.io_error  = !rc.succeeded;
+
+  ZF_LOGD("counted `%lu` records and `%lu` fields",
+          (long unsigned)*records,
+          (long unsigned)*fields);
+
+  csvreader_close(&reader);
+  csv_mmap_unmap(map, length);
+  return rc;
+}
+
+csvreturn csvreader_seek_record(csvreader reader, uint64_t record) {
+  ZF_LOGI("called reader: `%p` record: `%lu`",
+          (void *)reader,
+          (long unsigned)record);
+  static bool     keep_none[1] = {false};
+  const csvindex *index        = reader->index;
+  bool *          projection   = reader->projection;
+  size_t          width        = reader->projection_length;
+  uint64_t        entry        = 0;
+  csvreturn       rc           = csvreturn_init(false);
+
+  if ((index == NULL) || (index->size == 0) || (reader->seek == NULL)) {
+    ZF_LOGE("`csvreader` has no index or cannot seek");
+    return rc;
+  }
+
+  if (record >= index->records) {
+    ZF_LOGD("record `%lu` is past the indexed records",
+            (long unsigned)record);
+    rc.io_eof = 1;
+    return rc;
+  }
+
+  entry = record / index->interval;
+  if (entry >= index->size) entry = index->size - 1;
+
+  if (!csvreader_position(reader,
+                          index->offsets[entry],
+                          (CSV_READER_PARSER_STATE)index->states[entry])) {
+    rc.io_error = 1;
+    return rc;
+  }
+
+  /* parse forward to the record, keeping none of the fields on the way */
+  reader->projection        = keep_none;
+  reader->projection_length = 0;
+  reader->keep_field        = false;
+
+  for (record -= entry * index->interval; record > 0; --record) {
+    rc = csvreader_parse_next(reader);
+
+    if (csv_failure(rc) || rc.io_eof) break;
+
+    csvreader_discard_record(reader);
+  }
+
+  reader->projection        = projection;
+  reader->projection_length = width;
+  reader->keep_field        = csvreader_keeps_field(reader);
+
+  if (record > 0) {
+    ZF_LOGE("input ended before the indexed record");
+    rc.succeeded = 0;
+    return rc;
+  }
+  return csvreturn_init(true);
+}
+
+csvreturn csvreader_seek_offset(csvreader reader, uint64_t offset) {
+  ZF_LOGI("called reader: `%p` offset: `%lu`",
+          (void *)reader,
+          (long unsigned)offset);
+  csvreturn rc = csvreturn_init(false);
+
+  if ((reader == NULL) || (reader->seek == NULL)) {
+    ZF_LOGE("`csvreader` cannot seek");
+    return rc;
+  }
+
+  if (!csvreader_position(reader, offset, START_RECORD)) {
+    rc.io_error = 1;
+    return rc;
+  }
+  return csvreturn_init(true);
+}
+
+csvreturn csvreader_checkpoint(csvreader reader, csvcheckpoint *checkpoint) {
+  ZF_LOGI("called reader: `%p`", (void *)reader);
+
+  if ((reader == NULL) || (checkpoint == NULL) || (reader->seek == NULL)) {
+    ZF_LOGE("`csvreader` cannot be resumed from a checkpoint");
+    return csvreturn_init(false);
+  }
+
+  checkpoint->offset = reader->record_offset;
+  checkpoint->state  = (uint64_t)reader->record_state;
+
+  ZF_LOGD("checkpoint offset: `%lu` state: `%s`",
+          (long unsigned)checkpoint->offset,
+          csv_reader_parser_state(reader->record_state));
+  return csvreturn_init(true);
+}
+
+csvreturn csvreader_restore(csvreader            reader,
+                            const csvcheckpoint *checkpoint) {
+  ZF_LOGI("called reader: `%p`", (void *)reader);
+  csvreturn rc = csvreturn_init(false);
+
+  if ((reader == NULL) || (checkpoint == NULL) || (reader->seek == NULL)) {
+    ZF_LOGE("`csvreader` cannot be resumed from a checkpoint");
+    return rc;
+  }
+
+  /* checkpoints are only taken between records */
+  if ((checkpoint->state != START_RECORD) &&
+      (checkpoint->state != EAT_CRNL)) {
+    ZF_LOGE("checkpoint state `%lu` is not between records",
+            (long unsigned)checkpoint->state);
+    return rc;
+  }
+
+  if (!csvreader_position(reader,
+                          checkpoint->offset,
+                          (CSV_READER_PARSER_STATE)checkpoint->state)) {
+    rc.io_error = 1;
+    return rc;
+  }
+  return csvreturn_init(true);
+}
+
+csvreader csvreader_resume(csvdialect           dialect,
+                           const char *         filepath,
+                           const csvcheckpoint *checkpoint) {
+  ZF_LOGI("resuming CSV Reader of filepath `%s`", filepath);
+  csvreader reader = csvreader_init(dialect, filepath);
+
+  if ((reader != NULL) && csv_failure(csvreader_restore(reader, checkpoint))) {
+    ZF_LOGE("`%s` could not be resumed from the checkpoint", filepath);
+    csvreader_close(&reader);
+  }
+  return reader;
+}
+
+csvreturn csvreader_reset(csvreader reader, FILE *fileobj) {
+  ZF_LOGI("called reader: `%p` fileobj: `%p`",
+          (void *)reader,
+          (void *)fileobj);
+
+  if ((fileobj == NULL) || !csvreader_is_stdio(reader)) {
+    ZF_LOGE("`csvreader` does not read from a `FILE*`");
+    return csvreturn_init(false);
+  }
+
+  return csvreader_reset_file(reader, fileobj, NULL);
+}
+
+csvreturn csvreader_reset_path(csvreader reader, const char *filepath) {
+  ZF_LOGI("called reader: `%p` filepath: `%s`", (void *)reader, filepath);
+  FILE *    fileobj = NULL;
+  csvreturn rc      = csvreturn_init(false);
+
+  if ((filepath == NULL) || !csvreader_is_stdio(reader)) {
+    ZF_LOGE("`csvreader` does not read from a `FILE*`");
+    return rc;
+  }
+
+  if ((fileobj = fopen(filepath, "rb")) == NULL) {
+    ZF_LOGE("`%s` could not be opened", filepath);
+    rc.io_error = 1;
+    return rc;
+  }
+
+  return csvreader_reset_file(reader, fileobj, filepath);
+}
+
+csvreturn csvreader_set_readahead(csvreader reader, size_t blocks) {
+  ZF_LOGI("called reader: `%p` blocks: `%lu`",
+          (void *)reader,
+          (long unsigned)blocks);
+
+  if ((reader == NULL) || (reader->getnextblock != &csv_file_getnextblock)) {
+    ZF_LOGE("`csvreader` does not read from a `FILE*`");
+    return csvreturn_init(false);
+  }
+
+  /* the thread reads on from the file position, the block must be parsed */
+  if (reader->block_position < reader->block_length) {
+    ZF_LOGE("`csvreader` is in the middle of a block");
+    return csvreturn_init(false);
+  }
+
+  return csvreturn_init(csv_file_readahead(reader->streamdata, blocks));
+}
+
 /*
  * end of API implementations
  */
 
+/*
+ * Begin - private reader implementations, see 'read_private.h'
+ */
+csvreader csvreader_record_source_init(csvdialect               dialect,
+                                       csvstream_getnextrecord  getnextrecord,
+                                       csvstream_saverecordview saverecordview,
+                                       csvstream_type           streamdata) {
+  ZF_LOGI("CSV Reader Record Source Initializer called");
+
+  if ((getnextrecord == NULL) || (saverecordview == NULL) ||
+      (streamdata == NULL)) {
+    ZF_LOGE("At least one required record source argument is NULL");
+    return NULL;
+  }
+
+  csvreader reader = _csvreader_init(dialect);
+
+  if (reader == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    return NULL;
+  }
+
+  reader->streamdata     = streamdata;
+  reader->getnextrecord  = getnextrecord;
+  reader->saverecordview = saverecordview;
+
+  return reader;
+}
+
+csvreader csvreader_source_init(csvdialect             dialect,
+                                csvstream_getnextblock getnextblock,
+                                csvstream_seek         seek,
+                                csvstream_close        closer,
+                                csvstream_type         source) {
+  ZF_LOGI("CSV Reader Block Source Initializer called");
+  csvreader     reader = NULL;
+  csvfilereader fr     = NULL;
+
+  if ((fr = csv_source_open(getnextblock,
+                            seek,
+                            closer,
+                            source,
+                            csvdialect_get_allocator(dialect))) == NULL) {
+    ZF_LOGE("`csvfilereader` could not be allocated");
+    if (closer != NULL) (*closer)(source);
+    return NULL;
+  }
+
+  reader = csvreader_advanced_block_init(dialect,
+                                         &csv_file_getnextblock,
+                                         &csv_file_appendchar,
+                                         &csv_file_savefield,
+                                         &csv_file_saverecord,
+                                         (csvstream_type)fr);
+
+  reader = csvreader_set_closer(reader, &csv_read_source_close);
+  reader = csvreader_set_appendslice(reader, &csv_file_appendslice);
+  reader = csvreader_set_saverecordview(reader, &csv_file_saverecordview);
+  if (seek != NULL) reader = csvreader_set_seek(reader, &csv_file_seek);
+
+  if (reader == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    csv_read_source_close((csvstream_type)fr);
+    return NULL;
+  }
+  return reader;
+}
+
+csvreader csvreader_set_seek(csvreader reader, csvstream_seek seek) {
+  if (reader == NULL) {
+    ZF_LOGE("`called with NULL `reader`");
+    return NULL;
+  }
+
+  reader->seek = seek;
+  return reader;
+}
+
+void csvreader_set_index(csvreader reader, csvindex *index) {
+  csvindex_close(reader->index);
+  reader->index = index;
+}
+
+csvstream_type csvreader_get_streamdata(csvreader reader) {
+  return (reader == NULL) ? NULL : reader->streamdata;
+}
+
+void csvreader_rewind(csvreader reader) {
+  reader->field_index    = 0;
+  reader->keep_field     = csvreader_keeps_field(reader);
+  reader->parser_state   = START_RECORD;
+  reader->block          = NULL;
+  reader->block_length   = 0;
+  reader->block_position = 0;
+  reader->block_offset   = 0;
+  reader->record_offset  = 0;
+  reader->record_state   = START_RECORD;
+}
+
+bool csvreader_position(csvreader               reader,
+                        uint64_t                offset,
+                        CSV_READER_PARSER_STATE state) {
+  if ((reader->seek == NULL) || !(*reader->seek)(reader->streamdata, offset)) {
+    ZF_LOGD("stream could not be positioned at `%lu`", (long unsigned)offset);
+    return false;
+  }
+
+  csvreader_rewind(reader);
+  reader->parser_state  = state;
+  reader->block_offset  = offset;
+  reader->record_offset = offset;
+  reader->record_state  = state;
+  reader->view_saved    = false;
+  return true;
+}
+
+bool csvreader_is_stdio(csvreader reader) {
+  return (reader != NULL) && ((reader->closer == &csv_read_filepath_close) ||
+                              (reader->closer == &csv_read_file_close));
+}
+
+csvreturn csvreader_reset_file(csvreader   reader,
+                               FILE *      fileobj,
+                               const char *filepath) {
+  csv_file_reset(reader->streamdata,
+                 fileobj,
+                 filepath,
+                 reader->closer == &csv_read_filepath_close);
+
+  reader->closer =
+      (filepath != NULL) ? &csv_read_filepath_close : &csv_read_file_close;
+
+  /* an index describes the old input */
+  csvreader_set_index(reader, NULL);
+  csvreader_rewind(reader);
+  reader->view_saved = false;
+  return csvreturn_init(true);
+}
+
+void csvreader_copy_view(csvreader reader, char ***record, size_t *length) {
+  const csvfield *fields = NULL;
+  char **         copy   = NULL;
+
+  *record = NULL;
+  csvreader_saverecordview(reader, &fields, length);
+
+  if ((copy = csv_malloc(&reader->allocator, sizeof *copy * (*length + 1))) ==
+      NULL) {
+    ZF_LOGD("record could not be allocated");
+    *length = 0;
+    return;
+  }
+
+  for (size_t i = 0; i < *length; ++i) {
+    if ((copy[i] = csv_malloc(&reader->allocator, fields[i].len + 1)) == NULL) {
+      ZF_LOGD("record field could not be allocated");
+
+      while (i > 0) csv_free(&reader->allocator, copy[--i]);
+      csv_free(&reader->allocator, copy);
+      *length = 0;
+      return;
+    }
+    memcpy(copy[i], fields[i].data, fields[i].len);
+    copy[i][fields[i].len] = '\0';
+  }
+  *record = copy;
+}
+
+void csvreader_discard_record(csvreader reader) {
+  const csvfield *fields = NULL;
+  char **         record = NULL;
+  size_t          length = 0;
+
+  if (reader->saverecordview != NULL) {
+    (*reader->saverecordview)(reader->streamdata, &fields, &length);
+    return;
+  }
+
+  (*reader->saverecord)(reader->streamdata, &record, &length);
+  for (size_t i = 0; i < length; ++i) csv_free(&reader->allocator, record[i]);
+  csv_free(&reader->allocator, record);
+}
+
+/*
+ * End - private reader implementations
+ */
+
+/*
+ * Begin - csvbatch helpers
+ */
+bool csvbatch_begin(csvbatch *batch, size_t expected) {
+  size_t *records = NULL;
+
+  batch->size = 0;
+
+  /* the records grow on demand, avoid reserving for unbounded requests */
+  if (expected > 4096) expected = 4096;
+
+  if ((records = csvbatch_reserve(batch->records,
+                                  &batch->capacity_records,
+                                  1,
+                                  expected + 1,
+                                  sizeof *batch->records)) == NULL) {
+    return false;
+  }
+  batch->records    = records;
+  batch->records[0] = 0;
+  return true;
+}
+
+void *csvbatch_reserve(void *  buffer,
+                       size_t *capacity,
+                       size_t  required,
+                       size_t  minimum,
+                       size_t  size) {
+  size_t grown = (*capacity > 0) ? *capacity : minimum;
+
+  if (required <= *capacity) return buffer;
+  if (grown == 0) grown = 1;
+
+  while (grown < required) grown *= 2;
+
+  if ((buffer = csv_realloc(NULL, buffer, grown * size)) == NULL) {
+    ZF_LOGE("`csvbatch` buffer could not be reallocated to `%lu` elements",
+            (long unsigned)grown);
+    return NULL;
+  }
+
+  *capacity = grown;
+  return buffer;
+}
+
+bool csvbatch_append(csvbatch *      batch,
+                     const csvfield *fields,
+                     size_t          length) {
+  size_t first  = batch->records[batch->size];
+  size_t used   = (first > 0) ? batch->fields[first] : 0;
+  size_t bytes  = 0;
+  void * buffer = NULL;
+
+  for (size_t i = 0; i < length; ++i) bytes += fields[i].len + 1;
+
+  if ((buffer = csvbatch_reserve(batch->records,
+                                 &batch->capacity_records,
+                                 batch->size + 2,
+                                 16,
+                                 sizeof *batch->records)) == NULL) {
+    return false;
+  }
+  batch->records = buffer;
+
+  if ((buffer = csvbatch_reserve(batch->fields,
+                                 &batch->capacity_fields,
+                                 first + length + 1,
+                                 (length + 1) * 16,
+                                 sizeof *batch->fields)) == NULL) {
+    return false;
+  }
+  batch->fields = buffer;
+
+  if ((buffer = csvbatch_reserve(batch->heap,
+                                 &batch->capacity_heap,
+                                 used + bytes,
+                                 4096,
+                                 sizeof *batch->heap)) == NULL) {
+    return false;
+  }
+  batch->heap = buffer;
+
+  for (size_t i = 0; i < length; ++i) {
+    batch->fields[first + i] = used;
+    memcpy(batch->heap + used, fields[i].data, fields[i].len);
+    used += fields[i].len;
+    batch->heap[used++] = '\0';
+  }
+
+  batch->fields[first + length]  = used;
+  batch->records[++batch->size] = first + length;
+  return true;
+}
+
+/*
+ * End - csvbatch helpers
+ */
+
 /*
  * Begin - FILE* based callback implementations
  */
 
+/*
+ * size of the buffer filled by each `fread` in `csv_file_getnextblock`
+ */
+#define CSV_FILE_BLOCK_SIZE ((size_t)1 << 16)
+
 /*
  * private implementation struct to manage CSVs which utilize stdio files
  */
 struct csv_file_reader {
+  /* allocates the reader's buffers and the records it saves */
+  csvallocator allocator;
+
   /* if providex, might be null but useful for debug info */
   char const *filepath;
 
   /* needed for the input stream */
   FILE *file;
 
-  char **record;
+  /* input buffer handed to the parser by `csv_file_getnextblock` */
+  char * block;
+  size_t capacity_b;
+
+  /* fields of the current record, each terminated by '\0' */
   char * field;
   size_t capacity_f;
   size_t size_f;
-  size_t capacity_r;
-  size_t size_r;
+  size_t start_f;
+
+  /* offset of each saved field of the current record within `field` */
+  size_t *record;
+  size_t  capacity_r;
+  size_t  size_r;
+
+  /* views handed out by `csv_file_saverecordview`, sized to `capacity_r` */
+  csvfield *view;
+
+  /* if set, blocks are taken from the source instead of read from `file` */
+  csvstream_getnextblock source_getnextblock;
+  csvstream_seek         source_seek;
+  csvstream_close        source_close;
+  csvstream_type         source;
+
+  /* blocks read ahead by a `csvpipeline` over `file`, zero if not started */
+  size_t readahead;
 };
 
 /*
  * core struct csv_file_reader * initializer for standardized creation between
  * both the char* filepath initializer and the FILE* initializer
  */
-csvfilereader csvfilereader_init(void) {
+csvfilereader csvfilereader_init(const csvallocator *allocator) {
   ZF_LOGI("`csvfilereader_init` called");
 
   csvfilereader fr = NULL;
 
-  if ((fr = malloc(sizeof *fr)) == NULL) {
+  if ((fr = csv_malloc(allocator, sizeof *fr)) == NULL) {
     ZF_LOGD("`csvfilereader` could not be allocated");
     return NULL;
   }
 
-  fr->filepath = NULL;
-  fr->file     = NULL;
+  fr->allocator           = *allocator;
+  fr->filepath            = NULL;
+  fr->file                = NULL;
+  fr->source_getnextblock = NULL;
+  fr->source_seek         = NULL;
+  fr->source_close        = NULL;
+  fr->source              = NULL;
+  fr->readahead           = 0;
 
   /* 256 chosen as a default because this is generally the max
    * witdth of a SQL database VARCHAR field.
    */
   fr->size_f     = 0;
+  fr->start_f    = 0;
   fr->capacity_f = 256;
 
-  if ((fr->field = malloc(sizeof *fr->field * fr->capacity_f)) == NULL) {
+  fr->field = csv_malloc(allocator, sizeof *fr->field * fr->capacity_f);
+  if (fr->field == NULL) {
     ZF_LOGD(
         "`csvfilereader->field` could not be allocated with a size of `%lu`",
         (long unsigned)fr->capacity_f);
-    free(fr);
+    csv_free(allocator, fr);
     return NULL;
   }
 
@@ -601,12 +1800,37 @@ csvfilereader csvfilereader_init(void) {
   fr->size_r     = 0;
   fr->capacity_r = 8;
 
-  if ((fr->record = malloc(sizeof *fr->record * fr->capacity_r)) == NULL) {
+  fr->record = csv_malloc(allocator, sizeof *fr->record * fr->capacity_r);
+  if (fr->record == NULL) {
     ZF_LOGD(
         "`csvfilereader->record` could not be allocated with a size of `%lu`",
         (long unsigned)fr->capacity_r);
-    free(fr->field);
-    free(fr);
+    csv_free(allocator, fr->field);
+    csv_free(allocator, fr);
+    return NULL;
+  }
+
+  fr->view = csv_malloc(allocator, sizeof *fr->view * fr->capacity_r);
+  if (fr->view == NULL) {
+    ZF_LOGD("`csvfilereader->view` could not be allocated with a size of `%lu`",
+            (long unsigned)fr->capacity_r);
+    csv_free(allocator, fr->record);
+    csv_free(allocator, fr->field);
+    csv_free(allocator, fr);
+    return NULL;
+  }
+
+  fr->capacity_b = CSV_FILE_BLOCK_SIZE;
+
+  fr->block = csv_malloc(allocator, sizeof *fr->block * fr->capacity_b);
+  if (fr->block == NULL) {
+    ZF_LOGD(
+        "`csvfilereader->block` could not be allocated with a size of `%lu`",
+        (long unsigned)fr->capacity_b);
+    csv_free(allocator, fr->view);
+    csv_free(allocator, fr->record);
+    csv_free(allocator, fr->field);
+    csv_free(allocator, fr);
     return NULL;
   }
   ZF_LOGD("`csvfilereader` successfully allocated at `%p`", (void *)fr);
@@ -617,7 +1841,8 @@ csvfilereader csvfilereader_init(void) {
  * make a file reader from a filepath, shares common logic and implementation
  * with the FILE* initializer.
  */
-csvfilereader csv_filepath_open(char const *filepath) {
+csvfilereader csv_filepath_open(char const *        filepath,
+                                const csvallocator *allocator) {
   ZF_LOGI("`csv_filepath_open` called with filepath: `%s`", filepath);
 
   if (filepath == NULL) {
@@ -634,7 +1859,7 @@ csvfilereader csv_filepath_open(char const *filepath) {
     return NULL;
   }
 
-  if ((fr = csvfilereader_init()) == NULL) {
+  if ((fr = csvfilereader_init(allocator)) == NULL) {
     ZF_LOGD("`csvfilereader` could not be allocated");
     fclose(fileobj);
     return NULL;
@@ -649,7 +1874,7 @@ csvfilereader csv_filepath_open(char const *filepath) {
 /*
  * make a file reader from a supplied FILE*
  */
-csvfilereader csv_file_open(FILE *fileobj) {
+csvfilereader csv_file_open(FILE *fileobj, const csvallocator *allocator) {
   ZF_LOGI("`csv_file_open` called with `fileobj`: `%p`", (void *)fileobj);
 
   if (fileobj == NULL) {
@@ -659,7 +1884,7 @@ csvfilereader csv_file_open(FILE *fileobj) {
 
   csvfilereader fr = NULL;
 
-  if ((fr = csvfilereader_init()) == NULL) {
+  if ((fr = csvfilereader_init(allocator)) == NULL) {
     ZF_LOGD("`csvfilereader` could not be allocated");
     return NULL;
   }
@@ -670,54 +1895,274 @@ csvfilereader csv_file_open(FILE *fileobj) {
   return fr;
 }
 
+/*
+ * make a file reader over a block source, no FILE* is involved
+ */
+csvfilereader csv_source_open(csvstream_getnextblock getnextblock,
+                              csvstream_seek         seek,
+                              csvstream_close        closer,
+                              csvstream_type         source,
+                              const csvallocator *   allocator) {
+  ZF_LOGI("`csv_source_open` called with `source`: `%p`", source);
+
+  if (getnextblock == NULL) {
+    ZF_LOGD("`csvfilereader` `getnextblock` cannot be NULL");
+    return NULL;
+  }
+
+  csvfilereader fr = NULL;
+
+  if ((fr = csvfilereader_init(allocator)) == NULL) {
+    ZF_LOGD("`csvfilereader` could not be allocated");
+    return NULL;
+  }
+
+  /* blocks come from the source, the read buffer is never used */
+  csv_free(allocator, fr->block);
+  fr->block               = NULL;
+  fr->capacity_b          = 0;
+  fr->source_getnextblock = getnextblock;
+  fr->source_seek         = seek;
+  fr->source_close        = closer;
+  fr->source              = source;
+  ZF_LOGD("`csvfilereader` successfully allocated");
+  return fr;
+}
+
 CSV_STREAM_SIGNAL csv_file_getnextchar(csvstream_type            streamdata,
                                        csv_comparison_char_type *value) {
   ZF_LOGI("called w/ streamdata: `%p`", streamdata);
   int c = 0;
 
-  if (streamdata == NULL) {
-    *value = CSV_UNDEFINED_CHAR;
-    ZF_LOGD(
-        "`csvstream_type` provided was NULL, and must point to a valid memory "
-        "address");
-    return CSV_ERROR;
+  if (streamdata == NULL) {
+    *value = CSV_UNDEFINED_CHAR;
+    ZF_LOGD(
+        "`csvstream_type` provided was NULL, and must point to a valid memory "
+        "address");
+    return CSV_ERROR;
+  }
+
+  csvfilereader fr = (csvfilereader)streamdata;
+
+  if (fr->file == NULL) {
+    *value = CSV_UNDEFINED_CHAR;
+    ZF_LOGD("`streamdata->file` provided was NULL -- exiting with error");
+    return CSV_ERROR;
+  }
+
+  if ((c = getc(fr->file)) != EOF) {
+    *value = c;
+    ZF_LOGD("value: `%c` CSV_STREAM_SIGNAL: `CSV_GOOD`", (char)(*value));
+    return CSV_GOOD;
+  }
+
+  if (feof(fr->file)) {
+    ZF_LOGD("End of file indicator encountered");
+    *value = 0;
+    ZF_LOGD("value: `%c` CSV_STREAM_SIGNAL: `CSV_EOF`", (char)(*value));
+    return CSV_EOF;
+  }
+
+  if (ferror(fr->file)) {
+    ZF_LOGI("IO Error Encountered");
+    *value = CSV_UNDEFINED_CHAR;
+    perror("Error detected while reading CSV");
+    ZF_LOGD("value: `%c` CSV_STREAM_SIGNAL: `CSV_ERROR`", (char)(*value));
+    return CSV_ERROR;
+  }
+
+  return CSV_GOOD;
+}
+
+CSV_STREAM_SIGNAL csv_file_getnextblock(csvstream_type streamdata,
+                                        const char **  block,
+                                        size_t *       length) {
+  ZF_LOGI("called w/ streamdata: `%p`", streamdata);
+  size_t count = 0;
+
+  *block  = NULL;
+  *length = 0;
+
+  if (streamdata == NULL) {
+    ZF_LOGD(
+        "`csvstream_type` provided was NULL, and must point to a valid memory "
+        "address");
+    return CSV_ERROR;
+  }
+
+  csvfilereader fr = (csvfilereader)streamdata;
+
+  if (fr->source_getnextblock != NULL) {
+    return (*fr->source_getnextblock)(fr->source, block, length);
+  }
+
+  if (fr->file == NULL) {
+    ZF_LOGD("`streamdata->file` provided was NULL -- exiting with error");
+    return CSV_ERROR;
+  }
+
+  if ((count = fread(fr->block, 1, fr->capacity_b, fr->file)) > 0) {
+    *block  = fr->block;
+    *length = count;
+    ZF_LOGD("block length: `%lu` CSV_STREAM_SIGNAL: `CSV_GOOD`",
+            (long unsigned)count);
+    return CSV_GOOD;
+  }
+
+  if (ferror(fr->file)) {
+    ZF_LOGI("IO Error Encountered");
+    perror("Error detected while reading CSV");
+    return CSV_ERROR;
+  }
+
+  ZF_LOGD("End of file indicator encountered");
+  return CSV_EOF;
+}
+
+bool csv_file_reserve(csvfilereader fr, size_t extra) {
+  size_t capacity = fr->capacity_f;
+  char * temp     = NULL;
+
+  /* one extra character is always kept for the field terminator */
+  if ((fr->size_f + extra) < capacity) return true;
+
+  ZF_LOGD(
+      "`csvfilereader` field size required exceeds capacity, calling "
+      "`realloc` to expand");
+
+  while ((fr->size_f + extra) >= capacity) capacity *= 2;
+
+  if ((temp = csv_realloc(&fr->allocator, fr->field, capacity)) == NULL) {
+    ZF_LOGE("`csvfilereader` field could not be reallocated to size `%lu`",
+            (long unsigned)capacity);
+    return false;
+  }
+
+  fr->field      = temp;
+  fr->capacity_f = capacity;
+  ZF_LOGI("`csvfilereader` field reallocated to new size of: `%lu`",
+          (long unsigned)fr->capacity_f);
+  return true;
+}
+
+bool csv_file_seek(csvstream_type streamdata, uint64_t offset) {
+  ZF_LOGI("`csv_file_seek` called with offset `%lu`", (long unsigned)offset);
+  csvfilereader fr         = (csvfilereader)streamdata;
+  bool          positioned = false;
+
+  if (fr == NULL) return false;
+
+  /* the read-ahead thread has read past `offset`, it restarts there */
+  if (fr->readahead > 0) csv_file_stop_readahead(fr);
+
+  if (fr->source_seek != NULL) {
+    positioned = (*fr->source_seek)(fr->source, offset);
+  } else if ((fr->file != NULL) && (offset <= LONG_MAX)) {
+    positioned = (fseek(fr->file, (long)offset, SEEK_SET) == 0);
+  }
+
+  if (!positioned) ZF_LOGD("`csv_file_seek` offset cannot be reached");
+
+  /* the file has moved, without the pipeline it is read directly */
+  if ((fr->readahead > 0) && !csv_file_start_readahead(fr)) {
+    ZF_LOGD("read-ahead could not be restarted, reading synchronously");
+    fr->readahead = 0;
+  }
+  if (!positioned) return false;
+
+  fr->size_f  = 0;
+  fr->start_f = 0;
+  fr->size_r  = 0;
+  return true;
+}
+
+bool csv_file_readahead(csvstream_type streamdata, size_t blocks) {
+  csvfilereader fr = (csvfilereader)streamdata;
+
+  if ((fr == NULL) || (fr->file == NULL) || (fr->readahead > 0) ||
+      (fr->source_getnextblock != NULL) || (blocks < 2)) {
+    ZF_LOGD("read-ahead cannot be started");
+    return false;
+  }
+
+  fr->readahead = blocks;
+
+  if (!csv_file_start_readahead(fr)) {
+    fr->readahead = 0;
+    return false;
   }
+  return true;
+}
 
+void csv_file_reset(csvstream_type streamdata,
+                    FILE *         fileobj,
+                    const char *   filepath,
+                    bool           owned) {
   csvfilereader fr = (csvfilereader)streamdata;
 
-  if (fr->file == NULL) {
-    *value = CSV_UNDEFINED_CHAR;
-    ZF_LOGD("`streamdata->file` provided was NULL -- exiting with error");
-    return CSV_ERROR;
-  }
+  /* the thread reads from the old file until it is stopped */
+  if (fr->readahead > 0) csv_file_stop_readahead(fr);
 
-  if ((c = getc(fr->file)) != EOF) {
-    *value = c;
-    ZF_LOGD("value: `%c` CSV_STREAM_SIGNAL: `CSV_GOOD`", (char)(*value));
-    return CSV_GOOD;
+  if (owned && (fr->file != NULL)) fclose(fr->file);
+
+  fr->file     = fileobj;
+  fr->filepath = filepath;
+  fr->size_f   = 0;
+  fr->start_f  = 0;
+  fr->size_r   = 0;
+
+  if ((fr->readahead > 0) && !csv_file_start_readahead(fr)) {
+    ZF_LOGD("read-ahead could not be restarted, reading synchronously");
+    fr->readahead = 0;
   }
+}
 
-  if (feof(fr->file)) {
-    ZF_LOGD("End of file indicator encountered");
-    *value = 0;
-    ZF_LOGD("value: `%c` CSV_STREAM_SIGNAL: `CSV_EOF`", (char)(*value));
-    return CSV_EOF;
+bool csv_file_start_readahead(csvfilereader fr) {
+  csvpipeline pipeline = NULL;
+
+  /* the file belongs to the reader, the pipeline does not close it */
+  if ((pipeline = csvpipeline_init(&csv_file_fill,
+                                   NULL,
+                                   NULL,
+                                   (csvstream_type)fr->file,
+                                   fr->readahead,
+                                   CSV_FILE_BLOCK_SIZE)) == NULL) {
+    ZF_LOGD("read-ahead pipeline could not be started");
+    return false;
   }
 
-  if (ferror(fr->file)) {
-    ZF_LOGI("IO Error Encountered");
-    *value = CSV_UNDEFINED_CHAR;
-    perror("Error detected while reading CSV");
-    ZF_LOGD("value: `%c` CSV_STREAM_SIGNAL: `CSV_ERROR`", (char)(*value));
+  fr->source_getnextblock = &csvpipeline_getnextblock;
+  fr->source_close        = &csvpipeline_close;
+  fr->source              = (csvstream_type)pipeline;
+  return true;
+}
+
+void csv_file_stop_readahead(csvfilereader fr) {
+  if (fr->source_close != NULL) (*fr->source_close)(fr->source);
+
+  fr->source_getnextblock = NULL;
+  fr->source_close        = NULL;
+  fr->source              = NULL;
+}
+
+CSV_STREAM_SIGNAL csv_file_fill(csvstream_type context,
+                                char *         buffer,
+                                size_t         capacity,
+                                size_t *       length) {
+  FILE *file = (FILE *)context;
+
+  if ((*length = fread(buffer, 1, capacity, file)) > 0) return CSV_GOOD;
+
+  if (ferror(file)) {
+    ZF_LOGE("IO Error Encountered");
     return CSV_ERROR;
   }
-
-  return CSV_GOOD;
+  return CSV_EOF;
 }
 
 void csv_file_appendchar(csvstream_type           streamdata,
                          csv_comparison_char_type value) {
-  ZF_LOGI("`csv_file_appendchar` called with value argument `%c`", (char)value);
+  ZF_LOGV("`csv_file_appendchar` called with value argument `%c`", (char)value);
 
   if (streamdata == NULL) {
     ZF_LOGD("`csvstream_type` provided was NULL, bad value");
@@ -726,133 +2171,159 @@ void csv_file_appendchar(csvstream_type           streamdata,
 
   csvfilereader fr = (csvfilereader)streamdata;
 
-  /* expand field, if neccessary. hopefully efficiently, needs validation */
-  if ((fr->size_f + 1) >= fr->capacity_f) {
-    ZF_LOGD(
-        "`csvfilereader` field size required exceeds capacity, calling "
-        "`realloc` to expand");
+  if (!csv_file_reserve(fr, 1)) return;
 
-    if (fr->capacity_f > 4096) {
-      ZF_LOGD("`csvfilereader` field is greater than 4KiB, expanding by 1KiB");
-      fr->capacity_f += 1024;
-    } else {
-      ZF_LOGD(
-          "`csvfilereader` field is less than 4KiB, doubling current "
-          "capacity");
-      fr->capacity_f *= 2;
-    }
-    fr->field = realloc(fr->field, (fr->capacity_f + 1));
-    ZF_LOGI("`csvfilereader` field reallocated to new size of: `%lu`",
-            (long unsigned)fr->capacity_f);
+  fr->field[fr->size_f++] = (char)value;
+}
 
-    memset((fr->field + fr->size_f), 0, ((fr->capacity_f + 1) - fr->size_f));
+void csv_file_appendslice(csvstream_type streamdata,
+                          const char *   data,
+                          size_t         length) {
+  ZF_LOGV("`csv_file_appendslice` called with `%lu` characters",
+          (long unsigned)length);
+
+  if (streamdata == NULL) {
+    ZF_LOGD("`csvstream_type` provided was NULL, bad value");
+    return;
   }
 
-  fr->field[fr->size_f++] = (char)value;
-  ZF_LOGD("Appending character to field: `%c` at position: `%lu`",
-          (char)value,
-          (long unsigned)fr->size_f);
+  csvfilereader fr = (csvfilereader)streamdata;
+
+  if (!csv_file_reserve(fr, length)) return;
+
+  memcpy(fr->field + fr->size_f, data, length);
+  fr->size_f += length;
 }
 
 void csv_file_savefield(csvstream_type streamdata) {
-  ZF_LOGI("`csv_file_savefield` called");
+  ZF_LOGV("`csv_file_savefield` called");
 
   if (streamdata == NULL) {
     ZF_LOGD("`csvstream_type` provided was NULL, bad value");
     return;
   }
 
-  csvfilereader fr   = (csvfilereader)streamdata;
-  char *        temp = NULL;
+  csvfilereader fr       = (csvfilereader)streamdata;
+  size_t *      record   = NULL;
+  csvfield *    view     = NULL;
+  size_t        capacity = fr->capacity_r;
 
-  /* grow field, if neccessary */
-  if ((fr->size_r + 1) >= fr->capacity_r) {
+  /* grow record, if neccessary */
+  if (fr->size_r >= fr->capacity_r) {
     ZF_LOGD(
         "`csvfilereader` record size required exceeds capacity, calling "
         "`realloc` to expand");
+    capacity *= 2;
+
+    record = csv_realloc(&fr->allocator, fr->record, sizeof *record * capacity);
+    if (record == NULL) {
+      ZF_LOGE("`csvfilereader` record could not be reallocated");
+      return;
+    }
+    fr->record = record;
 
-    if (fr->capacity_r > 128) {
-      ZF_LOGD(
-          "`csvfilereader` record capacity greater than 128, expanding by "
-          "128");
-      fr->capacity_r += 128;
-    } else {
-      ZF_LOGD(
-          "`csvfilereader` record capacity less than 128, doubling capacity");
-      fr->capacity_r *= 2;
+    view = csv_realloc(&fr->allocator, fr->view, sizeof *view * capacity);
+    if (view == NULL) {
+      ZF_LOGE("`csvfilereader` view could not be reallocated");
+      return;
     }
-    fr->record = realloc(fr->record, fr->capacity_r);
+    fr->view       = view;
+    fr->capacity_r = capacity;
     ZF_LOGI("`csvfilereader` record reallocated to new size of: `%lu`",
             (long unsigned)fr->capacity_r);
   }
 
-  if ((temp = calloc(fr->size_f + 1, sizeof *fr->field)) == NULL) {
-    ZF_LOGD("`csvfilereader` record field could not be allocated");
+  /* `csv_file_reserve` always leaves room for the terminator */
+  fr->field[fr->size_f++]  = '\0';
+  fr->record[fr->size_r++] = fr->start_f;
+  fr->start_f              = fr->size_f;
+}
+
+void csv_file_saverecordview(csvstream_type   streamdata,
+                             const csvfield **fields,
+                             size_t *         length) {
+  ZF_LOGV("`csv_file_saverecordview` called");
+
+  if (streamdata == NULL) {
+    ZF_LOGD("`csv_file_saverecordview` streamdata is NULL");
+    *fields = NULL;
+    *length = 0;
     return;
   }
 
-  /* copy up to the size of the current field */
-  ZF_LOGD("Beginning to copy field to temp");
-  memcpy(temp, fr->field, fr->size_f);
-  ZF_LOGD("Completed copying field to temp, value: `%s`", temp);
-  fr->record[fr->size_r] = temp;
-  fr->size_r += 1;
+  csvfilereader fr = (csvfilereader)streamdata;
+
+  for (size_t i = 0; i < fr->size_r; ++i) {
+    fr->view[i].data = fr->field + fr->record[i];
+    fr->view[i].len  = (((i + 1) < fr->size_r) ? fr->record[i + 1]
+                                                : fr->size_f) -
+                      fr->record[i] - 1;
+  }
+
+  *fields = fr->view;
+  *length = fr->size_r;
 
-  /* set field back to the beginning of the field */
-  fr->size_f = 0;
-  memset(fr->field, 0, fr->capacity_f);
-  ZF_LOGD("Reset field buffer to filled with \'\\0\' characters");
+  /* reset internal field and record index, the views stay valid until the
+   * next character is appended */
+  fr->size_f  = 0;
+  fr->start_f = 0;
+  fr->size_r  = 0;
 }
 
 void csv_file_saverecord(csvstream_type streamdata,
                          char ***       fields,
                          size_t *       length) {
   ZF_LOGI("`csv_file_saverecord` called");
+  const csvfield *view   = NULL;
+  char **         record = NULL;
+  csvfilereader   fr     = NULL;
 
-  if (streamdata == NULL) {
-    ZF_LOGD("`csv_file_saverecord` streamdata is NULL");
-    *fields = NULL;
-    *length = 0;
-    return;
-  }
+  csv_file_saverecordview(streamdata, &view, length);
+  *fields = NULL;
 
-  csvfilereader fr = (csvfilereader)streamdata;
+  if (view == NULL) return;
 
   /* allocate string array to pass the pointer list to caller */
-  char **record = NULL;
-  *length       = fr->size_r;
   ZF_LOGD("`csv_file_saverecord` record length `%lu`",
           (long unsigned)(*length));
 
-  if ((record = malloc(sizeof *record * fr->size_r)) == NULL) {
+  fr = (csvfilereader)streamdata;
+
+  if ((record = csv_malloc(&fr->allocator, sizeof *record * (*length))) ==
+      NULL) {
     ZF_LOGD("`csv_file_saverecord` record could not be allocated");
-    *fields = NULL;
     *length = 0;
     return;
   }
 
   ZF_LOGD("`csv_file_saverecord` copying records to output");
 
-  for (size_t i = 0; i < fr->size_r; ++i) {
-    record[i]     = fr->record[i];
-    fr->record[i] = NULL;
+  for (size_t i = 0; i < *length; ++i) {
+    if ((record[i] = csv_malloc(&fr->allocator, view[i].len + 1)) == NULL) {
+      ZF_LOGD("`csv_file_saverecord` record field could not be allocated");
+
+      while (i > 0) csv_free(&fr->allocator, record[--i]);
+      csv_free(&fr->allocator, record);
+      *length = 0;
+      return;
+    }
+    memcpy(record[i], view[i].data, view[i].len + 1);
     ZF_LOGV("`csv_file_saverecord` field: `%lu` value: `%s`",
             (long unsigned)i,
             record[i]);
   }
-  *fields = (char **)record;
-
-  /* reset internal field and record index */
-  fr->size_f = 0;
-  fr->size_r = 0;
-  memset(fr->field, 0, fr->capacity_f);
+  *fields = record;
 }
 
 void csv_read_filepath_close(csvstream_type streamdata) {
   ZF_LOGI("streamdata is %s", streamdata == NULL ? "NULL" : "NOT NULL");
 
   if (streamdata != NULL) {
-    csvfilereader fr = (csvfilereader)streamdata;
+    csvfilereader fr        = (csvfilereader)streamdata;
+    csvallocator  allocator = fr->allocator;
+
+    /* the read-ahead thread reads from the file until it is stopped */
+    if (fr->readahead > 0) csv_file_stop_readahead(fr);
 
     /* fr->filepath is allocated externally, not freed here because it could be
      *  a string literal */
@@ -863,23 +2334,25 @@ void csv_read_filepath_close(csvstream_type streamdata) {
 
     if (fr->field != NULL) {
       ZF_LOGD("field is not null, freeing");
-      free(fr->field);
+      csv_free(&allocator, fr->field);
+    }
+
+    if (fr->block != NULL) {
+      ZF_LOGD("block is not null, freeing");
+      csv_free(&allocator, fr->block);
     }
 
     if (fr->record != NULL) {
       ZF_LOGD("record is not null, freeing");
+      csv_free(&allocator, fr->record);
+    }
 
-      for (size_t i = 0; i < fr->size_r; ++i) {
-        if (fr->record[i] != NULL) {
-          ZF_LOGD("csvfilereader->record[%lu] is not null, freeing",
-                  (long unsigned)i);
-          free(fr->record[i]);
-        }
-      }
-      free(fr->record);
+    if (fr->view != NULL) {
+      ZF_LOGD("view is not null, freeing");
+      csv_free(&allocator, fr->view);
     }
 
-    free(fr);
+    csv_free(&allocator, fr);
   }
 }
 
@@ -887,7 +2360,10 @@ void csv_read_file_close(csvstream_type streamdata) {
   ZF_LOGI("streamdata is %s", streamdata == NULL ? "NULL" : "NOT NULL");
 
   if (streamdata != NULL) {
-    csvfilereader fr = (csvfilereader)streamdata;
+    csvfilereader fr        = (csvfilereader)streamdata;
+    csvallocator  allocator = fr->allocator;
+
+    if (fr->readahead > 0) csv_file_stop_readahead(fr);
 
     /* fr->filepath is allocated externally, not freed here because it could be
      *  a string literal */
@@ -896,22 +2372,38 @@ void csv_read_file_close(csvstream_type streamdata) {
 
     if (fr->field != NULL) {
       ZF_LOGD("field is not null, freeing");
-      free(fr->field);
+      csv_free(&allocator, fr->field);
+    }
+
+    if (fr->block != NULL) {
+      ZF_LOGD("block is not null, freeing");
+      csv_free(&allocator, fr->block);
     }
 
     if (fr->record != NULL) {
       ZF_LOGD("record is not null, freeing");
+      csv_free(&allocator, fr->record);
+    }
 
-      for (size_t i = 0; i < fr->size_r; ++i) {
-        if (fr->record[i] != NULL) {
-          ZF_LOGD("csvfilereader->record[%lu] is not null, freeing",
-                  (long unsigned)i);
-          free(fr->record[i]);
-        }
-      }
-      free(fr->record);
+    if (fr->view != NULL) {
+      ZF_LOGD("view is not null, freeing");
+      csv_free(&allocator, fr->view);
+    }
+    csv_free(&allocator, fr);
+  }
+}
+
+void csv_read_source_close(csvstream_type streamdata) {
+  ZF_LOGI("streamdata is %s", streamdata == NULL ? "NULL" : "NOT NULL");
+
+  if (streamdata != NULL) {
+    csvfilereader fr = (csvfilereader)streamdata;
+
+    if (fr->source_close != NULL) {
+      ZF_LOGD("source is set, closing");
+      (*fr->source_close)(fr->source);
     }
-    free(fr);
+    csv_read_file_close(streamdata);
   }
 }
 
@@ -924,13 +2416,15 @@ void csv_read_file_close(csvstream_type streamdata) {
  */
 csvreader _csvreader_init(csvdialect dialect) {
   ZF_LOGI("internal csvreader initializer");
-  csvreader reader = NULL;
+  csvreader           reader    = NULL;
+  const csvallocator *allocator = csvdialect_get_allocator(dialect);
 
-  if ((reader = malloc(sizeof *reader)) == NULL) {
+  if ((reader = csv_malloc(allocator, sizeof *reader)) == NULL) {
     ZF_LOGD("csvreader could not be allocated");
     return NULL;
   }
 
+  reader->allocator    = *allocator;
   reader->parser_state = START_RECORD;
 
   if (dialect == NULL) {
@@ -940,12 +2434,36 @@ csvreader _csvreader_init(csvdialect dialect) {
     ZF_LOGD("dialect supplied was NOT NULL, deep copying dialect");
     reader->dialect = csvdialect_copy(dialect);
   }
-  reader->streamdata  = NULL;
-  reader->getnextchar = NULL;
-  reader->appendchar  = NULL;
-  reader->savefield   = NULL;
-  reader->saverecord  = NULL;
-  reader->closer      = NULL;
+  reader->streamdata     = NULL;
+  reader->getnextchar    = NULL;
+  reader->getnextblock   = NULL;
+  reader->getnextrecord  = NULL;
+  reader->appendchar     = NULL;
+  reader->appendslice    = NULL;
+  reader->savefield      = NULL;
+  reader->saverecord     = NULL;
+  reader->saverecordview = NULL;
+  reader->closer         = NULL;
+  reader->block          = NULL;
+  reader->block_length   = 0;
+  reader->block_position = 0;
+
+  reader->projection        = NULL;
+  reader->projection_length = 0;
+  reader->field_index       = 0;
+  reader->keep_field        = true;
+  reader->filter            = NULL;
+  reader->filter_context    = NULL;
+  reader->view              = NULL;
+  reader->view_length       = 0;
+  reader->view_saved        = false;
+  reader->seek              = NULL;
+  reader->index             = NULL;
+  reader->block_offset      = 0;
+  reader->record_offset     = 0;
+  reader->record_state      = START_RECORD;
+
+  if (reader->dialect != NULL) csvreader_init_parser(reader);
 
   return reader;
 }
@@ -954,206 +2472,530 @@ csvreader _csvreader_init(csvdialect dialect) {
  * Begin of 'csv/read.h' implementations
  */
 
-/* bool controls 'should continue' (true) or should break switch (false) */
-bool parse_start_record(csvreader reader, csv_comparison_char_type value) {
-  ZF_LOGD("input value: %c", (char)value);
+csvtransition parse_transition(CSV_READER_PARSER_STATE state,
+                               CSV_READER_CHAR_CLASS   value_class,
+                               bool                    doublequote) {
+  csvtransition transition = {(unsigned char)state, ACTION_NONE};
 
-  if (value == '\0') {
-    ZF_LOGD("Empty record indicated");
+  if (value_class == CLASS_NUL) {
+    transition.actions = ACTION_ERROR;
+    return transition;
+  }
 
-    /* indicates empty record */
-    return false;
-  } else if ((value == '\n') || (value == '\r')) {
-    ZF_LOGD("\\r or \\n encountered at beginning of record, discarding");
-    reader->parser_state = EAT_CRNL;
-    ZF_LOGD("setting parser state to EAT_CRNL");
-    return false;
+  if (value_class == CLASS_QUOTE_ESCAPE) {
+    /* inside a field the escape takes precedence, otherwise the quote */
+    value_class = ((state == IN_FIELD) || (state == AFTER_ESCAPED_CRNL) ||
+                   (state == IN_QUOTED_FIELD))
+                      ? CLASS_ESCAPE
+                      : CLASS_QUOTE;
+  }
+
+  switch (state) {
+    case EAT_CRNL:
+    case START_RECORD:
+
+      /* further line terminators, or blank lines, start no record */
+      if (value_class == CLASS_NEWLINE) return transition;
+
+      /* else, treat as the start of the first field */
+
+      /* fall through */
+
+    case START_FIELD:
+      switch (value_class) {
+        case CLASS_NEWLINE:
+          transition.state   = EAT_CRNL;
+          transition.actions = ACTION_SAVE_FIELD | ACTION_END_RECORD;
+          break;
+        case CLASS_QUOTE: transition.state = IN_QUOTED_FIELD; break;
+        case CLASS_ESCAPE: transition.state = ESCAPED_CHAR; break;
+        case CLASS_SPACE: transition.state = START_FIELD; break;
+        case CLASS_DELIMITER:
+          /* end of field, so therefore empty/null field */
+          transition.state   = START_FIELD;
+          transition.actions = ACTION_SAVE_FIELD;
+          break;
+        default:
+          transition.state   = IN_FIELD;
+          transition.actions = ACTION_APPEND;
+          break;
+      }
+      break;
+
+    case ESCAPED_CHAR:
+      transition.state =
+          (value_class == CLASS_NEWLINE) ? AFTER_ESCAPED_CRNL : IN_FIELD;
+      transition.actions = ACTION_APPEND;
+      break;
+
+    case AFTER_ESCAPED_CRNL:
+    case IN_FIELD:
+      switch (value_class) {
+        case CLASS_NEWLINE:
+          transition.state   = EAT_CRNL;
+          transition.actions = ACTION_SAVE_FIELD | ACTION_END_RECORD;
+          break;
+        case CLASS_ESCAPE: transition.state = ESCAPED_CHAR; break;
+        case CLASS_DELIMITER:
+          transition.state   = START_FIELD;
+          transition.actions = ACTION_SAVE_FIELD;
+          break;
+        default:
+          transition.state   = IN_FIELD;
+          transition.actions = ACTION_APPEND;
+          break;
+      }
+      break;
+
+    case IN_QUOTED_FIELD:
+      switch (value_class) {
+        case CLASS_ESCAPE: transition.state = ESCAPE_IN_QUOTED_FIELD; break;
+        case CLASS_QUOTE:
+          transition.state = doublequote ? QUOTE_IN_QUOTED_FIELD : IN_FIELD;
+          break;
+        default: transition.actions = ACTION_APPEND; break;
+      }
+      break;
+
+    case ESCAPE_IN_QUOTED_FIELD:
+      transition.state   = IN_QUOTED_FIELD;
+      transition.actions = ACTION_APPEND;
+      break;
+
+    case QUOTE_IN_QUOTED_FIELD:
+      switch (value_class) {
+        case CLASS_QUOTE:
+          /* save "" as " */
+          transition.state   = IN_QUOTED_FIELD;
+          transition.actions = ACTION_APPEND;
+          break;
+        case CLASS_DELIMITER:
+          transition.state   = START_FIELD;
+          transition.actions = ACTION_SAVE_FIELD;
+          break;
+        case CLASS_NEWLINE:
+          transition.state   = EAT_CRNL;
+          transition.actions = ACTION_SAVE_FIELD | ACTION_END_RECORD;
+          break;
+        default:
+          /* lenient, treat the remainder as unquoted text in the same field */
+          transition.state   = IN_FIELD;
+          transition.actions = ACTION_APPEND;
+          break;
+      }
+      break;
+  }
+
+  return transition;
+}
+
+CSV_STREAM_SIGNAL parse_value(csvreader                reader,
+                              csv_comparison_char_type value) {
+  ZF_LOGV("input value: %c", (char)value);
+  CSV_READER_CHAR_CLASS value_class =
+      ((value >= 0) && (value <= UCHAR_MAX))
+          ? (CSV_READER_CHAR_CLASS)reader->classes[value]
+          : CLASS_OTHER;
+  csvtransition transition =
+      reader->transitions[reader->parser_state][value_class];
+
+  if (transition.actions & ACTION_ERROR) {
+    ZF_LOGI("line contains NULL byte");
+    return CSV_ERROR;
+  }
+
+  reader->parser_state = (CSV_READER_PARSER_STATE)transition.state;
+
+  if ((transition.actions & ACTION_APPEND) && reader->keep_field) {
+    (*reader->appendchar)(reader->streamdata, value);
+  }
+
+  if (transition.actions & ACTION_SAVE_FIELD) {
+    csvreader_savefield(reader, transition.actions & ACTION_END_RECORD);
+  }
+
+  return (transition.actions & ACTION_END_RECORD) ? CSV_EOR : CSV_GOOD;
+}
+
+bool parse_end_of_stream(csvreader reader) {
+  ZF_LOGD("parser state at end of stream: %s",
+          csv_reader_parser_state(reader->parser_state));
+
+  switch (reader->parser_state) {
+    case START_RECORD:
+    case EAT_CRNL: return false;
+
+    case ESCAPED_CHAR:
+    case ESCAPE_IN_QUOTED_FIELD:
+      /* dangling escape character, nothing left for it to escape */
+      ZF_LOGD("escape character at end of stream discarded");
+
+      /* fall through */
+
+    case START_FIELD:
+    case IN_FIELD:
+    case IN_QUOTED_FIELD:
+    case QUOTE_IN_QUOTED_FIELD:
+    case AFTER_ESCAPED_CRNL: break;
   }
 
-  /* normal character, handle as start field */
-  reader->parser_state = START_FIELD;
-  ZF_LOGD("setting parser state to START_FIELD");
+  csvreader_savefield(reader, true);
+  reader->parser_state = START_RECORD;
+  ZF_LOGD("setting parser state to START_RECORD");
   return true;
 }
 
-void parse_start_field(csvreader reader, csv_comparison_char_type value) {
-  ZF_LOGD("input value: %c", (char)value);
+csvreturn csvreader_parse_record(csvreader reader) {
+  csvreturn rc = csvreader_parse_next(reader);
+
+  reader->view_saved = false;
 
-  if ((value == '\0') || (value == '\n') || (value == '\r')) {
-    ZF_LOGD("encountered boundary character of \\0, \\r or \\n, saving field");
-    (*reader->savefield)(reader->streamdata);
+  if (reader->filter == NULL) return rc;
 
-    if (value == '\0') {
-      reader->parser_state = START_RECORD;
-      ZF_LOGD("setting parser state to START_RECORD");
-    } else {
-      reader->parser_state = EAT_CRNL;
-      ZF_LOGD("setting parser state to EAT_CRNL");
+  while (csv_success(rc) && !csvreader_filter_record(reader)) {
+    ZF_LOGV("record dropped by the filter");
+
+    if (rc.io_eof) {
+      rc.succeeded = 0;
+      return rc;
     }
-  } else if ((value == csvdialect_get_quotechar(reader->dialect)) &&
-             (QUOTE_STYLE_NONE == csvdialect_get_quotestyle(reader->dialect))) {
-    reader->parser_state = IN_QUOTED_FIELD;
-    ZF_LOGD("setting parser state to IN_QUOTED_FIELD");
-  } else if (value == csvdialect_get_escapechar(reader->dialect)) {
-    reader->parser_state = ESCAPED_CHAR;
-    ZF_LOGD("setting parser state to ESCAPED_CHAR");
-  } else if ((value == ' ') &&
-             csvdialect_get_skipinitialspace(reader->dialect)) {
-    // no change
-    return;
-  } else if (value == csvdialect_get_delimiter(reader->dialect)) {
-    /* end of field, so therefore empty/null field */
-    ZF_LOGD("encountered delimiter, saving field - no change in parser state");
-    (*reader->savefield)(reader->streamdata);
-  } else {
-    (*reader->appendchar)(reader->streamdata, value);
-    reader->parser_state = IN_FIELD;
-    ZF_LOGD("appending character to field");
-    ZF_LOGD("setting parser state to IN_FIELD");
+    rc = csvreader_parse_next(reader);
   }
+  return rc;
 }
 
-void parse_escaped_char(csvreader reader, csv_comparison_char_type value) {
-  ZF_LOGD("input value: %c", (char)value);
+bool csvreader_filter_record(csvreader reader) {
+  (*reader->saverecordview)(
+      reader->streamdata, &reader->view, &reader->view_length);
+  reader->view_saved = true;
 
-  if ((value == '\n') || (value == '\r')) {
-    (*reader->appendchar)(reader->streamdata, value);
-    reader->parser_state = AFTER_ESCAPED_CRNL;
-    ZF_LOGD("setting parser state to AFTER_ESCAPED_CRNL");
+  return (*reader->filter)(
+      reader->filter_context, reader->view, reader->view_length);
+}
+
+void csvreader_saverecordview(csvreader        reader,
+                              const csvfield **fields,
+                              size_t *         length) {
+  if (reader->view_saved) {
+    *fields            = reader->view;
+    *length            = reader->view_length;
+    reader->view_saved = false;
     return;
   }
+  (*reader->saverecordview)(reader->streamdata, fields, length);
+}
+
+csvreturn csvreader_parse_next(csvreader reader) {
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+  csvreturn         rc;
+
+  if (reader->getnextrecord != NULL) {
+    ZF_LOGD("Requesting record from `getnextrecord`");
+    signal = (*reader->getnextrecord)(reader->streamdata);
+  } else if (reader->getnextblock != NULL) {
+    ZF_LOGD("Beginning `getnextblock` loop");
+    signal = csvreader_parse_blocks(reader);
+  } else {
+    ZF_LOGD("Beginning `getnextchar` loop");
+    signal = csvreader_parse_chars(reader);
+  }
+
+  if (signal == CSV_EOR) {
+    ZF_LOGI("CSV Reader end of record, IO state is good");
+    reader->record_offset = reader->block_offset + reader->block_position;
+    reader->record_state  = reader->parser_state;
+    return csvreturn_init(true);
+  }
+
+  if (signal == CSV_EOF) {
+    ZF_LOGI("CSV Reader found EOF reached");
+    rc                    = csvreturn_init(parse_end_of_stream(reader));
+    rc.io_eof             = 1;
+    reader->record_offset = reader->block_offset;
+    reader->record_state  = reader->parser_state;
+    return rc;
+  }
 
-  if (value == '\0') value = '\n';
+  if (signal == CSV_AGAIN) {
+    ZF_LOGI("CSV Reader stream has no input available yet");
+    rc          = csvreturn_init(false);
+    rc.io_again = 1;
+    return rc;
+  }
 
-  (*reader->appendchar)(reader->streamdata, value);
-  reader->parser_state = IN_FIELD;
-  ZF_LOGD("setting parser state to IN_FIELD");
+  ZF_LOGI("CSV Reader found IO error state encountered");
+  rc          = csvreturn_init(false);
+  rc.io_error = 1;
+  return rc;
 }
 
-void parse_in_field(csvreader reader, csv_comparison_char_type value) {
-  ZF_LOGD("input value: %c", (char)value);
+CSV_STREAM_SIGNAL csvreader_parse_chars(csvreader reader) {
+  csv_comparison_char_type value  = 0;
+  CSV_STREAM_SIGNAL        signal = CSV_GOOD;
 
-  /* in unquoted field */
-  if ((value == '\n') || (value == '\r') || (value == '\0')) {
-    (*reader->savefield)(reader->streamdata);
+  while ((signal = (*reader->getnextchar)(reader->streamdata, &value)) ==
+         CSV_GOOD) {
+    ZF_LOGD("signal returned: `%d`, character returned: `%c`",
+            signal,
+            (char)value);
 
-    if (value == '\0') {
-      reader->parser_state = START_RECORD;
-      ZF_LOGD("setting parser state to START_RECORD");
-    } else {
-      reader->parser_state = EAT_CRNL;
-      ZF_LOGD("setting parser state to EAT_CRNL");
-    }
-  } else if (value == csvdialect_get_escapechar(reader->dialect)) {
-    reader->parser_state = ESCAPED_CHAR;
-    ZF_LOGD("setting parser state to ESCAPED_CHAR");
-  } else if (value == csvdialect_get_delimiter(reader->dialect)) {
-    (*reader->savefield)(reader->streamdata);
-    reader->parser_state = START_FIELD;
-    ZF_LOGD("setting parser state to START_FIELD");
-  } else {
-    (*reader->appendchar)(reader->streamdata, value);
+    signal = parse_value(reader, value);
+    if (signal != CSV_GOOD) return signal;
   }
+
+  ZF_LOGD("Signal indicates EOF or Error, ending loop");
+  return (signal == CSV_EOF) ? CSV_EOF : CSV_ERROR;
 }
 
-void parse_in_quoted_field(csvreader reader, csv_comparison_char_type value) {
-  ZF_LOGD("input value: %c", (char)value);
+CSV_STREAM_SIGNAL csvreader_parse_blocks(csvreader reader) {
+  CSV_STREAM_SIGNAL signal = CSV_GOOD;
+  unsigned char     value  = 0;
+  const char *      data   = NULL;
+  size_t            run    = 0;
+
+  while (true) {
+    while (reader->block_position < reader->block_length) {
+      data  = reader->block + reader->block_position;
+      value = (unsigned char)(*data);
+
+      switch (reader->parser_state) {
+        case EAT_CRNL:
+        case START_RECORD:
+        case START_FIELD:
+
+          if (!parse_starts_field_run(reader, value)) break;
+
+          reader->parser_state = IN_FIELD;
+          ZF_LOGD("setting parser state to IN_FIELD");
+
+          /* fall through */
 
-  if (value == '\0') { /* no-op */
-  } else if (value == csvdialect_get_escapechar(reader->dialect)) {
-    reader->parser_state = ESCAPE_IN_QUOTED_FIELD;
-    ZF_LOGD("setting parser state to ESCAPE_IN_QUOTED_FIELD");
-  } else if ((value == csvdialect_get_quotechar(reader->dialect)) &&
-             (QUOTE_STYLE_NONE != csvdialect_get_quotestyle(reader->dialect))) {
-    if (csvdialect_get_doublequote(reader->dialect)) {
-      reader->parser_state = ESCAPE_IN_QUOTED_FIELD;
-      ZF_LOGD("setting parser state to ESCAPE_IN_QUOTED_FIELD");
-    } else {
-      reader->parser_state = IN_FIELD;
-      ZF_LOGD("setting parser state to IN_FIELD");
+        case IN_FIELD:
+        case IN_QUOTED_FIELD:
+          run = parse_field_run(
+              reader, data, reader->block_length - reader->block_position);
+
+          if (run > 0) {
+            if (reader->keep_field) csvreader_appendslice(reader, data, run);
+            reader->block_position += run;
+            continue;
+          }
+          break;
+
+        default: break;
+      }
+
+      reader->block_position++;
+
+      signal = parse_value(reader, value);
+      if (signal != CSV_GOOD) return signal;
+    }
+
+    reader->block_offset += reader->block_length;
+
+    signal = (*reader->getnextblock)(
+        reader->streamdata, &reader->block, &reader->block_length);
+    reader->block_position = 0;
+    ZF_LOGD("signal returned: `%d`, block length returned: `%lu`",
+            signal,
+            (long unsigned)reader->block_length);
+
+    if (signal != CSV_GOOD) {
+      ZF_LOGD("Signal indicates EOF, Error or no input yet, ending loop");
+      reader->block        = NULL;
+      reader->block_length = 0;
+      if ((signal == CSV_EOF) || (signal == CSV_AGAIN)) return signal;
+      return CSV_ERROR;
     }
-  } else {
-    (*reader->appendchar)(reader->streamdata, value);
   }
 }
 
-void parse_quote_in_quoted_field(csvreader                reader,
-                                 csv_comparison_char_type value) {
-  ZF_LOGD("input value: %c", (char)value);
+bool csvreader_scan_block(csvreader   reader,
+                          const char *data,
+                          size_t      length,
+                          uint64_t *  records,
+                          uint64_t *  fields,
+                          csvindex *  index) {
+  CSV_READER_PARSER_STATE state = START_RECORD;
+  csvtransition           transition;
+  unsigned char           value;
+  size_t                  i = 0;
+
+  /* the last entry of an index is scanned again, it may have grown */
+  if ((index != NULL) && (index->size > 0)) {
+    index->size--;
+    i        = (size_t)index->offsets[index->size];
+    state    = (CSV_READER_PARSER_STATE)index->states[index->size];
+    *records = index->size * index->interval;
+
+    if (i > length) return false;
+  }
 
-  if ((csvdialect_get_quotestyle(reader->dialect) != QUOTE_STYLE_NONE) &&
-      (value == csvdialect_get_quotechar(reader->dialect))) {
-    /* save "" as " */
-    (*reader->appendchar)(reader->streamdata, value);
-    reader->parser_state = IN_QUOTED_FIELD;
-    ZF_LOGD("setting parser state to IN_QUOTED_FIELD");
-  } else if (value == csvdialect_get_delimiter(reader->dialect)) {
-    (*reader->savefield)(reader->streamdata);
-    reader->parser_state = START_FIELD;
-    ZF_LOGD("setting parser state to START_FIELD");
-  } else if ((value == '\0') || (value == '\r') || (value == '\n')) {
-    (*reader->savefield)(reader->streamdata);
-    reader->parser_state = START_FIELD;
-    ZF_LOGD("setting parser state to START_FIELD");
-  } else {
-    (*reader->savefield)(reader->streamdata);
-    reader->parser_state = (value == '\0') ? START_RECORD : EAT_CRNL;
-
-    if (value == '\0') {
-      reader->parser_state = START_RECORD;
-      ZF_LOGD("setting parser state to START_RECORD");
-    } else {
-      reader->parser_state = EAT_CRNL;
-      ZF_LOGD("setting parser state to EAT_CRNL");
+  while (i < length) {
+    value = (unsigned char)data[i];
+
+    /* anything but a blank line begins a record */
+    if ((index != NULL) && ((state == START_RECORD) || (state == EAT_CRNL)) &&
+        (reader->classes[value] != CLASS_NEWLINE) &&
+        (*records == index->size * index->interval) &&
+        !csvindex_append(index, i, state)) {
+      return false;
+    }
+
+    switch (state) {
+      case EAT_CRNL:
+      case START_RECORD:
+      case START_FIELD:
+        if (csvscanset_contains(&reader->field_starts, value)) break;
+
+        state = IN_FIELD;
+
+        /* fall through */
+
+      case IN_FIELD:
+        i += csvscanset_find(&reader->field_stops, data + i, length - i);
+        if (i == length) continue;
+
+        value = (unsigned char)data[i];
+        break;
+
+      case IN_QUOTED_FIELD:
+        i += csvscanset_find(&reader->quoted_stops, data + i, length - i);
+        if (i == length) continue;
+
+        value = (unsigned char)data[i];
+        break;
+
+      default: break;
     }
+
+    transition = reader->transitions[state][reader->classes[value]];
+
+    if (transition.actions & ACTION_ERROR) {
+      ZF_LOGI("line contains NULL byte");
+      return false;
+    }
+
+    state = (CSV_READER_PARSER_STATE)transition.state;
+    if (transition.actions & ACTION_SAVE_FIELD) ++(*fields);
+    if (transition.actions & ACTION_END_RECORD) ++(*records);
+    ++i;
   }
-}
 
-void parse_value(csvreader reader, csv_comparison_char_type value) {
-  ZF_LOGD("input value: %c", (char)value);
+  /* the final record is not terminated */
+  if ((state != START_RECORD) && (state != EAT_CRNL)) {
+    ++(*fields);
+    ++(*records);
+  }
+  return true;
+}
 
-  switch (reader->parser_state) {
-    case START_RECORD:
+size_t parse_field_run(csvreader reader, const char *data, size_t length) {
+  if (reader->parser_state == IN_QUOTED_FIELD) {
+    return csvscanset_find(&reader->quoted_stops, data, length);
+  }
+  return csvscanset_find(&reader->field_stops, data, length);
+}
 
-      if (!parse_start_record(reader, value)) break;
+bool parse_starts_field_run(csvreader reader, unsigned char value) {
+  return !csvscanset_contains(&reader->field_starts, value);
+}
 
-      /* else, fall through */
+void csvreader_init_parser(csvreader reader) {
+  csvdialect               dialect     = reader->dialect;
+  csv_comparison_char_type quotechar   = csvdialect_get_quotechar(dialect);
+  csv_comparison_char_type escapechar  = csvdialect_get_escapechar(dialect);
+  csv_comparison_char_type delimiter   = csvdialect_get_delimiter(dialect);
+  bool                     doublequote = csvdialect_get_doublequote(dialect);
 
-    case START_FIELD: parse_start_field(reader, value); break;
+  memset(reader->classes, CLASS_OTHER, sizeof reader->classes);
 
-    case ESCAPED_CHAR: parse_escaped_char(reader, value); break;
+  /* assigned in increasing order of precedence */
+  if (csvdialect_get_skipinitialspace(dialect)) {
+    reader->classes[' '] = CLASS_SPACE;
+  }
+  if ((delimiter >= 0) && (delimiter <= UCHAR_MAX)) {
+    reader->classes[delimiter] = CLASS_DELIMITER;
+  }
+  if ((escapechar >= 0) && (escapechar <= UCHAR_MAX)) {
+    reader->classes[escapechar] = CLASS_ESCAPE;
+  }
+  if ((quotechar >= 0) && (quotechar <= UCHAR_MAX) &&
+      (QUOTE_STYLE_NONE != csvdialect_get_quotestyle(dialect))) {
+    reader->classes[quotechar] =
+        (quotechar == escapechar) ? CLASS_QUOTE_ESCAPE : CLASS_QUOTE;
+  }
+  reader->classes['\n'] = CLASS_NEWLINE;
+  reader->classes['\r'] = CLASS_NEWLINE;
+  reader->classes['\0'] = CLASS_NUL;
+
+  for (int state = 0; state < CSV_READER_PARSER_STATE_COUNT; ++state) {
+    for (int value_class = 0; value_class < CLASS_COUNT; ++value_class) {
+      reader->transitions[state][value_class] =
+          parse_transition((CSV_READER_PARSER_STATE)state,
+                           (CSV_READER_CHAR_CLASS)value_class,
+                           doublequote);
+    }
+  }
 
-    case AFTER_ESCAPED_CRNL:
+  csvreader_init_scan_set(reader, &reader->field_stops, IN_FIELD, IN_FIELD);
+  csvreader_init_scan_set(
+      reader, &reader->quoted_stops, IN_QUOTED_FIELD, IN_QUOTED_FIELD);
+  csvreader_init_scan_set(reader, &reader->field_starts, START_FIELD, IN_FIELD);
 
-      if (value == '\0') break;
+  ZF_LOGI("CSV Reader structural scan using `%s` search",
+          csvscanset_name(&reader->field_stops));
+}
 
-      /* else, fallthrough */
+void csvreader_init_scan_set(csvreader               reader,
+                             csvscanset *            set,
+                             CSV_READER_PARSER_STATE state,
+                             CSV_READER_PARSER_STATE run_state) {
+  csv_comparison_char_type chars[CSV_SCAN_SET_SIZE];
+  csvtransition            transition;
+  size_t                   length = 0;
 
-    case IN_FIELD: parse_in_field(reader, value); break;
+  for (int value = 0; value <= UCHAR_MAX; ++value) {
+    transition = reader->transitions[state][reader->classes[value]];
 
-    case IN_QUOTED_FIELD:
+    if ((transition.actions == ACTION_APPEND) &&
+        (transition.state == run_state)) {
+      continue;
+    }
 
-      /* in a quoted field */
-      parse_in_quoted_field(reader, value);
+    if (length == CSV_SCAN_SET_SIZE) {
+      ZF_LOGE("too many structural characters for a scan set");
       break;
+    }
+    chars[length++] = value;
+  }
 
-    case ESCAPE_IN_QUOTED_FIELD:
+  csvscanset_init(set, chars, length);
+}
 
-      if (value == '\0') value = '\n';
-      (*reader->appendchar)(reader->streamdata, value);
-      reader->parser_state = IN_QUOTED_FIELD;
-      break;
+void csvreader_savefield(csvreader reader, bool end_record) {
+  if (reader->keep_field) (*reader->savefield)(reader->streamdata);
 
-    case QUOTE_IN_QUOTED_FIELD:
-      parse_quote_in_quoted_field(reader, value);
-      break;
+  reader->field_index = end_record ? 0 : reader->field_index + 1;
+  reader->keep_field  = csvreader_keeps_field(reader);
+}
 
-    case EAT_CRNL:
+bool csvreader_keeps_field(csvreader reader) {
+  return (reader->projection == NULL) ||
+         ((reader->field_index < reader->projection_length) &&
+          reader->projection[reader->field_index]);
+}
 
-      if (value != '\0') {
-        reader->parser_state = START_RECORD;
-      }
-      break;
+void csvreader_appendslice(csvreader reader, const char *data, size_t length) {
+  ZF_LOGV("appending run of `%lu` characters to field", (long unsigned)length);
+
+  if (reader->appendslice != NULL) {
+    (*reader->appendslice)(reader->streamdata, data, length);
+    return;
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    (*reader->appendchar)(reader->streamdata, (unsigned char)data[i]);
   }
 }
 
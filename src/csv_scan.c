@@ -0,0 +1,245 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_scan.c
+ * @author Robert W. Smith
+ * @brief Implementation of the structural character scanner
+ *
+ * Private documentation, API subject to change. Each vectorized search loads
+ * a chunk of the input, compares it against every character of the scan set,
+ * and collapses the comparisons into a bitmask with one bit per input byte.
+ * The lowest set bit is the next structural character. The tail of a block
+ * shorter than a chunk is finished by the scalar search, so no search reads
+ * past @p length.
+ *
+ * @see scan_private.h
+ */
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "csv.h"
+#include "scan_private.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CSV_SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/* compiled for AVX2 regardless of the target flags, used if the CPU allows */
+#define CSV_SCAN_AVX2 1
+#define CSV_SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define CSV_SCAN_AVX2 1
+#define CSV_SCAN_AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Portable search, one table lookup per character
+ */
+size_t csvscanset_find_scalar(const csvscanset *set,
+                              const char *      data,
+                              size_t            length);
+
+#ifdef CSV_SCAN_SSE2
+/**
+ * @brief SSE2 search, 32 characters per iteration
+ */
+size_t csvscanset_find_sse2(const csvscanset *set,
+                            const char *      data,
+                            size_t            length);
+#endif
+
+#ifdef CSV_SCAN_AVX2
+/**
+ * @brief AVX2 search, 32 characters per iteration
+ */
+size_t csvscanset_find_avx2(const csvscanset *set,
+                            const char *      data,
+                            size_t            length);
+#endif
+
+/**
+ * @brief Index of the lowest set bit of a non-zero @p mask
+ */
+static inline size_t csvscan_lowest_bit(uint32_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return (size_t)index;
+#else
+  return (size_t)__builtin_ctz(mask);
+#endif
+}
+
+/**
+ * @brief Whether the running CPU supports AVX2
+ */
+static bool csvscan_has_avx2(void) {
+#if defined(CSV_SCAN_AVX2) && defined(__GNUC__) && !defined(__AVX2__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#elif defined(CSV_SCAN_AVX2)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void csvscanset_init(csvscanset *                    set,
+                     const csv_comparison_char_type *chars,
+                     size_t                          length) {
+  unsigned char value = 0;
+
+  set->size = 0;
+  memset(set->table, 0, sizeof set->table);
+
+  for (size_t i = 0; i < length; ++i) {
+    if ((chars[i] < 0) || (chars[i] > UCHAR_MAX)) continue;
+
+    value = (unsigned char)chars[i];
+    if (set->table[value] || (set->size == CSV_SCAN_SET_SIZE)) continue;
+
+    set->table[value]       = true;
+    set->chars[set->size++] = value;
+  }
+
+  set->find = csvscanset_find_scalar;
+#ifdef CSV_SCAN_SSE2
+  set->find = csvscanset_find_sse2;
+#endif
+#ifdef CSV_SCAN_AVX2
+  if (csvscan_has_avx2()) set->find = csvscanset_find_avx2;
+#endif
+
+  ZF_LOGD("scan set of `%lu` characters using `%s` search",
+          (long unsigned)set->size,
+          csvscanset_name(set));
+}
+
+const char *csvscanset_name(const csvscanset *set) {
+#ifdef CSV_SCAN_AVX2
+  if (set->find == csvscanset_find_avx2) return "avx2";
+#endif
+#ifdef CSV_SCAN_SSE2
+  if (set->find == csvscanset_find_sse2) return "sse2";
+#endif
+  return "scalar";
+}
+
+size_t csvscanset_find_scalar(const csvscanset *set,
+                              const char *      data,
+                              size_t            length) {
+  const bool *table = set->table;
+  size_t      i     = 0;
+
+  for (; i + 4 <= length; i += 4) {
+    if (table[(unsigned char)data[i]]) return i;
+    if (table[(unsigned char)data[i + 1]]) return i + 1;
+    if (table[(unsigned char)data[i + 2]]) return i + 2;
+    if (table[(unsigned char)data[i + 3]]) return i + 3;
+  }
+
+  for (; i < length; ++i) {
+    if (table[(unsigned char)data[i]]) return i;
+  }
+  return length;
+}
+
+#ifdef CSV_SCAN_SSE2
+size_t csvscanset_find_sse2(const csvscanset *set,
+                            const char *      data,
+                            size_t            length) {
+  __m128i  needles[CSV_SCAN_SET_SIZE];
+  __m128i  lo, hi, hits_lo, hits_hi;
+  uint32_t mask = 0;
+  size_t   i    = 0;
+
+  if (set->size == 0) return length;
+
+  for (size_t k = 0; k < set->size; ++k) {
+    needles[k] = _mm_set1_epi8((char)set->chars[k]);
+  }
+
+  for (; i + 32 <= length; i += 32) {
+    lo      = _mm_loadu_si128((const __m128i *)(const void *)(data + i));
+    hi      = _mm_loadu_si128((const __m128i *)(const void *)(data + i + 16));
+    hits_lo = _mm_cmpeq_epi8(lo, needles[0]);
+    hits_hi = _mm_cmpeq_epi8(hi, needles[0]);
+
+    for (size_t k = 1; k < set->size; ++k) {
+      hits_lo = _mm_or_si128(hits_lo, _mm_cmpeq_epi8(lo, needles[k]));
+      hits_hi = _mm_or_si128(hits_hi, _mm_cmpeq_epi8(hi, needles[k]));
+    }
+
+    mask = (uint32_t)_mm_movemask_epi8(hits_lo) |
+           ((uint32_t)_mm_movemask_epi8(hits_hi) << 16);
+    if (mask != 0) return i + csvscan_lowest_bit(mask);
+  }
+
+  for (; i + 16 <= length; i += 16) {
+    lo      = _mm_loadu_si128((const __m128i *)(const void *)(data + i));
+    hits_lo = _mm_cmpeq_epi8(lo, needles[0]);
+
+    for (size_t k = 1; k < set->size; ++k) {
+      hits_lo = _mm_or_si128(hits_lo, _mm_cmpeq_epi8(lo, needles[k]));
+    }
+
+    mask = (uint32_t)_mm_movemask_epi8(hits_lo);
+    if (mask != 0) return i + csvscan_lowest_bit(mask);
+  }
+
+  return i + csvscanset_find_scalar(set, data + i, length - i);
+}
+#endif
+
+#ifdef CSV_SCAN_AVX2
+CSV_SCAN_AVX2_TARGET
+size_t csvscanset_find_avx2(const csvscanset *set,
+                            const char *      data,
+                            size_t            length) {
+  __m256i  needles[CSV_SCAN_SET_SIZE];
+  __m256i  chunk, hits;
+  uint32_t mask = 0;
+  size_t   i    = 0;
+
+  if (set->size == 0) return length;
+
+  for (size_t k = 0; k < set->size; ++k) {
+    needles[k] = _mm256_set1_epi8((char)set->chars[k]);
+  }
+
+  for (; i + 32 <= length; i += 32) {
+    chunk = _mm256_loadu_si256((const __m256i *)(const void *)(data + i));
+    hits  = _mm256_cmpeq_epi8(chunk, needles[0]);
+
+    for (size_t k = 1; k < set->size; ++k) {
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, needles[k]));
+    }
+
+    mask = (uint32_t)_mm256_movemask_epi8(hits);
+    if (mask != 0) return i + csvscan_lowest_bit(mask);
+  }
+
+  return i + csvscanset_find_scalar(set, data + i, length - i);
+}
+#endif
+
+/**
+ * @endcond
+ */
@@ -0,0 +1,505 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_sniff.c
+ * @author Robert W. Smith
+ * @brief Implementation of the CSV Dialect sniffer
+ *
+ * Private documentation, API subject to change. A sample is tokenized with
+ * the default dialect, then once for every other plausible combination of
+ * quote and escape character. Each pass jumps between structural characters
+ * with a @c csvscanset, so only the candidate delimiters, the quote character
+ * and line terminators are visited, and keeps a histogram per candidate
+ * delimiter of how many times it occurs in each record.
+ *
+ * The delimiter is the candidate which occurs the same, non-zero, number of
+ * times in the most records. Between passes the one whose delimiter is most
+ * consistent wins, then the one whose quoted fields end where a field does,
+ * then the one which found the most quoted fields, so a quote or escape
+ * character is only chosen if the sample reads better with it than with the
+ * default. A quote character only quotes a field it opens, elsewhere it is
+ * part of the field, as an apostrophe in a name.
+ *
+ * @see csv/dialect.h
+ * @see scan_private.h
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "dialect_private.h"
+#include "read_private.h"
+#include "scan_private.h"
+
+/**
+ * @brief Number of candidate delimiters
+ */
+#define CSV_SNIFF_DELIMITERS 5
+
+/**
+ * @brief Occurrences per record tracked by the histograms, higher counts
+ * share the last bucket
+ */
+#define CSV_SNIFF_COUNTS 64
+
+/**
+ * @brief Records after the first considered by @c csvdialect_sniff_header
+ */
+#define CSV_SNIFF_HEADER_RECORDS 20
+
+/**
+ * @brief Candidate delimiters, in order of preference
+ */
+static const csv_comparison_char_type
+    csvsniff_delimiters[CSV_SNIFF_DELIMITERS] = {',', '\t', ';', '|', ':'};
+
+/**
+ * @brief Statistics gathered by one pass over the sample
+ */
+typedef struct csv_sniff_pass {
+  csv_comparison_char_type quotechar;
+  csv_comparison_char_type escapechar;
+
+  /* complete, non-blank records */
+  uint64_t records;
+
+  /* records by the number of times each candidate occurs in them */
+  uint64_t histogram[CSV_SNIFF_DELIMITERS][CSV_SNIFF_COUNTS];
+
+  /* occurrences of each candidate, and of it followed by a space */
+  uint64_t total[CSV_SNIFF_DELIMITERS];
+  uint64_t spaced[CSV_SNIFF_DELIMITERS];
+
+  /* fields opened with the quote character, and those not closed at the end
+   * of the field */
+  uint64_t quoted;
+  uint64_t stray;
+
+  /* line terminators seen: "\n", "\r\n" and "\r" */
+  uint64_t terminators[3];
+
+  /* most consistent candidate and the records which agree on its count */
+  size_t   delimiter;
+  uint64_t agree;
+} csvsniffpass;
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Tokenize @p buf with @p quotechar and @p escapechar, filling @p pass
+ */
+void csvsniff_pass(const char *             buf,
+                   size_t                   len,
+                   csv_comparison_char_type quotechar,
+                   csv_comparison_char_type escapechar,
+                   csvsniffpass *           pass);
+
+/**
+ * @brief Choose the most consistent delimiter of @p pass
+ *
+ * @c delimiter is left at @c CSV_SNIFF_DELIMITERS if no candidate occurs in
+ * any record.
+ */
+void csvsniff_choose(csvsniffpass *pass);
+
+/**
+ * @brief Whether @p pass reads the sample better than @p best
+ */
+bool csvsniff_better(const csvsniffpass *pass, const csvsniffpass *best);
+
+/**
+ * @brief Whether @p escapechar is ever followed by @p quotechar in @p buf
+ */
+bool csvsniff_escapes(const char *             buf,
+                      size_t                   len,
+                      csv_comparison_char_type quotechar,
+                      csv_comparison_char_type escapechar);
+
+/**
+ * @brief Whether @p field reads as a decimal or floating point number
+ */
+bool csvsniff_numeric(const csvfield *field);
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreturn csvdialect_sniff(const char *buf, size_t len, csvdialect *out) {
+  ZF_LOGI("sniffing `%lu` characters", (long unsigned)len);
+  static const csv_comparison_char_type quotes[]  = {'"', '\''};
+  static const csv_comparison_char_type escapes[] = {CSV_UNDEFINED_CHAR, '\\'};
+  static const char *const terminators[] = {"\n", "\r\n", "\r"};
+  csvsniffpass *           best          = NULL;
+  csvsniffpass *           pass          = NULL;
+  csvsniffpass *           swap          = NULL;
+  csvdialect               dialect       = NULL;
+  size_t                   terminator    = 0;
+  size_t                   d             = 0;
+  csvreturn                rc            = csvreturn_init(false);
+
+  if ((buf == NULL) || (out == NULL)) {
+    ZF_LOGE("`csvdialect_sniff` needs a sample and an output dialect");
+    return rc;
+  }
+
+  if (((best = csv_calloc(NULL, 1, sizeof *best)) == NULL) ||
+      ((pass = csv_calloc(NULL, 1, sizeof *pass)) == NULL)) {
+    ZF_LOGE("`csvsniffpass` could not be allocated");
+    csv_free(NULL, best);
+    return rc;
+  }
+
+  /* the default dialect, which every other pass has to read better than */
+  csvsniff_pass(buf, len, quotes[0], escapes[0], best);
+  csvsniff_choose(best);
+
+  for (size_t q = 0; q < sizeof quotes / sizeof *quotes; ++q) {
+    if (memchr(buf, (int)quotes[q], len) == NULL) continue;
+
+    for (size_t e = 0; e < sizeof escapes / sizeof *escapes; ++e) {
+      if (((q == 0) && (e == 0)) ||
+          ((escapes[e] != CSV_UNDEFINED_CHAR) &&
+           !csvsniff_escapes(buf, len, quotes[q], escapes[e]))) {
+        continue;
+      }
+
+      csvsniff_pass(buf, len, quotes[q], escapes[e], pass);
+      csvsniff_choose(pass);
+
+      if (csvsniff_better(pass, best)) {
+        swap = best;
+        best = pass;
+        pass = swap;
+      }
+    }
+  }
+
+  if ((d = best->delimiter) == CSV_SNIFF_DELIMITERS) {
+    ZF_LOGE("no delimiter found in `%lu` records",
+            (long unsigned)best->records);
+    rc.delimiter_error = 1;
+    csv_free(NULL, best);
+    csv_free(NULL, pass);
+    return rc;
+  }
+
+  for (size_t t = 1; t < sizeof terminators / sizeof *terminators; ++t) {
+    if (best->terminators[t] > best->terminators[terminator]) terminator = t;
+  }
+
+  ZF_LOGD("delimiter `%c` quotechar `%c` escapechar `%c` agree `%lu/%lu`",
+          (char)csvsniff_delimiters[d],
+          (char)best->quotechar,
+          (char)best->escapechar,
+          (long unsigned)best->agree,
+          (long unsigned)best->records);
+
+  if ((dialect = *out) == NULL) dialect = csvdialect_init();
+
+  /* each setter only fails for a NULL dialect */
+  if (csv_success(csvdialect_set_delimiter(dialect, csvsniff_delimiters[d])) &&
+      csv_success(csvdialect_set_quotechar(dialect, best->quotechar)) &&
+      csv_success(csvdialect_set_escapechar(dialect, best->escapechar)) &&
+      csv_success(csvdialect_set_doublequote(
+          dialect, best->escapechar == CSV_UNDEFINED_CHAR)) &&
+      csv_success(csvdialect_set_skipinitialspace(
+          dialect, best->spaced[d] == best->total[d])) &&
+      ((best->terminators[terminator] == 0) ||
+       csv_success(csvdialect_set_lineterminator(
+           dialect, terminators[terminator], 0)))) {
+    rc   = csvreturn_init(true);
+    *out = dialect;
+  } else if ((*out == NULL) && (dialect != NULL)) {
+    ZF_LOGE("sniffed dialect could not be set");
+    csvdialect_close(&dialect);
+  }
+
+  csv_free(NULL, best);
+  csv_free(NULL, pass);
+  return rc;
+}
+
+csvreturn csvdialect_sniff_header(csvdialect  dialect,
+                                  const char *buf,
+                                  size_t      len,
+                                  bool *      header) {
+  ZF_LOGI("sniffing a header in `%lu` characters", (long unsigned)len);
+  const csvfield *fields  = NULL;
+  size_t          length  = 0;
+  size_t          columns = 0;
+  size_t          rows    = 0;
+  bool *          numeric = NULL;
+  size_t *        widths  = NULL;
+  size_t *        lengths = NULL;
+  csvreader       reader  = NULL;
+  int             votes   = 0;
+  csvreturn       rc      = csvreturn_init(false);
+
+  if ((buf == NULL) || (header == NULL)) {
+    ZF_LOGE("`csvdialect_sniff_header` needs a sample and an output flag");
+    return rc;
+  }
+
+  *header = false;
+
+  /* a final line without a terminator may be cut off */
+  while ((len > 0) && (buf[len - 1] != '\n') && (buf[len - 1] != '\r')) {
+    --len;
+  }
+
+  if ((reader = csvreader_memory_init(dialect, buf, len)) == NULL) {
+    ZF_LOGE("`csvreader` could not be allocated");
+    return rc;
+  }
+
+  rc = csvreader_next_record_view(reader, &fields, &length);
+  if (csv_failure(rc) || (length == 0)) {
+    csvreader_close(&reader);
+    return csvreturn_init(false);
+  }
+
+  columns = length;
+  if (((numeric = csv_malloc(NULL, columns * 2 * sizeof *numeric)) == NULL) ||
+      ((widths = csv_malloc(NULL, columns * 2 * sizeof *widths)) == NULL)) {
+    ZF_LOGE("column statistics could not be allocated");
+    csv_free(NULL, numeric);
+    csvreader_close(&reader);
+    return csvreturn_init(false);
+  }
+  lengths = widths + columns;
+
+  /* the candidate header, then what every other record agrees on */
+  for (size_t i = 0; i < columns; ++i) {
+    numeric[i]           = csvsniff_numeric(&fields[i]);
+    widths[i]            = fields[i].len;
+    numeric[columns + i] = true;
+    lengths[i]           = SIZE_MAX;
+  }
+
+  while ((rows < CSV_SNIFF_HEADER_RECORDS) && !rc.io_eof) {
+    rc = csvreader_next_record_view(reader, &fields, &length);
+    if (csv_failure(rc)) break;
+
+    /* ragged records say nothing about the columns */
+    if (length != columns) continue;
+
+    for (size_t i = 0; i < columns; ++i) {
+      numeric[columns + i] &= csvsniff_numeric(&fields[i]);
+
+      if (rows == 0) {
+        lengths[i] = fields[i].len;
+      } else if (lengths[i] != fields[i].len) {
+        lengths[i] = SIZE_MAX - 1;
+      }
+    }
+    ++rows;
+  }
+
+  /* a column votes for a header if its first value does not fit */
+  for (size_t i = 0; (rows > 0) && (i < columns); ++i) {
+    if (numeric[columns + i]) {
+      votes += numeric[i] ? -1 : 1;
+    } else if (lengths[i] < SIZE_MAX - 1) {
+      votes += (widths[i] != lengths[i]) ? 1 : -1;
+    }
+  }
+
+  ZF_LOGD("`%d` votes for a header over `%lu` records",
+          votes,
+          (long unsigned)rows);
+
+  csv_free(NULL, numeric);
+  csv_free(NULL, widths);
+  csvreader_close(&reader);
+
+  if (rows == 0) {
+    ZF_LOGE("a header cannot be told apart without other records");
+    return csvreturn_init(false);
+  }
+
+  *header = (votes > 0);
+  return csvreturn_init(true);
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+void csvsniff_pass(const char *             buf,
+                   size_t                   len,
+                   csv_comparison_char_type quotechar,
+                   csv_comparison_char_type escapechar,
+                   csvsniffpass *           pass) {
+  const csv_comparison_char_type outside[] = {
+      ',', '\t', ';', '|', ':', quotechar, '\r', '\n'};
+  const csv_comparison_char_type inside[] = {quotechar, escapechar};
+  csvscanset                     unquoted;
+  csvscanset                     quoted;
+  uint64_t                       counts[CSV_SNIFF_DELIMITERS] = {0};
+  bool                           in_quote                     = false;
+  size_t                         start                        = 0;
+  size_t                         i                            = 0;
+  unsigned char                  value;
+
+  memset(pass, 0, sizeof *pass);
+  pass->quotechar  = quotechar;
+  pass->escapechar = escapechar;
+  pass->delimiter  = CSV_SNIFF_DELIMITERS;
+
+  csvscanset_init(&unquoted, outside, sizeof outside / sizeof *outside);
+  csvscanset_init(&quoted, inside, sizeof inside / sizeof *inside);
+
+  while (i < len) {
+    if (in_quote) {
+      if ((i += csvscanset_find(&quoted, buf + i, len - i)) >= len) break;
+
+      if ((unsigned char)buf[i] == escapechar) {
+        i += 2;
+      } else if ((escapechar == CSV_UNDEFINED_CHAR) && (i + 1 < len) &&
+                 ((unsigned char)buf[i + 1] == quotechar)) {
+        i += 2;
+      } else {
+        in_quote = false;
+        if ((++i < len) &&
+            !csvscanset_contains(&unquoted, (unsigned char)buf[i])) {
+          pass->stray++;
+        }
+      }
+      continue;
+    }
+
+    if ((i += csvscanset_find(&unquoted, buf + i, len - i)) >= len) break;
+    value = (unsigned char)buf[i];
+
+    if (value == quotechar) {
+      /* within a field the quote character is an ordinary one */
+      if ((i == start) ||
+          csvscanset_contains(&unquoted, (unsigned char)buf[i - 1])) {
+        in_quote = true;
+        pass->quoted++;
+      }
+      ++i;
+      continue;
+    }
+
+    if ((value == '\r') || (value == '\n')) {
+      if (i > start) {
+        pass->records++;
+        for (size_t d = 0; d < CSV_SNIFF_DELIMITERS; ++d) {
+          if (counts[d] >= CSV_SNIFF_COUNTS) counts[d] = CSV_SNIFF_COUNTS - 1;
+          pass->histogram[d][counts[d]]++;
+          counts[d] = 0;
+        }
+      }
+
+      if (value == '\n') {
+        pass->terminators[0]++;
+      } else if ((i + 1 < len) && (buf[i + 1] == '\n')) {
+        pass->terminators[1]++;
+        ++i;
+      } else {
+        pass->terminators[2]++;
+      }
+      start = ++i;
+      continue;
+    }
+
+    for (size_t d = 0; d < CSV_SNIFF_DELIMITERS; ++d) {
+      if (value != csvsniff_delimiters[d]) continue;
+
+      counts[d]++;
+      pass->total[d]++;
+      if ((i + 1 < len) && (buf[i + 1] == ' ')) pass->spaced[d]++;
+    }
+    ++i;
+  }
+  /* a final record without a line terminator may be cut off, so is ignored */
+}
+
+void csvsniff_choose(csvsniffpass *pass) {
+  uint64_t agree = 0;
+
+  for (size_t d = 0; d < CSV_SNIFF_DELIMITERS; ++d) {
+    agree = 0;
+
+    /* the modal number of occurrences, never zero */
+    for (size_t n = 1; n < CSV_SNIFF_COUNTS; ++n) {
+      if (pass->histogram[d][n] > agree) agree = pass->histogram[d][n];
+    }
+
+    if (agree > pass->agree) {
+      pass->agree     = agree;
+      pass->delimiter = d;
+    }
+  }
+}
+
+bool csvsniff_better(const csvsniffpass *pass, const csvsniffpass *best) {
+  uint64_t lhs = pass->agree * best->records;
+  uint64_t rhs = best->agree * pass->records;
+
+  if (pass->delimiter == CSV_SNIFF_DELIMITERS) return false;
+  if (best->delimiter == CSV_SNIFF_DELIMITERS) return true;
+  if (lhs != rhs) return lhs > rhs;
+  if (pass->stray != best->stray) return pass->stray < best->stray;
+  return pass->quoted > best->quoted;
+}
+
+bool csvsniff_escapes(const char *             buf,
+                      size_t                   len,
+                      csv_comparison_char_type quotechar,
+                      csv_comparison_char_type escapechar) {
+  const char *found = buf;
+  const char *end   = buf + len;
+
+  while ((found = memchr(found, (int)escapechar, (size_t)(end - found))) !=
+         NULL) {
+    if (++found == end) break;
+    if ((unsigned char)*found == quotechar) return true;
+  }
+  return false;
+}
+
+bool csvsniff_numeric(const csvfield *field) {
+  const char *data   = field->data;
+  const char *end    = field->data + field->len;
+  bool        digits = false;
+
+  if ((data < end) && ((*data == '-') || (*data == '+'))) ++data;
+  for (; (data < end) && (*data >= '0') && (*data <= '9'); ++data) {
+    digits = true;
+  }
+
+  if ((data < end) && (*data == '.')) {
+    for (++data; (data < end) && (*data >= '0') && (*data <= '9'); ++data) {
+      digits = true;
+    }
+  }
+
+  if (digits && (data < end) && ((*data == 'e') || (*data == 'E'))) {
+    if ((++data < end) && ((*data == '-') || (*data == '+'))) ++data;
+
+    digits = false;
+    for (; (data < end) && (*data >= '0') && (*data <= '9'); ++data) {
+      digits = true;
+    }
+  }
+  return digits && (data == end);
+}
+
+/**
+ * @endcond
+ */
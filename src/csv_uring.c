@@ -0,0 +1,576 @@
+/**
+ * @cond INTERNAL
+ *
+ * @file csv_uring.c
+ * @author Robert W. Smith
+ * @brief Implementation of the io_uring CSV Reader
+ *
+ * Private documentation, API subject to change. A ring of large, page aligned
+ * buffers is kept in flight as io_uring reads, block `b` of the file being
+ * read into `buffers[b % blocks]`. The parser is handed the blocks in file
+ * order, and releasing a block queues the read of the block which reuses its
+ * buffer. The ring is driven through the raw system calls, no library is
+ * needed.
+ *
+ * Where io_uring is unavailable, either at build time (@c CSV_HAVE_URING not
+ * defined) or at run time, including kernels without @c IORING_OP_READ, the
+ * reader made by @c csvreader_init is returned.
+ *
+ * Under @c O_DIRECT the rest of a short read is read again from the last
+ * aligned offset before it, as the kernel refuses unaligned reads.
+ *
+ * @see csv/read.h
+ * @see read_private.h
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef CSV_HAVE_URING
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "csv.h"
+#include "alloc_private.h"
+#include "read_private.h"
+
+#ifdef CSV_HAVE_URING
+
+/*
+ * reads kept in flight
+ */
+#define CSV_URING_BLOCKS 8
+
+/*
+ * size of each read, a multiple of any logical block size for O_DIRECT
+ */
+#define CSV_URING_BLOCK_SIZE ((size_t)1 << 20)
+
+/*
+ * alignment of the buffers for O_DIRECT
+ */
+#define CSV_URING_ALIGNMENT ((size_t)4096)
+
+typedef struct csv_uring_source *csvuringsource;
+
+struct csv_uring_source {
+  int      file;
+  int      ring;
+  uint64_t size;   /* file size when it was opened */
+  bool     direct; /* the file is opened with O_DIRECT */
+
+  /* submission queue, shared with the kernel */
+  void *               sq_ring;
+  size_t               sq_ring_size;
+  unsigned *           sq_tail;
+  unsigned *           sq_mask;
+  unsigned *           sq_array;
+  struct io_uring_sqe *sqes;
+  size_t               sqes_size;
+
+  /* completion queue, shared with the kernel */
+  void *               cq_ring;
+  size_t               cq_ring_size;
+  unsigned *           cq_head;
+  unsigned *           cq_tail;
+  unsigned *           cq_mask;
+  struct io_uring_cqe *cqes;
+
+  /* block `b` is read into `buffers[b % blocks]` */
+  char ** buffers;
+  size_t *lengths;  /* characters read into each buffer so far */
+  int *   results;  /* negative errno of a failed read */
+  bool *  complete; /* the buffer holds its whole block */
+
+  size_t consumed; /* blocks released by the parser */
+  size_t skip;     /* characters of block `consumed` before a seek offset */
+  size_t inflight; /* reads submitted and not yet reaped */
+  bool   held;     /* the parser holds block `consumed` */
+};
+
+/*
+ * private forward declarations
+ */
+
+/**
+ * @brief Open the file and map the submission and completion queues
+ *
+ * @return source with its first reads queued, or NULL if the file could not
+ *         be opened or io_uring is unavailable
+ */
+csvuringsource csv_uring_open(const char *filepath, bool direct);
+
+/**
+ * @brief Whether the kernel supports @c IORING_OP_READ on @p ring
+ */
+bool csv_uring_probe(int ring);
+
+/**
+ * @brief Queue the read of the rest of block @p b, from @p done characters in
+ *
+ * Under @c O_DIRECT @p done is rounded down to @c CSV_URING_ALIGNMENT.
+ */
+bool csv_uring_submit(csvuringsource source, size_t b, size_t done);
+
+/**
+ * @brief Queue the reads of up to @c CSV_URING_BLOCKS blocks from @p first
+ */
+bool csv_uring_fill(csvuringsource source, size_t first);
+
+/**
+ * @brief Reap one completion, waiting for it if none is ready
+ *
+ * A short read which did not reach the end of the file is queued again for the
+ * rest of its block.
+ *
+ * @return @c false if waiting or resubmitting failed
+ */
+bool csv_uring_reap(csvuringsource source);
+
+/**
+ * @brief Hand the next block to the parser in file order
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csv_uring_getnextblock(csvstream_type streamdata,
+                                         const char **  block,
+                                         size_t *       length);
+
+/**
+ * @brief Drain the reads in flight and restart them at @p offset
+ *
+ * @see csvstream_seek
+ */
+bool csv_uring_seek(csvstream_type streamdata, uint64_t offset);
+
+/**
+ * @brief Drain the reads in flight and release the ring, buffers and file
+ *
+ * @see csvstream_close
+ */
+void csv_uring_close(csvstream_type streamdata);
+
+#endif /* CSV_HAVE_URING */
+
+/*
+ * end of private forward declarations
+ */
+
+/*
+ * API implementation
+ */
+csvreader csvreader_uring_init(csvdialect  dialect,
+                               const char *filepath,
+                               bool        direct) {
+  ZF_LOGI("Initiailizing io_uring CSV Reader from filepath `%s`", filepath);
+
+#ifdef CSV_HAVE_URING
+  csvuringsource source = NULL;
+
+  if ((filepath != NULL) &&
+      ((source = csv_uring_open(filepath, direct)) != NULL)) {
+    /* releases the source on failure */
+    return csvreader_source_init(dialect,
+                                 &csv_uring_getnextblock,
+                                 &csv_uring_seek,
+                                 &csv_uring_close,
+                                 (csvstream_type)source);
+  }
+#else
+  (void)direct;
+#endif /* CSV_HAVE_URING */
+
+  ZF_LOGW("io_uring reader unavailable, reading `%s` with stdio", filepath);
+  return csvreader_init(dialect, filepath);
+}
+
+/*
+ * end of API implementations
+ */
+
+/*
+ * private implementations
+ */
+#ifdef CSV_HAVE_URING
+csvuringsource csv_uring_open(const char *filepath, bool direct) {
+  struct io_uring_params params;
+  struct stat            status;
+  csvuringsource         source = NULL;
+  char *                 sq     = NULL;
+  char *                 cq     = NULL;
+
+  if ((source = csv_calloc(NULL, 1, sizeof *source)) == NULL) {
+    ZF_LOGE("`csvuringsource` could not be allocated");
+    return NULL;
+  }
+
+  source->ring    = -1;
+  source->sq_ring = MAP_FAILED;
+  source->cq_ring = MAP_FAILED;
+  source->sqes    = MAP_FAILED;
+
+  /* file systems without O_DIRECT support refuse to open with it */
+  source->file   = direct ? open(filepath, O_RDONLY | O_DIRECT) : -1;
+  source->direct = (source->file >= 0);
+  if (source->file < 0) source->file = open(filepath, O_RDONLY);
+
+  if ((source->file < 0) || (fstat(source->file, &status) != 0)) {
+    ZF_LOGE("`%s` could not be opened", filepath);
+    csv_uring_close((csvstream_type)source);
+    return NULL;
+  }
+  source->size = (uint64_t)status.st_size;
+
+  memset(&params, 0, sizeof params);
+  source->ring =
+      (int)syscall(__NR_io_uring_setup, CSV_URING_BLOCKS * 2, &params);
+
+  if (source->ring < 0) {
+    ZF_LOGD("io_uring could not be set up: `%s`", strerror(errno));
+    csv_uring_close((csvstream_type)source);
+    return NULL;
+  }
+
+  if (!csv_uring_probe(source->ring)) {
+    ZF_LOGD("io_uring does not support `IORING_OP_READ`");
+    csv_uring_close((csvstream_type)source);
+    return NULL;
+  }
+
+  source->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  source->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  /* newer kernels map both queues with the submission queue */
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (source->cq_ring_size > source->sq_ring_size) {
+      source->sq_ring_size = source->cq_ring_size;
+    }
+    source->cq_ring_size = 0;
+  }
+
+  source->sq_ring = mmap(NULL,
+                         source->sq_ring_size,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED,
+                         source->ring,
+                         IORING_OFF_SQ_RING);
+
+  if ((source->sq_ring != MAP_FAILED) && (source->cq_ring_size == 0)) {
+    source->cq_ring = source->sq_ring;
+  } else if (source->sq_ring != MAP_FAILED) {
+    source->cq_ring = mmap(NULL,
+                           source->cq_ring_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED,
+                           source->ring,
+                           IORING_OFF_CQ_RING);
+  }
+
+  source->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  source->sqes      = mmap(NULL,
+                           source->sqes_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED,
+                           source->ring,
+                           IORING_OFF_SQES);
+
+  if ((source->sq_ring == MAP_FAILED) || (source->cq_ring == MAP_FAILED) ||
+      (source->sqes == MAP_FAILED)) {
+    ZF_LOGD("io_uring queues could not be mapped");
+    csv_uring_close((csvstream_type)source);
+    return NULL;
+  }
+
+  sq               = (char *)source->sq_ring;
+  cq               = (char *)source->cq_ring;
+  source->sq_tail  = (unsigned *)(sq + params.sq_off.tail);
+  source->sq_mask  = (unsigned *)(sq + params.sq_off.ring_mask);
+  source->sq_array = (unsigned *)(sq + params.sq_off.array);
+  source->cq_head  = (unsigned *)(cq + params.cq_off.head);
+  source->cq_tail  = (unsigned *)(cq + params.cq_off.tail);
+  source->cq_mask  = (unsigned *)(cq + params.cq_off.ring_mask);
+  source->cqes     = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+  if (((source->buffers =
+            csv_calloc(NULL, CSV_URING_BLOCKS, sizeof(char *))) == NULL) ||
+      ((source->lengths =
+            csv_calloc(NULL, CSV_URING_BLOCKS, sizeof(size_t))) == NULL) ||
+      ((source->results = csv_calloc(NULL, CSV_URING_BLOCKS, sizeof(int))) ==
+       NULL) ||
+      ((source->complete =
+            csv_calloc(NULL, CSV_URING_BLOCKS, sizeof(bool))) == NULL)) {
+    ZF_LOGE("`csvuringsource` ring could not be allocated");
+    csv_uring_close((csvstream_type)source);
+    return NULL;
+  }
+
+  for (size_t b = 0; b < CSV_URING_BLOCKS; ++b) {
+    if (posix_memalign((void **)&source->buffers[b],
+                       CSV_URING_ALIGNMENT,
+                       CSV_URING_BLOCK_SIZE) != 0) {
+      source->buffers[b] = NULL;
+      ZF_LOGE("`csvuringsource` buffer could not be allocated");
+      csv_uring_close((csvstream_type)source);
+      return NULL;
+    }
+  }
+
+  if (!csv_uring_fill(source, 0)) {
+    csv_uring_close((csvstream_type)source);
+    return NULL;
+  }
+  return source;
+}
+
+bool csv_uring_probe(int ring) {
+  struct io_uring_probe *probe  = NULL;
+  size_t                 ops    = 256;
+  size_t                 size   = 0;
+  bool                   result = false;
+
+  size = sizeof *probe + ops * sizeof(struct io_uring_probe_op);
+  if ((probe = csv_calloc(NULL, 1, size)) == NULL) {
+    ZF_LOGE("`io_uring_probe` could not be allocated");
+    return false;
+  }
+
+  /* kernels before the probe, and before IORING_OP_READ, refuse it */
+  if (syscall(__NR_io_uring_register,
+              ring,
+              IORING_REGISTER_PROBE,
+              probe,
+              (unsigned)ops) == 0) {
+    result = (probe->ops_len > IORING_OP_READ) &&
+             ((probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0);
+  }
+
+  csv_free(NULL, probe);
+  return result;
+}
+
+bool csv_uring_submit(csvuringsource source, size_t b, size_t done) {
+  size_t               slot  = b % CSV_URING_BLOCKS;
+  unsigned             tail  = *source->sq_tail;
+  unsigned             index = tail & *source->sq_mask;
+  struct io_uring_sqe *sqe   = &source->sqes[index];
+
+  if (done == 0) {
+    source->results[slot]  = 0;
+    source->complete[slot] = false;
+  }
+
+  /* the characters after the aligned offset are read again */
+  if (source->direct) done -= done % CSV_URING_ALIGNMENT;
+  source->lengths[slot] = done;
+
+  memset(sqe, 0, sizeof *sqe);
+  sqe->opcode    = IORING_OP_READ;
+  sqe->fd        = source->file;
+  sqe->addr      = (uint64_t)(uintptr_t)(source->buffers[slot] + done);
+  sqe->len       = (uint32_t)(CSV_URING_BLOCK_SIZE - done);
+  sqe->off       = (uint64_t)b * CSV_URING_BLOCK_SIZE + done;
+  sqe->user_data = (uint64_t)b;
+
+  source->sq_array[index] = index;
+  __atomic_store_n(source->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  if (syscall(__NR_io_uring_enter, source->ring, 1, 0, 0, NULL, 0) != 1) {
+    ZF_LOGE("read could not be submitted: `%s`", strerror(errno));
+    return false;
+  }
+
+  source->inflight++;
+  return true;
+}
+
+bool csv_uring_fill(csvuringsource source, size_t first) {
+  for (size_t b = first; b < first + CSV_URING_BLOCKS; ++b) {
+    if ((uint64_t)b * CSV_URING_BLOCK_SIZE >= source->size) break;
+    if (!csv_uring_submit(source, b, 0)) return false;
+  }
+  return true;
+}
+
+bool csv_uring_reap(csvuringsource source) {
+  unsigned             head = *source->cq_head;
+  struct io_uring_cqe *cqe  = NULL;
+  size_t               b     = 0;
+  size_t               slot  = 0;
+  size_t               start = 0;
+  int                  res   = 0;
+  uint64_t             left  = 0;
+  long                 rc    = 0;
+
+  while (head == __atomic_load_n(source->cq_tail, __ATOMIC_ACQUIRE)) {
+    rc = syscall(__NR_io_uring_enter,
+                 source->ring,
+                 0,
+                 1,
+                 IORING_ENTER_GETEVENTS,
+                 NULL,
+                 0);
+
+    if ((rc < 0) && (errno != EINTR)) {
+      ZF_LOGE("completion could not be awaited: `%s`", strerror(errno));
+      return false;
+    }
+  }
+
+  cqe  = &source->cqes[head & *source->cq_mask];
+  b    = (size_t)cqe->user_data;
+  res  = cqe->res;
+  slot = b % CSV_URING_BLOCKS;
+  __atomic_store_n(source->cq_head, head + 1, __ATOMIC_RELEASE);
+  source->inflight--;
+
+  if (res < 0) {
+    source->results[slot]  = res;
+    source->complete[slot] = true;
+    return true;
+  }
+
+  start = source->lengths[slot];
+  source->lengths[slot] += (size_t)res;
+  left = source->size - (uint64_t)b * CSV_URING_BLOCK_SIZE;
+
+  /* a read may come back short before the end of the file */
+  if ((res > 0) && (source->lengths[slot] < CSV_URING_BLOCK_SIZE) &&
+      (source->lengths[slot] < left)) {
+    /* under O_DIRECT the aligned offset must move on */
+    if (source->direct &&
+        (source->lengths[slot] - start < CSV_URING_ALIGNMENT)) {
+      ZF_LOGE("read of block `%lu` is short of an aligned offset",
+              (long unsigned)b);
+      source->results[slot]  = -EIO;
+      source->complete[slot] = true;
+      return true;
+    }
+    return csv_uring_submit(source, b, source->lengths[slot]);
+  }
+
+  source->complete[slot] = true;
+  return true;
+}
+
+CSV_STREAM_SIGNAL csv_uring_getnextblock(csvstream_type streamdata,
+                                         const char **  block,
+                                         size_t *       length) {
+  csvuringsource source = (csvuringsource)streamdata;
+  size_t         b      = 0;
+  size_t         slot   = 0;
+
+  *block  = NULL;
+  *length = 0;
+
+  /* the released buffer is reused for the block after the ring */
+  if (source->held) {
+    source->held = false;
+    b            = source->consumed++ + CSV_URING_BLOCKS;
+
+    if (((uint64_t)b * CSV_URING_BLOCK_SIZE < source->size) &&
+        !csv_uring_submit(source, b, 0)) {
+      return CSV_ERROR;
+    }
+  }
+
+  b    = source->consumed;
+  slot = b % CSV_URING_BLOCKS;
+
+  if ((uint64_t)b * CSV_URING_BLOCK_SIZE >= source->size) return CSV_EOF;
+
+  while (!source->complete[slot]) {
+    if (!csv_uring_reap(source)) return CSV_ERROR;
+  }
+
+  if (source->results[slot] < 0) {
+    ZF_LOGE("read of block `%lu` failed: `%s`",
+            (long unsigned)b,
+            strerror(-source->results[slot]));
+    return CSV_ERROR;
+  }
+
+  /* the file was truncated after it was opened */
+  if (source->lengths[slot] <= source->skip) return CSV_EOF;
+
+  *block       = source->buffers[slot] + source->skip;
+  *length      = source->lengths[slot] - source->skip;
+  source->skip = 0;
+  source->held = true;
+
+  ZF_LOGD("block `%lu` length: `%lu`",
+          (long unsigned)b,
+          (long unsigned)*length);
+  return CSV_GOOD;
+}
+
+bool csv_uring_seek(csvstream_type streamdata, uint64_t offset) {
+  csvuringsource source = (csvuringsource)streamdata;
+
+  if ((source == NULL) || (offset > source->size)) {
+    ZF_LOGD("offset `%lu` is past the end of the file",
+            (long unsigned)offset);
+    return false;
+  }
+
+  /* the buffers are reused, every read in flight must land first */
+  while (source->inflight > 0) {
+    if (!csv_uring_reap(source)) return false;
+  }
+
+  source->consumed = (size_t)(offset / CSV_URING_BLOCK_SIZE);
+  source->skip     = (size_t)(offset % CSV_URING_BLOCK_SIZE);
+  source->held     = false;
+  return csv_uring_fill(source, source->consumed);
+}
+
+void csv_uring_close(csvstream_type streamdata) {
+  csvuringsource source = (csvuringsource)streamdata;
+
+  if (source == NULL) return;
+
+  /* the kernel writes into the buffers until the reads complete */
+  while ((source->inflight > 0) && csv_uring_reap(source)) continue;
+
+  if (source->sqes != MAP_FAILED) munmap(source->sqes, source->sqes_size);
+
+  if ((source->cq_ring != MAP_FAILED) && (source->cq_ring != source->sq_ring)) {
+    munmap(source->cq_ring, source->cq_ring_size);
+  }
+
+  if (source->sq_ring != MAP_FAILED) {
+    munmap(source->sq_ring, source->sq_ring_size);
+  }
+
+  if (source->ring >= 0) close(source->ring);
+  if (source->file >= 0) close(source->file);
+
+  for (size_t b = 0; (source->buffers != NULL) && (b < CSV_URING_BLOCKS); ++b) {
+    /* aligned by `posix_memalign`, outside of the library allocator */
+    free(source->buffers[b]);
+  }
+  csv_free(NULL, source->buffers);
+  csv_free(NULL, source->lengths);
+  csv_free(NULL, source->results);
+  csv_free(NULL, source->complete);
+  csv_free(NULL, source);
+}
+#endif /* CSV_HAVE_URING */
+
+/**
+ * @endcond
+ */
@@ -14,6 +14,8 @@
 #include <string.h>
 
 #include "csv.h"
+#include "alloc_private.h"
+#include "dialect_private.h"
 
 // #include "csv/definitions.h"
 // #include "csv/version.h"
@@ -29,9 +31,11 @@
  */
 typedef struct csv_file_writer *csvfilewriter;
 
-csvfilewriter     csvfilewriter_init(void);
-csvfilewriter     csvfilewriter_filepath_init(const char *filepath);
-csvfilewriter     csvfilewriter_file_init(FILE *fileobj);
+csvfilewriter     csvfilewriter_init(const csvallocator *allocator);
+csvfilewriter     csvfilewriter_filepath_init(const char *        filepath,
+                                              const csvallocator *allocator);
+csvfilewriter     csvfilewriter_file_init(FILE *              fileobj,
+                                          const csvallocator *allocator);
 void              csvfilewriter_filepath_closer(csvstream_type streamdata);
 void              csvfilewriter_file_closer(csvstream_type streamdata);
 void              csvwriter_setrecord(csvstream_type streamdata,
@@ -57,13 +61,15 @@ struct csv_writer {
   csvstream_getnextchar  getnextchar;
   csvstream_writechar    writechar;
   csvstream_close        closer;
+  csvallocator           allocator;
 };
 
 csvwriter csvwriter_init(csvdialect dialect, const char *filepath) {
   csvfilewriter filewriter = NULL;
   csvwriter     writer     = NULL;
 
-  if ((filewriter = csvfilewriter_filepath_init(filepath)) == NULL) {
+  if ((filewriter = csvfilewriter_filepath_init(
+           filepath, csvdialect_get_allocator(dialect))) == NULL) {
     ZF_LOGE("CSV Writer initialization from filepath failed");
     return NULL;
   }
@@ -94,7 +100,8 @@ csvwriter csvwriter_file_init(csvdialect dialect, FILE *fileobj) {
   csvfilewriter filewriter = NULL;
   csvwriter     writer     = NULL;
 
-  if ((filewriter = csvfilewriter_file_init(fileobj)) == NULL) {
+  if ((filewriter = csvfilewriter_file_init(
+           fileobj, csvdialect_get_allocator(dialect))) == NULL) {
     ZF_LOGE("CSV Writer initialization from file pointer failed");
     return NULL;
   }
@@ -128,7 +135,8 @@ csvwriter csvwriter_advanced_init(csvdialect             dialect,
                                   csvstream_getnextchar  getnextchar,
                                   csvstream_writechar    writechar,
                                   csvstream_type         streamdata) {
-  csvwriter writer;
+  csvwriter    writer;
+  csvallocator allocator = *csvdialect_get_allocator(dialect);
 
   dialect = (dialect == NULL) ? csvdialect_init() : csvdialect_copy(dialect);
 
@@ -136,10 +144,12 @@ csvwriter csvwriter_advanced_init(csvdialect             dialect,
     return NULL;
   }
 
-  if ((writer = malloc(sizeof *writer)) == NULL) {
+  if ((writer = csv_malloc(&allocator, sizeof *writer)) == NULL) {
+    csvdialect_close(&dialect);
     return NULL;
   }
 
+  writer->allocator    = allocator;
   writer->dialect      = dialect;
   writer->streamdata   = streamdata;
   writer->setrecord    = setrecord;
@@ -176,7 +186,10 @@ void csvwriter_close(csvwriter *writer) {
     csvdialect_close(&((*writer)->dialect));
   }
 
-  free(*writer);
+  /* the writer holds its own allocator, keep it past the release */
+  csvallocator allocator = (*writer)->allocator;
+
+  csv_free(&allocator, *writer);
   *writer = NULL;
 }
 
@@ -395,28 +408,30 @@ csvreturn csvwriter_next_record(csvwriter    writer,
  * no public API provided, implementation not guaranteed
  */
 struct csv_file_writer {
-  const char *filepath;   /**< filepath, if provided to data source */
-  FILE *      file;       /**< output stream */
-  char **     record;     /**< input record */
-  char *      field;      /**< input field */
-  size_t      capacity_r; /**< length of the input record */
-  size_t      capacity_f; /**< length of the current field */
-  size_t      position_r; /**< current position in the record */
-  size_t      position_f; /**< current position in the field */
+  csvallocator allocator;  /**< allocated the writer */
+  const char * filepath;   /**< filepath, if provided to data source */
+  FILE *       file;       /**< output stream */
+  char **      record;     /**< input record */
+  char *       field;      /**< input field */
+  size_t       capacity_r; /**< length of the input record */
+  size_t       capacity_f; /**< length of the current field */
+  size_t       position_r; /**< current position in the record */
+  size_t       position_f; /**< current position in the field */
 };
 
 /*
  * initialize raw csv file writer pointer
  */
-csvfilewriter csvfilewriter_init(void) {
+csvfilewriter csvfilewriter_init(const csvallocator *allocator) {
   ZF_LOGD("Initializing base CSV File Writer");
   csvfilewriter output = NULL;
 
-  if ((output = malloc(sizeof *output)) == NULL) {
+  if ((output = csv_malloc(allocator, sizeof *output)) == NULL) {
     ZF_LOGE("Could not allocate base CSV File Writer");
     return NULL;
   }
 
+  output->allocator  = *allocator;
   output->filepath   = NULL;
   output->file       = NULL;
   output->record     = NULL;
@@ -433,11 +448,13 @@ csvfilewriter csvfilewriter_init(void) {
  * @brief Initialize CSV File Writer from filepath
  *
  * @param[in] filepath filepath to output destination
+ * @param[in] allocator allocator of the writer
  *
  * @return fully initialized @c struct @c csv_file_writer which can be used as
  *         @p streamdata in @c csvwriter_advanced_init
  */
-csvfilewriter csvfilewriter_filepath_init(const char *filepath) {
+csvfilewriter csvfilewriter_filepath_init(const char *        filepath,
+                                          const csvallocator *allocator) {
   ZF_LOGD("Initializing filepath CSV File Writer");
 
   FILE *        outfile    = NULL;
@@ -453,7 +470,7 @@ csvfilewriter csvfilewriter_filepath_init(const char *filepath) {
     return NULL;
   }
 
-  if ((filewriter = csvfilewriter_init()) == NULL) {
+  if ((filewriter = csvfilewriter_init(allocator)) == NULL) {
     ZF_LOGE("ERROR - could not allocate `csvfilewriter`");
     fclose(outfile);
     return NULL;
@@ -468,10 +485,12 @@ csvfilewriter csvfilewriter_filepath_init(const char *filepath) {
  * @brief CSV File Writer - File pointer initializer
  *
  * @param  fileobj @c stdio @c FILE* object, previously initialized
+ * @param  allocator allocator of the writer
  *
  * @return         Fully initiailize CSV File Writer
  */
-csvfilewriter csvfilewriter_file_init(FILE *fileobj) {
+csvfilewriter csvfilewriter_file_init(FILE *              fileobj,
+                                      const csvallocator *allocator) {
   ZF_LOGD("Initializing file pointer CSV File Writer");
 
   csvfilewriter filewriter = NULL;
@@ -481,7 +500,7 @@ csvfilewriter csvfilewriter_file_init(FILE *fileobj) {
     return NULL;
   }
 
-  if ((filewriter = csvfilewriter_init()) == NULL) {
+  if ((filewriter = csvfilewriter_init(allocator)) == NULL) {
     ZF_LOGE("ERROR - could not allocate `csvfilewriter`");
     return NULL;
   }
@@ -514,7 +533,8 @@ void csvfilewriter_filepath_closer(csvstream_type streamdata) {
   }
 
   ZF_LOGI("Freeing CSV File Writer from filepath resources");
-  free(filewriter);
+  csvallocator allocator = filewriter->allocator;
+  csv_free(&allocator, filewriter);
 }
 
 /**
@@ -532,7 +552,8 @@ void csvfilewriter_file_closer(csvstream_type streamdata) {
   csvfilewriter filewriter = (csvfilewriter)streamdata;
 
   ZF_LOGI("Freeing CSV File Writer from file pointer resources");
-  free(filewriter);
+  csvallocator allocator = filewriter->allocator;
+  csv_free(&allocator, filewriter);
 }
 
 /**
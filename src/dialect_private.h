@@ -15,6 +15,7 @@
 #include "csv/version.h"
 
 #include "csv/dialect.h"
+#include "alloc_private.h"
 
 /**
  * @brief Deep copy of CSV Dialect
@@ -29,6 +30,33 @@
  */
 csvdialect csvdialect_copy(csvdialect dialect);
 
+/**
+ * @brief Copy of CSV Dialect for readers which run on worker threads
+ *
+ * The dialect's allocator need not be safe to call from other threads, so the
+ * readers made with the copy use the library allocator instead.
+ *
+ * @param[in]  dialect  CSV Dialect type to copy, the default if @c NULL
+ *
+ * @return              Deep copy of @p dialect values, note: this must be freed
+ *                      by the requestor.
+ *
+ * @see csvdialect_copy
+ */
+csvdialect csvdialect_worker_copy(csvdialect dialect);
+
+/**
+ * @brief Get the allocator of the readers and writers made with a dialect
+ *
+ * @param[in]  dialect  CSV Dialect type, may be @c NULL
+ *
+ * @return              allocator set by @c csvdialect_set_allocator, or the
+ *                      library allocator if @p dialect is @c NULL
+ *
+ * @see csvdialect_set_allocator
+ */
+const csvallocator *csvdialect_get_allocator(csvdialect dialect);
+
 /**
  * @brief Ensure CSV Dialect is in a valid state
  *
@@ -0,0 +1,307 @@
+/**
+ * @cond INTERNAL
+ * @file read_private.h
+ * @author Robert Smith
+ * @brief Private API shared by the CSV Reader implementations. No guarantee of
+ * stability.
+ */
+#ifndef CSV_READ_PRIVATE_H_
+#define CSV_READ_PRIVATE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csv/definitions.h"
+#include "csv/version.h"
+
+#include "csv/dialect.h"
+#include "csv/read.h"
+#include "csv/stream.h"
+
+/**
+ * @brief Produce the next record of a record source
+ *
+ * Record sources hand out records which have already been parsed, such as the
+ * parallel reader's worker results. On @c CSV_EOR the record is returned by
+ * the source's @c csvstream_saverecordview callback.
+ *
+ * @return @c CSV_EOR when a record is ready, otherwise @c CSV_EOF or
+ *         @c CSV_ERROR
+ */
+typedef CSV_STREAM_SIGNAL (*csvstream_getnextrecord)(csvstream_type streamdata);
+
+/**
+ * @brief Move the stream to @p offset characters from the start of the input
+ *
+ * Any partially saved field or record held by the stream is discarded.
+ *
+ * @return @c false if the stream cannot be positioned
+ */
+typedef bool (*csvstream_seek)(csvstream_type streamdata, uint64_t offset);
+
+/**
+ * @brief Record offset index
+ *
+ * Entry @c i holds the offset of the first character of record
+ * @c i * @c interval, and the parser state just before it. Written to a
+ * sidecar file by @c csvreader_build_index and @c csvreader_update_index,
+ * read from it by @c csvreader_load_index.
+ */
+typedef struct csv_index {
+  uint64_t  interval; /**< records between entries */
+  uint64_t  records;  /**< records in the input when it was indexed */
+  uint64_t  length;   /**< characters in the input when it was indexed */
+  uint64_t  checksum; /**< checksum of the end of the indexed input */
+  uint64_t  size;     /**< number of entries */
+  uint64_t  capacity; /**< allocated entries */
+  uint64_t *offsets;  /**< offset of the first character of each entry */
+  uint8_t * states;   /**< parser state before each entry */
+} csvindex;
+
+/**
+ * @brief Initializer for CSV Readers over a record source
+ *
+ * The reader does not parse, @p getnextrecord supplies each record and
+ * @p saverecordview returns it. @c csvreader_next_record copies the views into
+ * caller owned strings.
+ *
+ * @param[in]  dialect         CSV Dialect type, may be @c NULL
+ * @param[in]  getnextrecord   produces the next record
+ * @param[in]  saverecordview  returns the record produced as field views
+ * @param[in]  streamdata      passed to the callbacks
+ *
+ * @return                     initialized CSV Reader, or NULL on error
+ */
+csvreader csvreader_record_source_init(csvdialect               dialect,
+                                       csvstream_getnextrecord  getnextrecord,
+                                       csvstream_saverecordview saverecordview,
+                                       csvstream_type           streamdata);
+
+/**
+ * @brief Initializer for CSV Readers over a block source
+ *
+ * The reader behaves as one made by @c csvreader_file_init, fields are copied
+ * into the reader's buffers, but each block is taken from @p getnextblock
+ * rather than read from a @c FILE*. A block only has to stay valid until
+ * @p getnextblock is called again.
+ *
+ * If @p seek is given the reader can be positioned by
+ * @c csvreader_seek_record and @c csvreader_seek_offset, offsets are counted
+ * in characters of the input as produced by @p getnextblock.
+ *
+ * @param[in]  dialect       CSV Dialect type, may be @c NULL
+ * @param[in]  getnextblock  produces the next block of input
+ * @param[in]  seek          optionally positions @p source, may be @c NULL
+ * @param[in]  closer        releases @p source, called by @c csvreader_close
+ * @param[in]  source        passed to @p getnextblock, @p seek and @p closer
+ *
+ * @return                   initialized CSV Reader, or NULL on error, in
+ *                           which case @p source has been released
+ */
+csvreader csvreader_source_init(csvdialect             dialect,
+                                csvstream_getnextblock getnextblock,
+                                csvstream_seek         seek,
+                                csvstream_close        closer,
+                                csvstream_type         source);
+
+/**
+ * @brief Get the stream data supplied to the reader's initializer
+ */
+csvstream_type csvreader_get_streamdata(csvreader reader);
+
+/**
+ * @brief Return the parser to the start of a record and drop the current block
+ *
+ * Used by readers which switch the underlying stream to a new range of input.
+ */
+void csvreader_rewind(csvreader reader);
+
+/**
+ * @brief Set the callback used by @c csvreader_seek_record to position the
+ * stream
+ */
+csvreader csvreader_set_seek(csvreader reader, csvstream_seek seek);
+
+/**
+ * @brief Replace the index used by @c csvreader_seek_record
+ *
+ * The reader takes ownership of @p index, any previous index is released.
+ */
+void csvreader_set_index(csvreader reader, csvindex *index);
+
+/**
+ * @brief Run the parser over @p data without saving any fields
+ *
+ * Counts field and record ends instead of calling the stream callbacks. If
+ * @p index is not @c NULL an entry is appended to it at the start of every
+ * record whose number is a multiple of its interval.
+ *
+ * An index which already has entries is extended: the scan restarts at its
+ * last entry, which is replaced, and @p records is set to that entry's record
+ * number. @p fields then only counts the fields from that entry on.
+ *
+ * @param[in]      reader   reader whose compiled dialect is used
+ * @param[in]      data     first character of the input
+ * @param[in]      length   number of characters of input
+ * @param[in,out]  records  incremented for every record
+ * @param[in,out]  fields   incremented for every field
+ * @param[in,out]  index    optional index to extend
+ *
+ * @return @c false if @p data contains a NUL byte or the index could not be
+ *         grown
+ */
+bool csvreader_scan_block(csvreader   reader,
+                          const char *data,
+                          size_t      length,
+                          uint64_t *  records,
+                          uint64_t *  fields,
+                          csvindex *  index);
+
+/**
+ * @brief Append an entry to @p index
+ *
+ * @return @c false if the index could not be grown
+ */
+bool csvindex_append(csvindex *index, uint64_t offset, uint8_t state);
+
+/**
+ * @brief Release the entries of @p index and @p index itself
+ */
+void csvindex_close(csvindex *index);
+
+/**
+ * @brief Initializer for CSV Readers over a range of memory
+ *
+ * Parses @p data with the memory mapped reader's zero-copy callbacks. The
+ * memory is not copied or released, it must outlive the reader.
+ *
+ * @param[in]  dialect  CSV Dialect type, may be @c NULL
+ * @param[in]  data     first character of the input
+ * @param[in]  length   number of characters of input
+ *
+ * @return              initialized CSV Reader, or NULL on error
+ *
+ * @see csvreader_mmap_init
+ */
+csvreader csvreader_memory_init(csvdialect  dialect,
+                                const char *data,
+                                size_t      length);
+
+/**
+ * @brief Point a reader created by @c csvreader_memory_init at new input
+ *
+ * Any partially parsed record is discarded.
+ */
+void csvreader_memory_reset(csvreader reader, const char *data, size_t length);
+
+/**
+ * @brief Map @p filepath read-only into memory
+ *
+ * An empty file succeeds with @p map set to @c NULL and @p length zero.
+ *
+ * @return @c false if the file could not be opened or mapped
+ */
+bool csv_mmap_map(const char *filepath, const char **map, size_t *length);
+
+/**
+ * @brief Release a mapping made by @c csv_mmap_map
+ */
+void csv_mmap_unmap(const char *map, size_t length);
+
+/**
+ * @brief Empty @p batch so records can be appended to it
+ *
+ * @param[in,out]  batch     batch to empty, its buffers are kept
+ * @param[in]      expected  number of records to reserve room for
+ *
+ * @return @c false if the batch could not be allocated
+ */
+bool csvbatch_begin(csvbatch *batch, size_t expected);
+
+/**
+ * @brief Ensure @p buffer has room for @p required elements of @p size
+ *
+ * Grows @p buffer by doubling, starting from @p minimum elements.
+ *
+ * @return the possibly moved buffer, or @c NULL if it could not be grown in
+ *         which case @p buffer is unchanged
+ */
+void *csvbatch_reserve(void *  buffer,
+                       size_t *capacity,
+                       size_t  required,
+                       size_t  minimum,
+                       size_t  size);
+
+/**
+ * @brief Append a record of field views to the end of @p batch
+ *
+ * @p batch must have been emptied with @c csvbatch_begin.
+ *
+ * @return @c false if the batch could not be grown
+ */
+bool csvbatch_append(csvbatch *      batch,
+                     const csvfield *fields,
+                     size_t          length);
+
+/**
+ * @brief Fill @p buffer with up to @p capacity characters of input
+ *
+ * @return @c CSV_GOOD with a non-zero @p length, @c CSV_EOF once the input is
+ *         exhausted or @c CSV_ERROR
+ */
+typedef CSV_STREAM_SIGNAL (*csvpipeline_fill)(csvstream_type context,
+                                              char *         buffer,
+                                              size_t         capacity,
+                                              size_t *       length);
+
+typedef struct csv_pipeline *csvpipeline;
+
+/**
+ * @brief Start filling a bounded ring of blocks from @p fill
+ *
+ * With thread support @p fill runs on a producer thread, which stays up to
+ * @p blocks blocks of @p block_size characters ahead of the parser. Without
+ * it, or if the thread cannot be created, @p fill is called as each block is
+ * requested.
+ *
+ * @param[in]  fill        produces the input
+ * @param[in]  closer      releases @p context once the producer has stopped
+ * @param[in]  wake        returns a @p fill blocked waiting for input, called
+ *                         as the pipeline is closed, may be @c NULL
+ * @param[in]  context     passed to @p fill and @p closer
+ * @param[in]  blocks      number of blocks in the ring, at least two
+ * @param[in]  block_size  capacity of each block
+ *
+ * @return                 pipeline for @c csvpipeline_getnextblock, or NULL
+ *                         on error, in which case @p context has been
+ *                         released
+ */
+csvpipeline csvpipeline_init(csvpipeline_fill fill,
+                             csvstream_close  closer,
+                             csvstream_close  wake,
+                             csvstream_type   context,
+                             size_t           blocks,
+                             size_t           block_size);
+
+/**
+ * @brief Hand the next filled block to the parser, releasing the previous one
+ *
+ * @see csvstream_getnextblock
+ */
+CSV_STREAM_SIGNAL csvpipeline_getnextblock(csvstream_type pipeline,
+                                           const char **  block,
+                                           size_t *       length);
+
+/**
+ * @brief Stop the producer and release the ring and its context
+ *
+ * @see csvstream_close
+ */
+void csvpipeline_close(csvstream_type pipeline);
+
+/**
+ * @endcond
+ */
+
+#endif /* CSV_READ_PRIVATE_H_ */
@@ -0,0 +1,85 @@
+/**
+ * @cond INTERNAL
+ * @file scan_private.h
+ * @author Robert Smith
+ * @brief Private API for the structural character scanner. No guarantee of
+ * stability.
+ *
+ * A scan set holds the handful of characters which are structural for the
+ * parser in a given state (delimiter, quote, escape, line endings). Searching
+ * a block compares it against every character of the set many bytes at a
+ * time, building a bitmask of the matching positions, so the parser state
+ * machine only has to visit the positions which can change its state.
+ */
+#ifndef CSV_SCAN_PRIVATE_H_
+#define CSV_SCAN_PRIVATE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "csv/definitions.h"
+
+/**
+ * @brief Maximum number of distinct characters in a @c csvscanset
+ */
+#define CSV_SCAN_SET_SIZE 8
+
+typedef struct csv_scan_set csvscanset;
+
+/**
+ * @brief Set of structural characters, and the search used to find them
+ */
+struct csv_scan_set {
+  unsigned char chars[CSV_SCAN_SET_SIZE]; /**< distinct characters in the set */
+  size_t        size;                     /**< number of entries in @p chars */
+  bool          table[256]; /**< membership, indexed by character */
+  size_t (*find)(const csvscanset *set,
+                 const char *      data,
+                 size_t            length); /**< search selected for the CPU
+                                               at initialization */
+};
+
+/**
+ * @brief Initialize @p set from @p length characters
+ *
+ * Values of @c CSV_UNDEFINED_CHAR, values which do not fit in a @c char and
+ * duplicates are skipped. The widest search the running CPU supports (AVX2,
+ * SSE2 or the portable scalar search) is selected here.
+ *
+ * @param[out] set     scan set to initialize
+ * @param[in]  chars   characters to add to the set
+ * @param[in]  length  number of entries in @p chars
+ */
+void csvscanset_init(csvscanset *                    set,
+                     const csv_comparison_char_type *chars,
+                     size_t                          length);
+
+/**
+ * @brief Whether @p value is a member of @p set
+ */
+static inline bool csvscanset_contains(const csvscanset *set,
+                                       unsigned char     value) {
+  return set->table[value];
+}
+
+/**
+ * @brief Index of the first character of @p data which is in @p set
+ *
+ * @return index of the first match, or @p length if there is none
+ */
+static inline size_t csvscanset_find(const csvscanset *set,
+                                     const char *      data,
+                                     size_t            length) {
+  return (*set->find)(set, data, length);
+}
+
+/**
+ * @brief Name of the search selected for @p set, intended for logging
+ */
+const char *csvscanset_name(const csvscanset *set);
+
+/**
+ * @endcond
+ */
+
+#endif /* CSV_SCAN_PRIVATE_H_ */
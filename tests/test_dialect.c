@@ -11,6 +11,7 @@
 
 #include "csv.h"
 #include "dialect_private.h"
+#include "read_private.h"
 #include "unity.h"
 
 FILE *_log_file;
@@ -334,6 +335,84 @@ void test_CSVDialectSetGetSkipInitialSpace(void) {
   ZF_LOGI("Ending test_CSVDialectSetGetSkipInitialSpace");
 }
 
+/*
+ * Validate that the dialect and header of small samples are inferred
+ */
+void test_CSVDialectSniff(void) {
+  ZF_LOGI("Beginning test_CSVDialectSniff");
+  const char *semicolons =
+      "name;value\r\n\"a;b\";1\r\n\"c\"\"d\";22\r\ne;333\r\nf;4444\r\ng;5";
+  const char *    escaped   = "1\t'x\\'y'\t3\n4\t'z'\t6\n7\t'w'\t9\n";
+  const char *    spaced    = "1, 2, 3\n4, 5, 6\n";
+  const char *    single    = "abc\ndef\n";
+  const char *    apostrophe =
+      "name,city\nO'Brien,Dublin\nSmith,London\nJones,Paris\n";
+  csvdialect      dialect   = NULL;
+  csvreader       reader    = NULL;
+  const csvfield *fields    = NULL;
+  size_t          length    = 0;
+  const char *    lt        = NULL;
+  size_t          lt_length = 0;
+  bool            header    = false;
+
+  TEST_ASSERT_TRUE(
+      csv_success(csvdialect_sniff(semicolons, strlen(semicolons), &dialect)));
+  TEST_ASSERT_NOT_NULL(dialect);
+  TEST_ASSERT_EQUAL_INT(';', csvdialect_get_delimiter(dialect));
+  TEST_ASSERT_EQUAL_INT('"', csvdialect_get_quotechar(dialect));
+  TEST_ASSERT_TRUE(csvdialect_get_doublequote(dialect));
+  TEST_ASSERT_EQUAL_INT(CSV_UNDEFINED_CHAR, csvdialect_get_escapechar(dialect));
+  TEST_ASSERT_FALSE(csvdialect_get_skipinitialspace(dialect));
+  lt = csvdialect_get_lineterminator(dialect, &lt_length);
+  TEST_ASSERT_EQUAL_STRING("\r\n", lt);
+  TEST_ASSERT_TRUE(csv_success(csvdialect_sniff_header(
+      dialect, semicolons, strlen(semicolons), &header)));
+  TEST_ASSERT_TRUE(header);
+
+  /* an existing dialect is updated in place */
+  TEST_ASSERT_TRUE(
+      csv_success(csvdialect_sniff(escaped, strlen(escaped), &dialect)));
+  TEST_ASSERT_EQUAL_INT('\t', csvdialect_get_delimiter(dialect));
+  TEST_ASSERT_EQUAL_INT('\'', csvdialect_get_quotechar(dialect));
+  TEST_ASSERT_FALSE(csvdialect_get_doublequote(dialect));
+  TEST_ASSERT_EQUAL_INT('\\', csvdialect_get_escapechar(dialect));
+  lt = csvdialect_get_lineterminator(dialect, &lt_length);
+  TEST_ASSERT_EQUAL_STRING("\n", lt);
+  TEST_ASSERT_TRUE(csv_success(
+      csvdialect_sniff_header(dialect, escaped, strlen(escaped), &header)));
+  TEST_ASSERT_FALSE(header);
+  TEST_ASSERT_FALSE(csv_success(
+      csvdialect_sniff_header(dialect, escaped, strlen(escaped), NULL)));
+
+  TEST_ASSERT_TRUE(
+      csv_success(csvdialect_sniff(spaced, strlen(spaced), &dialect)));
+  TEST_ASSERT_EQUAL_INT(',', csvdialect_get_delimiter(dialect));
+  TEST_ASSERT_TRUE(csvdialect_get_skipinitialspace(dialect));
+  csvdialect_close(&dialect);
+
+  /* an apostrophe within a field does not make it the quote character */
+  TEST_ASSERT_TRUE(
+      csv_success(csvdialect_sniff(apostrophe, strlen(apostrophe), &dialect)));
+  TEST_ASSERT_EQUAL_INT(',', csvdialect_get_delimiter(dialect));
+  TEST_ASSERT_EQUAL_INT('"', csvdialect_get_quotechar(dialect));
+  reader = csvreader_memory_init(dialect, apostrophe, strlen(apostrophe));
+  TEST_ASSERT_NOT_NULL(reader);
+  TEST_ASSERT_TRUE(
+      csv_success(csvreader_next_record_view(reader, &fields, &length)));
+  TEST_ASSERT_TRUE(
+      csv_success(csvreader_next_record_view(reader, &fields, &length)));
+  TEST_ASSERT_EQUAL_UINT(2U, length);
+  TEST_ASSERT_EQUAL_UINT(7U, fields[0].len);
+  TEST_ASSERT_EQUAL_INT(0, strncmp("O'Brien", fields[0].data, 7));
+  csvreader_close(&reader);
+  csvdialect_close(&dialect);
+
+  TEST_ASSERT_FALSE(
+      csv_success(csvdialect_sniff(single, strlen(single), &dialect)));
+  TEST_ASSERT_NULL(dialect);
+  ZF_LOGI("Ending test_CSVDialectSniff");
+}
+
 /*
  * Run the tests
  *
@@ -362,6 +441,7 @@ int main(void) {
   RUN_TEST(test_CSVDialectSetGetQuotechar);
   RUN_TEST(test_CSVDialectSetGetQuotestyle);
   RUN_TEST(test_CSVDialectSetGetSkipInitialSpace);
+  RUN_TEST(test_CSVDialectSniff);
 
   output = UNITY_END();
   ZF_LOGI("Ending CSV Dialect Test, result: %d", output);
@@ -1,12 +1,29 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #ifndef ZF_LOG_LEVEL
 #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
 #endif /* ZF_LOG_LEVEL */
 #include "zf_log.h"
 
+#ifdef CSV_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef CSV_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "csv.h"
 #include "unity.h"
 
@@ -155,6 +172,2305 @@ void test_CSVReaderIrisDataset(void) {
   ZF_LOGI("`test_CSVReaderIrisDataset` completed");
 }
 
+void test_CSVReaderIrisDatasetView(void) {
+  ZF_LOGI("`test_CSVReaderIrisDatasetView` called");
+  csvreader       reader        = NULL;
+  const csvfield *fields        = NULL;
+  size_t          record_length = 0;
+  size_t          count         = 0;
+  csvreturn       rc;
+
+  reader = csvreader_init(NULL, "data/iris.csv");
+  TEST_ASSERT_NOT_NULL(reader);
+
+  rc = csvreader_next_record_view(reader, &fields, &record_length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(5U, record_length);
+  TEST_ASSERT_EQUAL_UINT(12U, fields[0].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("sepal_length", fields[0].data, 12);
+  TEST_ASSERT_EQUAL_UINT(7U, fields[4].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("species", fields[4].data, 7);
+
+  rc = csvreader_next_record_view(reader, &fields, &record_length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(5U, record_length);
+  TEST_ASSERT_EQUAL_UINT(3U, fields[0].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("5.1", fields[0].data, 3);
+  TEST_ASSERT_EQUAL_UINT(6U, fields[4].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("setosa", fields[4].data, 6);
+  ++count;
+
+  while (true) {
+    rc = csvreader_next_record_view(reader, &fields, &record_length);
+
+    if (csv_failure(rc)) break;
+
+    TEST_ASSERT_EQUAL_UINT(5U, record_length);
+    ++count;
+  }
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_NULL(fields);
+  TEST_ASSERT_EQUAL_UINT(150U, count);
+
+  csvreader_close(&reader);
+  ZF_LOGI("`test_CSVReaderIrisDatasetView` completed");
+}
+
+void test_CSVReaderIrisDatasetBatch(void) {
+  ZF_LOGI("`test_CSVReaderIrisDatasetBatch` called");
+  const size_t expected[] = {64U, 64U, 23U};
+  csvreader    reader     = NULL;
+  csvbatch     batch;
+  csvfield     field;
+  csvreturn    rc;
+
+  csvbatch_init(&batch);
+  reader = csvreader_init(NULL, "data/iris.csv");
+  TEST_ASSERT_NOT_NULL(reader);
+
+  for (size_t i = 0; i < sizeof expected / sizeof *expected; ++i) {
+    rc = csvreader_next_batch(reader, 64, &batch);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_EQUAL_UINT(expected[i], batch.size);
+
+    for (size_t j = 0; j < batch.size; ++j) {
+      TEST_ASSERT_EQUAL_UINT(5U, csvbatch_record_length(&batch, j));
+    }
+  }
+
+  /* the final batch holds the last two records of the file */
+  field = csvbatch_field(&batch, 22, 4);
+  TEST_ASSERT_EQUAL_UINT(9U, field.len);
+  TEST_ASSERT_EQUAL_STRING("virginica", field.data);
+  field = csvbatch_field(&batch, 21, 0);
+  TEST_ASSERT_EQUAL_STRING("6.2", field.data);
+
+  field = csvbatch_field(&batch, 22, 5);
+  TEST_ASSERT_NULL(field.data);
+  field = csvbatch_field(&batch, 23, 0);
+  TEST_ASSERT_NULL(field.data);
+
+  rc = csvreader_next_batch(reader, 64, &batch);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(0U, batch.size);
+
+  csvreader_close(&reader);
+
+  /* the header is the first record of a new reader's first batch */
+  reader = csvreader_init(NULL, "data/iris.csv");
+  rc     = csvreader_next_batch(reader, 1000, &batch);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(151U, batch.size);
+  field = csvbatch_field(&batch, 0, 0);
+  TEST_ASSERT_EQUAL_STRING("sepal_length", field.data);
+
+  csvreader_close(&reader);
+  csvbatch_close(&batch);
+  TEST_ASSERT_NULL(batch.heap);
+  ZF_LOGI("`test_CSVReaderIrisDatasetBatch` completed");
+}
+
+void test_CSVReaderIrisDatasetColumns(void) {
+  ZF_LOGI("`test_CSVReaderIrisDatasetColumns` called");
+  const char *filepath = "data/test_reader_columns.csv";
+  FILE *      fileobj  = NULL;
+  csvreader   reader   = NULL;
+  csvcolumns  columns;
+  csvfield    field;
+  csvreturn   rc;
+
+  csvcolumns_init(&columns);
+  reader = csvreader_init(NULL, "data/iris.csv");
+  TEST_ASSERT_NOT_NULL(reader);
+
+  rc = csvreader_next_columns(reader, 100, &columns);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(100U, columns.size);
+  TEST_ASSERT_EQUAL_UINT(5U, columns.length);
+
+  field = csvcolumns_field(&columns, 4, 0);
+  TEST_ASSERT_EQUAL_UINT(7U, field.len);
+  TEST_ASSERT_EQUAL_STRING_LEN("species", field.data, 7);
+  field = csvcolumns_field(&columns, 0, 1);
+  TEST_ASSERT_EQUAL_STRING_LEN("5.1", field.data, 3);
+  TEST_ASSERT_EQUAL_INT64(12, columns.columns[0].offsets[1]);
+  TEST_ASSERT_EQUAL_INT64(15, columns.columns[0].offsets[2]);
+
+  rc = csvreader_next_columns(reader, 100, &columns);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(51U, columns.size);
+  field = csvcolumns_field(&columns, 4, 50);
+  TEST_ASSERT_EQUAL_STRING_LEN("virginica", field.data, 9);
+
+  rc = csvreader_next_columns(reader, 100, &columns);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(0U, columns.size);
+  csvreader_close(&reader);
+
+  /* ragged records, missing fields are not valid */
+  fileobj = fopen(filepath, "wb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fputs("a,b\n1\n1,,3\n", fileobj);
+  fclose(fileobj);
+
+  reader = csvreader_init(NULL, filepath);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_next_columns(reader, 10, &columns);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(3U, columns.size);
+  TEST_ASSERT_EQUAL_UINT(3U, columns.length);
+
+  TEST_ASSERT_EQUAL_HEX8(0x07, columns.columns[0].validity[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x05, columns.columns[1].validity[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x04, columns.columns[2].validity[0]);
+
+  field = csvcolumns_field(&columns, 1, 1);
+  TEST_ASSERT_NULL(field.data);
+  field = csvcolumns_field(&columns, 1, 2);
+  TEST_ASSERT_NOT_NULL(field.data);
+  TEST_ASSERT_EQUAL_UINT(0U, field.len);
+  field = csvcolumns_field(&columns, 2, 0);
+  TEST_ASSERT_NULL(field.data);
+  field = csvcolumns_field(&columns, 2, 2);
+  TEST_ASSERT_EQUAL_STRING_LEN("3", field.data, 1);
+  TEST_ASSERT_EQUAL_INT64(0, columns.columns[2].offsets[2]);
+  TEST_ASSERT_EQUAL_INT64(1, columns.columns[2].offsets[3]);
+
+  csvreader_close(&reader);
+  csvcolumns_close(&columns);
+  TEST_ASSERT_NULL(columns.columns);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderIrisDatasetColumns` completed");
+}
+
+/*
+ * minimal block stream for `csvreader_advanced_block_init`, hands out a fixed
+ * string in chunks of `step` characters and collects fields into `record`
+ */
+typedef struct test_block_stream {
+  const char *data;
+  size_t      length;
+  size_t      position;
+  size_t      step;
+  char        field[64];
+  size_t      field_length;
+  char *      record[16];
+  size_t      record_length;
+} test_block_stream;
+
+static CSV_STREAM_SIGNAL test_block_getnextblock(csvstream_type streamdata,
+                                                 const char **  block,
+                                                 size_t *       length) {
+  test_block_stream *stream = (test_block_stream *)streamdata;
+
+  if (stream->position >= stream->length) {
+    return CSV_EOF;
+  }
+
+  *block  = stream->data + stream->position;
+  *length = stream->length - stream->position;
+  if (*length > stream->step) *length = stream->step;
+  stream->position += *length;
+  return CSV_GOOD;
+}
+
+static void test_block_appendchar(csvstream_type           streamdata,
+                                  csv_comparison_char_type value) {
+  test_block_stream *stream = (test_block_stream *)streamdata;
+  stream->field[stream->field_length++] = (char)value;
+}
+
+static void test_block_savefield(csvstream_type streamdata) {
+  test_block_stream *stream = (test_block_stream *)streamdata;
+  char *             field  = calloc(stream->field_length + 1, 1);
+
+  memcpy(field, stream->field, stream->field_length);
+  stream->record[stream->record_length++] = field;
+  stream->field_length                    = 0;
+}
+
+static void test_block_saverecord(csvstream_type streamdata,
+                                  char ***       fields,
+                                  size_t *       length) {
+  test_block_stream *stream = (test_block_stream *)streamdata;
+
+  *fields = malloc(sizeof **fields * (stream->record_length + 1));
+  memcpy(*fields, stream->record, sizeof **fields * stream->record_length);
+  *length               = stream->record_length;
+  stream->record_length = 0;
+}
+
+static void free_record(char **record, size_t record_length) {
+  for (size_t i = 0; i < record_length; ++i) {
+    free(record[i]);
+  }
+  free(record);
+}
+
+void test_CSVReaderBlockStream(void) {
+  ZF_LOGI("`test_CSVReaderBlockStream` called");
+  const char *data =
+      "a,\"b,1\",c\r\n"
+      "\r\n"
+      "\"d \"\"quoted\"\"\",\"multi\nline\",\n"
+      "last,record";
+  test_block_stream stream;
+  csvreader         reader        = NULL;
+  char **           record        = NULL;
+  size_t            record_length = 0;
+  csvreturn         rc;
+
+  /* odd step sizes place block boundaries inside quotes and line endings */
+  for (size_t step = 1; step < 8; ++step) {
+    memset(&stream, 0, sizeof stream);
+    stream.data   = data;
+    stream.length = strlen(data);
+    stream.step   = step;
+
+    reader = csvreader_advanced_block_init(NULL,
+                                           &test_block_getnextblock,
+                                           &test_block_appendchar,
+                                           &test_block_savefield,
+                                           &test_block_saverecord,
+                                           &stream);
+    TEST_ASSERT_NOT_NULL(reader);
+
+    rc = csvreader_next_record(reader, &record, &record_length);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_EQUAL_UINT(3U, record_length);
+    TEST_ASSERT_EQUAL_STRING("a", record[0]);
+    TEST_ASSERT_EQUAL_STRING("b,1", record[1]);
+    TEST_ASSERT_EQUAL_STRING("c", record[2]);
+    free_record(record, record_length);
+
+    /* blank line is skipped */
+    rc = csvreader_next_record(reader, &record, &record_length);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_EQUAL_UINT(3U, record_length);
+    TEST_ASSERT_EQUAL_STRING("d \"quoted\"", record[0]);
+    TEST_ASSERT_EQUAL_STRING("multi\nline", record[1]);
+    TEST_ASSERT_EQUAL_STRING("", record[2]);
+    free_record(record, record_length);
+
+    /* final record has no line terminator */
+    rc = csvreader_next_record(reader, &record, &record_length);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_TRUE(rc.io_eof);
+    TEST_ASSERT_EQUAL_UINT(2U, record_length);
+    TEST_ASSERT_EQUAL_STRING("last", record[0]);
+    TEST_ASSERT_EQUAL_STRING("record", record[1]);
+    free_record(record, record_length);
+
+    rc = csvreader_next_record(reader, &record, &record_length);
+    TEST_ASSERT_FALSE(csv_success(rc));
+    TEST_ASSERT_TRUE(rc.io_eof);
+    TEST_ASSERT_NULL(record);
+
+    csvreader_close(&reader);
+  }
+  ZF_LOGI("`test_CSVReaderBlockStream` completed");
+}
+
+/*
+ * records spanning the `fread` block boundary of the file readers
+ */
+static csvreader test_block_reader(csvdialect         dialect,
+                                   test_block_stream *stream,
+                                   const char *       data,
+                                   size_t             length) {
+  memset(stream, 0, sizeof *stream);
+  stream->data   = data;
+  stream->length = length;
+  stream->step   = length;
+
+  return csvreader_advanced_block_init(dialect,
+                                       &test_block_getnextblock,
+                                       &test_block_appendchar,
+                                       &test_block_savefield,
+                                       &test_block_saverecord,
+                                       stream);
+}
+
+void test_CSVReaderDialectRules(void) {
+  ZF_LOGI("`test_CSVReaderDialectRules` called");
+  const char        escaped[]  = "a;  b\\;c;\"q\\\"x\";\"end\"ing\n";
+  const char        unquoted[] = "\"a\",b\n";
+  const char        nul[]      = "a,b\0c\n";
+  test_block_stream stream;
+  csvdialect        dialect       = csvdialect_init();
+  csvreader         reader        = NULL;
+  char **           record        = NULL;
+  size_t            record_length = 0;
+  csvreturn         rc;
+
+  csvdialect_set_delimiter(dialect, ';');
+  csvdialect_set_escapechar(dialect, '\\');
+  csvdialect_set_doublequote(dialect, false);
+  csvdialect_set_skipinitialspace(dialect, true);
+
+  reader = test_block_reader(dialect, &stream, escaped, sizeof escaped - 1);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_next_record(reader, &record, &record_length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(4U, record_length);
+  TEST_ASSERT_EQUAL_STRING("a", record[0]);
+  TEST_ASSERT_EQUAL_STRING("b;c", record[1]);
+  TEST_ASSERT_EQUAL_STRING("q\"x", record[2]);
+  TEST_ASSERT_EQUAL_STRING("ending", record[3]);
+  free_record(record, record_length);
+  csvreader_close(&reader);
+
+  /* quote characters are ordinary when quoting is disabled */
+  csvdialect_set_delimiter(dialect, ',');
+  csvdialect_set_quotestyle(dialect, QUOTE_STYLE_NONE);
+
+  reader = test_block_reader(dialect, &stream, unquoted, sizeof unquoted - 1);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_next_record(reader, &record, &record_length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(2U, record_length);
+  TEST_ASSERT_EQUAL_STRING("\"a\"", record[0]);
+  TEST_ASSERT_EQUAL_STRING("b", record[1]);
+  free_record(record, record_length);
+  csvreader_close(&reader);
+  csvdialect_close(&dialect);
+
+  /* NULL bytes are invalid input */
+  reader = test_block_reader(NULL, &stream, nul, sizeof nul - 1);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_next_record(reader, &record, &record_length);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_error);
+  for (size_t i = 0; i < stream.record_length; ++i) {
+    free(stream.record[i]);
+  }
+  csvreader_close(&reader);
+  ZF_LOGI("`test_CSVReaderDialectRules` completed");
+}
+
+void test_CSVReaderFileBlocks(void) {
+  ZF_LOGI("`test_CSVReaderFileBlocks` called");
+  FILE *    fileobj       = tmpfile();
+  csvreader reader        = NULL;
+  char **   record        = NULL;
+  size_t    record_length = 0;
+  size_t    count         = 0;
+  char      expected[32];
+  csvreturn rc;
+
+  TEST_ASSERT_NOT_NULL(fileobj);
+
+  for (size_t i = 0; i < 20000; ++i) {
+    fprintf(fileobj, "%lu,\"quoted, %lu\"\n", (unsigned long)i,
+            (unsigned long)i);
+  }
+  rewind(fileobj);
+
+  reader = csvreader_file_init(NULL, fileobj);
+  TEST_ASSERT_NOT_NULL(reader);
+
+  while (true) {
+    rc = csvreader_next_record(reader, &record, &record_length);
+
+    if (csv_failure(rc)) break;
+
+    TEST_ASSERT_EQUAL_UINT(2U, record_length);
+    sprintf(expected, "quoted, %lu", (unsigned long)count);
+    TEST_ASSERT_EQUAL_STRING(expected, record[1]);
+    free_record(record, record_length);
+    ++count;
+  }
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(20000U, count);
+
+  csvreader_close(&reader);
+  fclose(fileobj);
+  ZF_LOGI("`test_CSVReaderFileBlocks` completed");
+}
+
+void test_CSVReaderLongFields(void) {
+  ZF_LOGI("`test_CSVReaderLongFields` called");
+  FILE *    fileobj       = tmpfile();
+  csvreader reader        = NULL;
+  char **   record        = NULL;
+  size_t    record_length = 0;
+  char      plain[128];
+  char      quoted[256];
+  csvreturn rc;
+
+  TEST_ASSERT_NOT_NULL(fileobj);
+
+  /* structural characters at every offset within and across scan chunks */
+  for (size_t width = 0; width < 100; ++width) {
+    memset(plain, 'p', width);
+    plain[width] = '\0';
+    fprintf(fileobj,
+            "%s,\"%.*s\"\"%s,\n%s\",%s\r\n",
+            plain,
+            (int)(width / 2),
+            plain,
+            plain + width / 2,
+            plain,
+            plain);
+  }
+  rewind(fileobj);
+
+  reader = csvreader_file_init(NULL, fileobj);
+  TEST_ASSERT_NOT_NULL(reader);
+
+  for (size_t width = 0; width < 100; ++width) {
+    memset(plain, 'p', width);
+    plain[width] = '\0';
+    sprintf(quoted,
+            "%.*s\"%s,\n%s",
+            (int)(width / 2),
+            plain,
+            plain + width / 2,
+            plain);
+
+    rc = csvreader_next_record(reader, &record, &record_length);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_EQUAL_UINT(3U, record_length);
+    TEST_ASSERT_EQUAL_STRING(plain, record[0]);
+    TEST_ASSERT_EQUAL_STRING(quoted, record[1]);
+    TEST_ASSERT_EQUAL_STRING(plain, record[2]);
+    free_record(record, record_length);
+  }
+
+  rc = csvreader_next_record(reader, &record, &record_length);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+
+  csvreader_close(&reader);
+  fclose(fileobj);
+  ZF_LOGI("`test_CSVReaderLongFields` completed");
+}
+
+void test_CSVReaderProjection(void) {
+  ZF_LOGI("`test_CSVReaderProjection` called");
+  const size_t      indices[] = {4, 0};
+  const size_t      quoted[]  = {1, 3};
+  const char *const names[]   = {"petal_width", "petal_colour"};
+  FILE *            fileobj   = tmpfile();
+  csvreader         reader    = NULL;
+  const csvfield *  fields    = NULL;
+  char **           record    = NULL;
+  size_t            length    = 0;
+  size_t            count     = 0;
+  csvreturn         rc;
+
+  reader = csvreader_init(NULL, "data/iris.csv");
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_set_projection(reader, indices, 2);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  /* kept fields are returned in file order */
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(2U, length);
+  TEST_ASSERT_EQUAL_STRING("sepal_length", record[0]);
+  TEST_ASSERT_EQUAL_STRING("species", record[1]);
+  free_record(record, length);
+
+  rc = csvreader_next_record_view(reader, &fields, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(2U, length);
+  TEST_ASSERT_EQUAL_STRING_LEN("5.1", fields[0].data, 3);
+  TEST_ASSERT_EQUAL_STRING_LEN("setosa", fields[1].data, 6);
+
+  /* every column again */
+  rc = csvreader_set_projection(reader, NULL, 0);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  rc = csvreader_next_record_view(reader, &fields, &length);
+  TEST_ASSERT_EQUAL_UINT(5U, length);
+  csvreader_close(&reader);
+
+  reader = csvreader_init(NULL, "data/iris.csv");
+  rc     = csvreader_set_projection_names(reader, names, 1);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  while (csv_success(rc)) {
+    rc = csvreader_next_record_view(reader, &fields, &length);
+    if (csv_failure(rc)) break;
+
+    TEST_ASSERT_EQUAL_UINT(1U, length);
+    if (count++ == 0) TEST_ASSERT_EQUAL_STRING_LEN("0.2", fields[0].data, 3);
+  }
+  TEST_ASSERT_EQUAL_UINT(150U, count);
+  csvreader_close(&reader);
+
+  /* missing column names keep every column */
+  reader = csvreader_init(NULL, "data/iris.csv");
+  rc     = csvreader_set_projection_names(reader, names, 2);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  rc = csvreader_next_record_view(reader, &fields, &length);
+  TEST_ASSERT_EQUAL_UINT(5U, length);
+  csvreader_close(&reader);
+
+  /* skipped fields still honour quoting */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fputs("\"a,\nb\",keep 1,\"c\"\"\",\"keep, 2\"\nx\n", fileobj);
+  rewind(fileobj);
+
+  reader = csvreader_file_init(NULL, fileobj);
+  TEST_ASSERT_NOT_NULL(reader);
+  csvreader_set_projection(reader, quoted, 2);
+
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(2U, length);
+  TEST_ASSERT_EQUAL_STRING("keep 1", record[0]);
+  TEST_ASSERT_EQUAL_STRING("keep, 2", record[1]);
+  free_record(record, length);
+
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(0U, length);
+  free_record(record, length);
+
+  csvreader_close(&reader);
+  fclose(fileobj);
+  ZF_LOGI("`test_CSVReaderProjection` completed");
+}
+
+/*
+ * keeps records whose last field matches the string passed as `context`
+ */
+static bool filter_species(void *          context,
+                           const csvfield *fields,
+                           size_t          length) {
+  const char *species = context;
+
+  return (length > 0) && (fields[length - 1].len == strlen(species)) &&
+         (memcmp(fields[length - 1].data, species, strlen(species)) == 0);
+}
+
+void test_CSVReaderFilter(void) {
+  ZF_LOGI("`test_CSVReaderFilter` called");
+  csvreader       reader = NULL;
+  const csvfield *fields = NULL;
+  char **         record = NULL;
+  size_t          length = 0;
+  size_t          count  = 0;
+  csvbatch        batch;
+  csvreturn       rc;
+
+  reader = csvreader_init(NULL, "data/iris.csv");
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_set_filter(reader, &filter_species, "versicolor");
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  for (count = 0; true; ++count) {
+    rc = csvreader_next_record(reader, &record, &length);
+
+    if (csv_failure(rc)) break;
+
+    TEST_ASSERT_EQUAL_UINT(5U, length);
+    TEST_ASSERT_EQUAL_STRING("versicolor", record[4]);
+    if (count == 0) TEST_ASSERT_EQUAL_STRING("7", record[0]);
+    free_record(record, length);
+  }
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(50U, count);
+  csvreader_close(&reader);
+
+  /* the final record is dropped, no record is returned with `io_eof` */
+  csvbatch_init(&batch);
+  reader = csvreader_mmap_init(NULL, "data/iris.csv");
+  TEST_ASSERT_NOT_NULL(reader);
+  csvreader_set_filter(reader, &filter_species, "setosa");
+
+  rc = csvreader_next_batch(reader, 1000, &batch);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(50U, batch.size);
+  TEST_ASSERT_EQUAL_STRING("setosa", csvbatch_field(&batch, 49, 4).data);
+
+  /* every record again */
+  csvreader_close(&reader);
+  reader = csvreader_mmap_init(NULL, "data/iris.csv");
+  csvreader_set_filter(reader, &filter_species, "setosa");
+  csvreader_set_filter(reader, NULL, NULL);
+  rc = csvreader_next_record_view(reader, &fields, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_STRING_LEN("species", fields[4].data, 7);
+
+  csvreader_close(&reader);
+  csvbatch_close(&batch);
+  ZF_LOGI("`test_CSVReaderFilter` completed");
+}
+
+void test_CSVReaderCountRecords(void) {
+  ZF_LOGI("`test_CSVReaderCountRecords` called");
+  const char *filepath = "data/test_reader_count.csv";
+  FILE *      fileobj  = NULL;
+  csvreader   reader   = NULL;
+  char **     record   = NULL;
+  size_t      length   = 0;
+  uint64_t    records  = 0;
+  uint64_t    fields   = 0;
+  uint64_t    expected = 0;
+  csvreturn   rc;
+
+  rc = csvreader_count_records(NULL, "data/iris.csv", &records, &fields);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT64(151U, records);
+  TEST_ASSERT_EQUAL_UINT64(755U, fields);
+
+  /* quoted line terminators, blank lines and an unterminated final record */
+  fileobj = fopen(filepath, "wb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 5000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"a\nb\"\"%s\",,%s",
+            (unsigned long)i,
+            (i % 3 == 0) ? "\r\n" : "",
+            (i % 5 == 0) ? "\n\r\n\n" : "x\r\n");
+  }
+  fputs("last,\"record", fileobj);
+  fclose(fileobj);
+
+  rc = csvreader_count_records(NULL, filepath, &records, &fields);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  reader = csvreader_init(NULL, filepath);
+  TEST_ASSERT_NOT_NULL(reader);
+  while (true) {
+    rc = csvreader_next_record(reader, &record, &length);
+    if (csv_failure(rc)) break;
+
+    expected += length;
+    free_record(record, length);
+  }
+  csvreader_close(&reader);
+
+  TEST_ASSERT_EQUAL_UINT64(5001U, records);
+  TEST_ASSERT_EQUAL_UINT64(expected, fields);
+
+  rc = csvreader_count_records(
+      NULL, "file-does-not-exist.csv", &records, &fields);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_error);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderCountRecords` completed");
+}
+
+void test_CSVReaderSeekRecord(void) {
+  ZF_LOGI("`test_CSVReaderSeekRecord` called");
+  const char *   filepath  = "data/test_reader_seek.csv";
+  const char *   indexpath = "data/test_reader_seek.csv.idx";
+  const uint64_t targets[] = {4999, 0, 13, 14, 2500, 7, 5000, 1};
+  FILE *         fileobj   = fopen(filepath, "wb");
+  csvreader      readers[2];
+  char **        record = NULL;
+  size_t         length = 0;
+  char           expected[32];
+  csvreturn      rc;
+
+  /* quoted line terminators and blank lines between the indexed records */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 5000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"a\nb\"\"%s\",,%s",
+            (unsigned long)i,
+            (i % 3 == 0) ? "\r\n" : "",
+            (i % 5 == 0) ? "\n\r\n\n" : "x\r\n");
+  }
+  fputs("5000,\"record", fileobj);
+  fclose(fileobj);
+
+  rc = csvreader_build_index(NULL, filepath, indexpath, 0);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  rc = csvreader_build_index(NULL, filepath, indexpath, 7);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  readers[0] = csvreader_init(NULL, filepath);
+  readers[1] = csvreader_mmap_init(NULL, filepath);
+
+  for (size_t r = 0; r < 2; ++r) {
+    TEST_ASSERT_NOT_NULL(readers[r]);
+    rc = csvreader_seek_record(readers[r], 0);
+    TEST_ASSERT_FALSE(csv_success(rc));
+
+    rc = csvreader_load_index(readers[r], indexpath);
+    TEST_ASSERT_TRUE(csv_success(rc));
+
+    for (size_t t = 0; t < sizeof targets / sizeof *targets; ++t) {
+      rc = csvreader_seek_record(readers[r], targets[t]);
+      TEST_ASSERT_TRUE(csv_success(rc));
+
+      /* read two records to cross any index entry */
+      for (uint64_t i = targets[t]; i < targets[t] + 2 && i <= 5000; ++i) {
+        rc = csvreader_next_record(readers[r], &record, &length);
+        TEST_ASSERT_TRUE(csv_success(rc));
+        snprintf(expected, sizeof expected, "%lu", (unsigned long)i);
+        TEST_ASSERT_EQUAL_STRING(expected, record[0]);
+        free_record(record, length);
+      }
+    }
+
+    rc = csvreader_seek_record(readers[r], 5001);
+    TEST_ASSERT_FALSE(csv_success(rc));
+    TEST_ASSERT_TRUE(rc.io_eof);
+
+    rc = csvreader_load_index(readers[r], filepath);
+    TEST_ASSERT_FALSE(csv_success(rc));
+    csvreader_close(&readers[r]);
+  }
+
+  remove(indexpath);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderSeekRecord` completed");
+}
+
+void test_CSVReaderUpdateIndex(void) {
+  ZF_LOGI("`test_CSVReaderUpdateIndex` called");
+  const char *filepath  = "data/test_reader_append.csv";
+  const char *indexpath = "data/test_reader_append.csv.idx";
+  const char *fullpath  = "data/test_reader_append.csv.full";
+  FILE *      fileobj   = fopen(filepath, "wb");
+  FILE *      updated   = NULL;
+  FILE *      rebuilt   = NULL;
+  csvreader   reader    = NULL;
+  char **     record    = NULL;
+  size_t      length    = 0;
+  int         value     = 0;
+  csvreturn   rc;
+
+  /* the final record is cut off inside a quoted field */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 100; ++i) {
+    fprintf(fileobj, "%lu,\"a\r\nb\"\r\n", (unsigned long)i);
+  }
+  fputs("100,\"par", fileobj);
+  fclose(fileobj);
+
+  rc = csvreader_build_index(NULL, filepath, indexpath, 3);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  rc = csvreader_update_index(NULL, filepath, indexpath);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  fileobj = fopen(filepath, "ab");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fputs("tial\"\n", fileobj);
+  for (size_t i = 101; i < 200; ++i) {
+    fprintf(fileobj, "%lu,\"a\r\nb\"\n\n", (unsigned long)i);
+  }
+  fclose(fileobj);
+
+  /* extending gives the same index as building it again */
+  rc = csvreader_update_index(NULL, filepath, indexpath);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  rc = csvreader_build_index(NULL, filepath, fullpath, 3);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  updated = fopen(indexpath, "rb");
+  rebuilt = fopen(fullpath, "rb");
+  TEST_ASSERT_NOT_NULL(updated);
+  TEST_ASSERT_NOT_NULL(rebuilt);
+  do {
+    value = fgetc(updated);
+    TEST_ASSERT_EQUAL_INT(fgetc(rebuilt), value);
+  } while (value != EOF);
+  fclose(updated);
+  fclose(rebuilt);
+
+  reader = csvreader_init(NULL, filepath);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_load_index(reader, indexpath);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  rc = csvreader_seek_record(reader, 100);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_STRING("partial", record[1]);
+  free_record(record, length);
+  rc = csvreader_seek_record(reader, 199);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_STRING("199", record[0]);
+  free_record(record, length);
+  csvreader_close(&reader);
+
+  /* a rewritten file is not extended */
+  fileobj = fopen(filepath, "r+b");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fputs("X", fileobj);
+  fseek(fileobj, 0, SEEK_END);
+  fputs("200,appended\n", fileobj);
+  fclose(fileobj);
+
+  rc = csvreader_update_index(NULL, filepath, indexpath);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  remove(fullpath);
+  remove(indexpath);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderUpdateIndex` completed");
+}
+
+void test_CSVReaderMmap(void) {
+  ZF_LOGI("`test_CSVReaderMmap` called");
+  const char *    filepath      = "data/test_reader_mmap.csv";
+  FILE *          fileobj       = fopen(filepath, "wb");
+  csvreader       reader        = NULL;
+  const csvfield *fields        = NULL;
+  char **         record        = NULL;
+  size_t          record_length = 0;
+  csvreturn       rc;
+
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fputs("plain,\"quoted\",\"say \"\"hi\"\"\",\n\n12,\"a,b\"", fileobj);
+  fclose(fileobj);
+
+  reader = csvreader_mmap_init(NULL, filepath);
+  TEST_ASSERT_NOT_NULL(reader);
+
+  rc = csvreader_next_record_view(reader, &fields, &record_length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(4U, record_length);
+  TEST_ASSERT_EQUAL_UINT(5U, fields[0].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("plain", fields[0].data, 5);
+  TEST_ASSERT_EQUAL_UINT(6U, fields[1].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("quoted", fields[1].data, 6);
+  TEST_ASSERT_EQUAL_UINT(8U, fields[2].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("say \"hi\"", fields[2].data, 8);
+  TEST_ASSERT_EQUAL_UINT(0U, fields[3].len);
+
+  /* views and owned records can be mixed on the same reader */
+  rc = csvreader_next_record(reader, &record, &record_length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(2U, record_length);
+  TEST_ASSERT_EQUAL_STRING("12", record[0]);
+  TEST_ASSERT_EQUAL_STRING("a,b", record[1]);
+  free_record(record, record_length);
+
+  rc = csvreader_next_record_view(reader, &fields, &record_length);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  csvreader_close(&reader);
+
+  /* missing file */
+  reader = csvreader_mmap_init(NULL, "file-does-not-exist.csv");
+  TEST_ASSERT_NULL(reader);
+
+  /* empty file */
+  fileobj = fopen(filepath, "wb");
+  fclose(fileobj);
+  reader = csvreader_mmap_init(NULL, filepath);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_next_record_view(reader, &fields, &record_length);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  csvreader_close(&reader);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderMmap` completed");
+}
+
+/*
+ * Compare every record of the parallel reader against the memory mapped
+ * reader, counting the records in `count`
+ */
+static void compare_readers(csvreader actual,
+                            csvreader expected,
+                            size_t *  count) {
+  const csvfield *fields       = NULL;
+  const csvfield *check        = NULL;
+  size_t          length       = 0;
+  size_t          check_length = 0;
+  csvreturn       rc, rc_check;
+
+  TEST_ASSERT_NOT_NULL(actual);
+  TEST_ASSERT_NOT_NULL(expected);
+
+  for (*count = 0; true; ++(*count)) {
+    rc       = csvreader_next_record_view(actual, &fields, &length);
+    rc_check = csvreader_next_record_view(expected, &check, &check_length);
+
+    TEST_ASSERT_EQUAL(rc_check.succeeded, rc.succeeded);
+    if (csv_failure(rc)) break;
+
+    TEST_ASSERT_EQUAL_UINT(check_length, length);
+    for (size_t i = 0; i < length; ++i) {
+      TEST_ASSERT_EQUAL_UINT(check[i].len, fields[i].len);
+      TEST_ASSERT_EQUAL_MEMORY(check[i].data, fields[i].data, fields[i].len);
+    }
+  }
+  TEST_ASSERT_TRUE(rc.io_eof);
+}
+
+static void compare_parallel_reader(const char *filepath,
+                                    size_t      nthreads,
+                                    size_t *    count) {
+  csvreader parallel = csvreader_parallel_init(NULL, filepath, nthreads);
+  csvreader expected = csvreader_mmap_init(NULL, filepath);
+
+  compare_readers(parallel, expected, count);
+
+  csvreader_close(&parallel);
+  csvreader_close(&expected);
+}
+
+void test_CSVReaderParallel(void) {
+  ZF_LOGI("`test_CSVReaderParallel` called");
+  const char *filepath = "data/test_reader_parallel.csv";
+  FILE *      fileobj  = fopen(filepath, "wb");
+  csvreader   reader   = NULL;
+  char **     record   = NULL;
+  size_t      length   = 0;
+  size_t      count    = 0;
+  csvreturn   rc;
+
+  /* quoted line terminators and quote characters straddle the chunks */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 200000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"line\nbreak, \"\"%lu\"\"\",plain text,%s\r\n",
+            (unsigned long)i,
+            (unsigned long)(i % 97),
+            (i % 7 == 0) ? "\"\"" : "tail");
+  }
+  fclose(fileobj);
+
+  compare_parallel_reader(filepath, 4, &count);
+  TEST_ASSERT_EQUAL_UINT(200000U, count);
+  compare_parallel_reader(filepath, 1, &count);
+  TEST_ASSERT_EQUAL_UINT(200000U, count);
+
+  /* owned records are copied out of the worker results */
+  reader = csvreader_parallel_init(NULL, filepath, 3);
+  TEST_ASSERT_NOT_NULL(reader);
+  for (count = 0; true; ++count) {
+    rc = csvreader_next_record(reader, &record, &length);
+
+    if (csv_failure(rc)) break;
+
+    TEST_ASSERT_EQUAL_UINT(4U, length);
+    TEST_ASSERT_EQUAL_UINT(count, strtoul(record[0], NULL, 10));
+    free_record(record, length);
+  }
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(200000U, count);
+  csvreader_close(&reader);
+
+  /* a stray quote character misleads the split, the reader falls back */
+  fileobj = fopen(filepath, "wb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 200000; ++i) {
+    fprintf(fileobj,
+            "%lu,%s,\"quoted\nfield\"\n",
+            (unsigned long)i,
+            (i == 1000) ? "5\" screen" : "plain text");
+  }
+  fclose(fileobj);
+
+  compare_parallel_reader(filepath, 4, &count);
+  TEST_ASSERT_EQUAL_UINT(200000U, count);
+
+  /* missing file */
+  reader = csvreader_parallel_init(NULL, "file-does-not-exist.csv", 4);
+  TEST_ASSERT_NULL(reader);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderParallel` completed");
+}
+
+void test_CSVReaderMultiFile(void) {
+  ZF_LOGI("`test_CSVReaderMultiFile` called");
+  const char *    allpath   = "data/test_reader_multi.csv";
+  const size_t    nfiles    = 12;
+  const size_t    threads[] = {1, 2, 3, 8};
+  char            paths[12][48];
+  const char *    list[13];
+  FILE *          fileobj  = NULL;
+  FILE *          all      = NULL;
+  csvreader       reader   = NULL;
+  csvreader       expected = NULL;
+  size_t          count    = 0;
+  size_t          records  = 0;
+  const csvfield *fields   = NULL;
+  size_t          length   = 0;
+  csvreturn       rc;
+
+  /* headers on most files, one file without, an empty file and files long
+   * enough to fill several batches */
+  all = fopen(allpath, "wb");
+  TEST_ASSERT_NOT_NULL(all);
+  for (size_t f = 0; f < nfiles; ++f) {
+    snprintf(paths[f],
+             sizeof paths[f],
+             "data/test_reader_multi_%02lu.csv",
+             (unsigned long)f);
+    list[f] = paths[f];
+
+    fileobj = fopen(paths[f], "wb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    if (f == 7) {
+      fclose(fileobj);
+      continue;
+    }
+
+    if (f != 4) fputs("id,\"na\nme\",value\r\n", fileobj);
+    if (f == 0) fputs("id,\"na\nme\",value\r\n", all);
+
+    records = (f % 3 == 0) ? 10000 + f : f;
+    for (size_t i = 0; i < records; ++i) {
+      fprintf(fileobj, "%lu,\"f%lu\",x\n", (unsigned long)i, (unsigned long)f);
+      fprintf(all, "%lu,\"f%lu\",x\n", (unsigned long)i, (unsigned long)f);
+    }
+    fclose(fileobj);
+  }
+  fclose(all);
+
+  for (size_t t = 0; t < sizeof threads / sizeof *threads; ++t) {
+    /* the repeated headers are dropped, file 4's first record is kept */
+    reader   = csvreader_multi_init(NULL, list, nfiles, threads[t], true);
+    expected = csvreader_mmap_init(NULL, allpath);
+    compare_readers(reader, expected, &count);
+    TEST_ASSERT_EQUAL_UINT(40060U, count);
+    csvreader_close(&reader);
+    csvreader_close(&expected);
+
+    /* every header is kept otherwise */
+    reader = csvreader_multi_init(NULL, list, nfiles, threads[t], false);
+    TEST_ASSERT_NOT_NULL(reader);
+    for (count = 0; true; ++count) {
+      rc = csvreader_next_record_view(reader, &fields, &length);
+      if (csv_failure(rc)) break;
+    }
+    TEST_ASSERT_TRUE(rc.io_eof);
+    TEST_ASSERT_EQUAL_UINT(40069U, count);
+    csvreader_close(&reader);
+  }
+
+#ifndef _WIN32
+  reader =
+      csvreader_multi_glob_init(NULL, "data/test_reader_multi_*", 4, true);
+  expected = csvreader_mmap_init(NULL, allpath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(40060U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+
+  TEST_ASSERT_NULL(
+      csvreader_multi_glob_init(NULL, "data/no_match_*", 4, true));
+#endif
+
+  /* a missing file fails after the records of the files before it */
+  list[nfiles] = "data/missing.csv";
+  reader       = csvreader_multi_init(NULL, list + 10, 3, 2, false);
+  TEST_ASSERT_NOT_NULL(reader);
+  for (count = 0; true; ++count) {
+    rc = csvreader_next_record_view(reader, &fields, &length);
+    if (csv_failure(rc)) break;
+  }
+  TEST_ASSERT_TRUE(rc.io_error);
+  TEST_ASSERT_EQUAL_UINT(23U, count);
+  csvreader_close(&reader);
+
+  reader = csvreader_multi_init(NULL, NULL, 0, 4, true);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_next_record_view(reader, &fields, &length);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_eof);
+  csvreader_close(&reader);
+
+  for (size_t f = 0; f < nfiles; ++f) remove(paths[f]);
+  remove(allpath);
+  ZF_LOGI("`test_CSVReaderMultiFile` completed");
+}
+
+void test_CSVReaderCheckpoint(void) {
+  ZF_LOGI("`test_CSVReaderCheckpoint` called");
+  const char *    filepath  = "data/test_reader_checkpoint.csv";
+  const char *    savepath  = "data/test_reader_checkpoint.ckpt";
+  const uint64_t  targets[] = {0, 1, 2, 3, 1234, 3999, 4000, 4001};
+  FILE *          fileobj   = fopen(filepath, "wb");
+  csvreader       reader    = NULL;
+  csvreader       expected  = NULL;
+  const csvfield *fields    = NULL;
+  size_t          length    = 0;
+  size_t          count     = 0;
+  csvcheckpoint   checkpoint;
+  csvcheckpoint   saved;
+  csvreturn       rc;
+
+  /* CRLF ends records in EAT_CRNL, quoted terminators and blank lines */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 4000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"a\r\nb\"\"\",%s",
+            (unsigned long)i,
+            (i % 7 == 0) ? "x\r\n\r\n" : "yz\r\n");
+  }
+  fputs("4000,\"record", fileobj);
+  fclose(fileobj);
+
+  for (size_t t = 0; t < sizeof targets / sizeof *targets; ++t) {
+    reader = csvreader_init(NULL, filepath);
+    TEST_ASSERT_NOT_NULL(reader);
+
+    for (uint64_t i = 0; i < targets[t]; ++i) {
+      rc = csvreader_next_record_view(reader, &fields, &length);
+      TEST_ASSERT_TRUE(csv_success(rc));
+    }
+
+    /* the checkpoint survives the process through a file */
+    rc = csvreader_checkpoint(reader, &checkpoint);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    csvreader_close(&reader);
+
+    fileobj = fopen(savepath, "wb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    TEST_ASSERT_EQUAL_UINT(
+        1U, fwrite(&checkpoint, sizeof checkpoint, 1, fileobj));
+    fclose(fileobj);
+
+    fileobj = fopen(savepath, "rb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    TEST_ASSERT_EQUAL_UINT(1U, fread(&saved, sizeof saved, 1, fileobj));
+    fclose(fileobj);
+
+    /* the stdio and memory mapped readers carry on from the checkpoint */
+    for (size_t r = 0; r < 2; ++r) {
+      if (r == 0) {
+        reader = csvreader_resume(NULL, filepath, &saved);
+      } else {
+        reader = csvreader_mmap_init(NULL, filepath);
+        TEST_ASSERT_NOT_NULL(reader);
+        TEST_ASSERT_TRUE(csv_success(csvreader_restore(reader, &saved)));
+      }
+
+      expected = csvreader_mmap_init(NULL, filepath);
+      TEST_ASSERT_NOT_NULL(expected);
+      for (uint64_t i = 0; i < targets[t]; ++i) {
+        rc = csvreader_next_record_view(expected, &fields, &length);
+        TEST_ASSERT_TRUE(csv_success(rc));
+      }
+
+      compare_readers(reader, expected, &count);
+      TEST_ASSERT_EQUAL_UINT(4001 - targets[t], count);
+
+      csvreader_close(&reader);
+      csvreader_close(&expected);
+    }
+  }
+
+  /* a state which is not between records is refused */
+  saved.state = 3;
+  reader      = csvreader_resume(NULL, filepath, &saved);
+  TEST_ASSERT_NULL(reader);
+
+  /* a reader which cannot seek cannot be resumed */
+  fileobj = fopen(filepath, "rb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  reader = csvreader_fd_init(NULL, fileno(fileobj));
+  TEST_ASSERT_NOT_NULL(reader);
+  TEST_ASSERT_FALSE(csv_success(csvreader_checkpoint(reader, &checkpoint)));
+  csvreader_close(&reader);
+  fclose(fileobj);
+
+  remove(savepath);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderCheckpoint` completed");
+}
+
+void test_CSVReaderReadAhead(void) {
+  ZF_LOGI("`test_CSVReaderReadAhead` called");
+  const char *filepath  = "data/test_reader_readahead.csv";
+  const char *indexpath = "data/test_reader_readahead.csv.idx";
+  FILE *      fileobj   = fopen(filepath, "wb");
+  csvreader   reader    = NULL;
+  csvreader   expected  = NULL;
+  char **     record    = NULL;
+  size_t      length    = 0;
+  size_t      count     = 0;
+  csvreturn   rc;
+
+  /* many blocks, with quoted line terminators straddling them */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 100000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"quoted\r\nfield\",%s\n",
+            (unsigned long)i,
+            (i % 5 == 0) ? "" : "plain text");
+  }
+  fclose(fileobj);
+
+  reader = csvreader_init(NULL, filepath);
+  TEST_ASSERT_TRUE(csv_success(csvreader_set_readahead(reader, 2)));
+  TEST_ASSERT_FALSE(csv_success(csvreader_set_readahead(reader, 2)));
+  expected = csvreader_mmap_init(NULL, filepath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(100000U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+
+  fileobj = fopen(filepath, "rb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  reader = csvreader_file_init(NULL, fileobj);
+  TEST_ASSERT_TRUE(csv_success(csvreader_set_readahead(reader, 4)));
+  expected = csvreader_mmap_init(NULL, filepath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(100000U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+  fclose(fileobj);
+
+  /* seeking restarts the thread at the indexed record */
+  rc = csvreader_build_index(NULL, filepath, indexpath, 1000);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  reader = csvreader_init(NULL, filepath);
+  TEST_ASSERT_TRUE(csv_success(csvreader_set_readahead(reader, 3)));
+  TEST_ASSERT_TRUE(csv_success(csvreader_load_index(reader, indexpath)));
+
+  for (size_t r = 99999; r > 0; r = r * 3 / 4) {
+    TEST_ASSERT_TRUE(csv_success(csvreader_seek_record(reader, r)));
+    rc = csvreader_next_record(reader, &record, &length);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_EQUAL_UINT(r, strtoul(record[0], NULL, 10));
+    free_record(record, length);
+  }
+
+  /* the partly parsed block was read before the thread started */
+  TEST_ASSERT_FALSE(csv_success(csvreader_set_readahead(reader, 3)));
+  csvreader_close(&reader);
+
+  reader = csvreader_init(NULL, filepath);
+  rc     = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  free_record(record, length);
+  TEST_ASSERT_FALSE(csv_success(csvreader_set_readahead(reader, 2)));
+  csvreader_close(&reader);
+
+  /* only readers over a file read ahead */
+  reader = csvreader_mmap_init(NULL, filepath);
+  TEST_ASSERT_FALSE(csv_success(csvreader_set_readahead(reader, 2)));
+  csvreader_close(&reader);
+  reader = csvreader_init(NULL, filepath);
+  TEST_ASSERT_FALSE(csv_success(csvreader_set_readahead(reader, 1)));
+  csvreader_close(&reader);
+
+  remove(indexpath);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderReadAhead` completed");
+}
+
+void test_CSVReaderReset(void) {
+  ZF_LOGI("`test_CSVReaderReset` called");
+  const char *paths[]  = {"data/test_reader_reset_0.csv",
+                         "data/test_reader_reset_1.csv",
+                         "data/test_reader_reset_2.csv"};
+  FILE *      fileobj  = NULL;
+  csvreader   reader   = NULL;
+  csvreader   expected = NULL;
+  char **     record   = NULL;
+  size_t      length   = 0;
+  size_t      count    = 0;
+  csvreturn   rc;
+
+  for (size_t f = 0; f < 3; ++f) {
+    fileobj = fopen(paths[f], "wb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    for (size_t i = 0; i < 100 * f + 3; ++i) {
+      fprintf(fileobj,
+              "%lu,\"file %lu\r\nrecord\",%s\r\n",
+              (unsigned long)i,
+              (unsigned long)f,
+              (i % 2 == 0) ? "a much longer field to grow the buffers" : "");
+    }
+    fclose(fileobj);
+  }
+
+  /* a partly read file is left behind */
+  reader = csvreader_init(NULL, paths[0]);
+  TEST_ASSERT_NOT_NULL(reader);
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  free_record(record, length);
+
+  for (size_t pass = 0; pass < 2; ++pass) {
+    TEST_ASSERT_TRUE(csv_success(csvreader_reset_path(reader, paths[1])));
+    expected = csvreader_mmap_init(NULL, paths[1]);
+    compare_readers(reader, expected, &count);
+    TEST_ASSERT_EQUAL_UINT(103U, count);
+    csvreader_close(&expected);
+
+    /* the stream belongs to the caller */
+    fileobj = fopen(paths[2], "rb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    TEST_ASSERT_TRUE(csv_success(csvreader_reset(reader, fileobj)));
+    expected = csvreader_mmap_init(NULL, paths[2]);
+    compare_readers(reader, expected, &count);
+    TEST_ASSERT_EQUAL_UINT(203U, count);
+    csvreader_close(&expected);
+
+    /* a file which cannot be opened leaves the reader as it was */
+    rc = csvreader_reset_path(reader, "data/missing.csv");
+    TEST_ASSERT_FALSE(csv_success(rc));
+    TEST_ASSERT_TRUE(rc.io_error);
+
+    TEST_ASSERT_TRUE(csv_success(csvreader_reset_path(reader, paths[0])));
+    fclose(fileobj);
+    expected = csvreader_mmap_init(NULL, paths[0]);
+    compare_readers(reader, expected, &count);
+    TEST_ASSERT_EQUAL_UINT(3U, count);
+    csvreader_close(&expected);
+
+    /* a reset keeps reading ahead */
+    rc = csvreader_set_readahead(reader, 2);
+    TEST_ASSERT_EQUAL(pass == 0, csv_success(rc));
+  }
+  csvreader_close(&reader);
+
+  reader = csvreader_mmap_init(NULL, paths[0]);
+  TEST_ASSERT_NOT_NULL(reader);
+  TEST_ASSERT_FALSE(csv_success(csvreader_reset_path(reader, paths[1])));
+  csvreader_close(&reader);
+
+  for (size_t f = 0; f < 3; ++f) remove(paths[f]);
+  ZF_LOGI("`test_CSVReaderReset` completed");
+}
+
+/* counts live allocations, each tagged with the arena which made it */
+typedef struct test_arena {
+  size_t live;
+  size_t total;
+  size_t foreign; /* pointers from another allocator */
+  size_t threads; /* calls from threads other than the test's */
+} test_arena;
+
+/* set on the thread running the tests, the arenas are not thread safe */
+static _Thread_local bool test_arena_owner = false;
+
+typedef union test_arena_header {
+  test_arena *arena;
+  max_align_t align;
+} test_arena_header;
+
+static void *test_arena_malloc(void *context, size_t size) {
+  test_arena_header *header = NULL;
+
+  if (!test_arena_owner) ((test_arena *)context)->threads++;
+  if ((header = malloc(sizeof *header + size)) == NULL) return NULL;
+  header->arena = (test_arena *)context;
+  header->arena->live++;
+  header->arena->total++;
+  return header + 1;
+}
+
+static void *test_arena_realloc(void *context, void *pointer, size_t size) {
+  test_arena_header *header = NULL;
+
+  if (pointer == NULL) return test_arena_malloc(context, size);
+  if (!test_arena_owner) ((test_arena *)context)->threads++;
+
+  header = (test_arena_header *)pointer - 1;
+  if (header->arena != context) ((test_arena *)context)->foreign++;
+  if ((header = realloc(header, sizeof *header + size)) == NULL) return NULL;
+  return header + 1;
+}
+
+static void test_arena_free(void *context, void *pointer) {
+  test_arena_header *header = NULL;
+
+  if (pointer == NULL) return;
+  if (!test_arena_owner) ((test_arena *)context)->threads++;
+
+  header = (test_arena_header *)pointer - 1;
+  if (header->arena != context) ((test_arena *)context)->foreign++;
+  header->arena->live--;
+  free(header);
+}
+
+/* reads every record of `reader`, releasing them into `arena` */
+static void test_arena_read(csvreader   reader,
+                            test_arena *arena,
+                            size_t      expected) {
+  char **   record = NULL;
+  size_t    length = 0;
+  size_t    count  = 0;
+  csvreturn rc;
+
+  TEST_ASSERT_NOT_NULL(reader);
+  while (true) {
+    rc = csvreader_next_record(reader, &record, &length);
+    if (csv_failure(rc)) break;
+
+    for (size_t i = 0; i < length; ++i) test_arena_free(arena, record[i]);
+    test_arena_free(arena, record);
+    count++;
+  }
+  TEST_ASSERT_TRUE(rc.io_eof);
+  TEST_ASSERT_EQUAL_UINT(expected, count);
+}
+
+void test_CSVReaderAllocator(void) {
+  ZF_LOGI("`test_CSVReaderAllocator` called");
+  const char *path     = "data/test_reader_allocator.csv";
+  const char *output   = "data/test_reader_allocator_output.csv";
+  const char *fields[] = {"1", "two, quoted", "three"};
+  const char *paths[]  = {path, path, path};
+  test_arena  library  = {0, 0, 0, 0};
+  test_arena  arena    = {0, 0, 0, 0};
+  FILE *      fileobj  = NULL;
+  csvdialect  dialect  = NULL;
+  csvreader   reader   = NULL;
+  csvwriter   writer   = NULL;
+  csvreturn   rc;
+
+  /* long fields and records grow the stdio reader's buffers */
+  fileobj = fopen(path, "wb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 50; ++i) {
+    fprintf(fileobj, "%lu,", (unsigned long)i);
+    for (size_t j = 0; j < 20 * i; ++j) fputc('a' + (int)(j % 26), fileobj);
+    for (size_t j = 0; j < i; ++j) fputs(",\"x\r\ny\"", fileobj);
+    fputs("\r\n", fileobj);
+  }
+  fclose(fileobj);
+
+  test_arena_owner = true;
+
+  rc = csv_set_allocator(&test_arena_malloc, NULL, NULL, NULL);
+  TEST_ASSERT_FALSE(csv_success(rc));
+
+  /* the library allocator */
+  rc = csv_set_allocator(
+      &test_arena_malloc, &test_arena_realloc, &test_arena_free, &library);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  dialect = csvdialect_init();
+  TEST_ASSERT_NOT_NULL(dialect);
+  reader = csvreader_init(dialect, path);
+  test_arena_read(reader, &library, 50);
+  csvreader_close(&reader);
+
+  writer = csvwriter_init(dialect, output);
+  TEST_ASSERT_NOT_NULL(writer);
+  TEST_ASSERT_TRUE(csv_success(csvwriter_next_record(writer, fields, 3)));
+  csvwriter_close(&writer);
+  csvdialect_close(&dialect);
+
+  TEST_ASSERT_TRUE(library.total > 0);
+  TEST_ASSERT_EQUAL_UINT(0U, library.live);
+  TEST_ASSERT_EQUAL_UINT(0U, library.foreign);
+  TEST_ASSERT_EQUAL_UINT(0U, library.threads);
+
+  TEST_ASSERT_TRUE(csv_success(csv_set_allocator(NULL, NULL, NULL, NULL)));
+
+  /* the allocator of the readers and writers made with a dialect */
+  dialect = csvdialect_init();
+  TEST_ASSERT_NOT_NULL(dialect);
+  rc = csvdialect_set_allocator(dialect,
+                                &test_arena_malloc,
+                                &test_arena_realloc,
+                                &test_arena_free,
+                                &arena);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+  reader = csvreader_init(dialect, path);
+  TEST_ASSERT_TRUE(arena.live > 0);
+  test_arena_read(reader, &arena, 50);
+  csvreader_close(&reader);
+
+  fileobj = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  reader = csvreader_file_init(dialect, fileobj);
+  test_arena_read(reader, &arena, 50);
+  csvreader_close(&reader);
+  fclose(fileobj);
+
+  reader = csvreader_mmap_init(dialect, path);
+  test_arena_read(reader, &arena, 50);
+  csvreader_close(&reader);
+
+  /* the workers of threaded readers keep to the library allocator */
+  reader = csvreader_parallel_init(dialect, path, 4);
+  test_arena_read(reader, &arena, 50);
+  csvreader_close(&reader);
+
+  reader = csvreader_multi_init(dialect, paths, 3, 3, false);
+  test_arena_read(reader, &arena, 150);
+  csvreader_close(&reader);
+
+  writer = csvwriter_init(dialect, output);
+  TEST_ASSERT_NOT_NULL(writer);
+  TEST_ASSERT_TRUE(csv_success(csvwriter_next_record(writer, fields, 3)));
+  csvwriter_close(&writer);
+
+  TEST_ASSERT_TRUE(arena.total > 0);
+  TEST_ASSERT_EQUAL_UINT(0U, arena.live);
+  TEST_ASSERT_EQUAL_UINT(0U, arena.foreign);
+  TEST_ASSERT_EQUAL_UINT(0U, arena.threads);
+
+  /* the dialect itself was not allocated by the arena */
+  csvdialect_close(&dialect);
+  TEST_ASSERT_EQUAL_UINT(0U, arena.live);
+
+  remove(path);
+  remove(output);
+  ZF_LOGI("`test_CSVReaderAllocator` completed");
+}
+
+void test_CSVReaderUring(void) {
+  ZF_LOGI("`test_CSVReaderUring` called");
+  const char *filepath  = "data/test_reader_uring.csv";
+  const char *indexpath = "data/test_reader_uring.csv.idx";
+  FILE *      fileobj   = fopen(filepath, "wb");
+  csvreader   reader    = NULL;
+  csvreader   expected  = NULL;
+  char **     record    = NULL;
+  size_t      length    = 0;
+  size_t      count     = 0;
+  csvreturn   rc;
+
+  /* several reads worth, with quoted line terminators straddling them */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 150000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"quoted\r\nfield %lu\",%s\n",
+            (unsigned long)i,
+            (unsigned long)(i * 31),
+            (i % 3 == 0) ? "\"\"" : "plain text");
+  }
+  fclose(fileobj);
+
+  for (int direct = 0; direct < 2; ++direct) {
+    reader   = csvreader_uring_init(NULL, filepath, direct == 1);
+    expected = csvreader_mmap_init(NULL, filepath);
+    compare_readers(reader, expected, &count);
+    TEST_ASSERT_EQUAL_UINT(150000U, count);
+    csvreader_close(&reader);
+    csvreader_close(&expected);
+  }
+
+  /* seeking drains the reads in flight and restarts them */
+  rc = csvreader_build_index(NULL, filepath, indexpath, 500);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  reader = csvreader_uring_init(NULL, filepath, false);
+  TEST_ASSERT_NOT_NULL(reader);
+  TEST_ASSERT_TRUE(csv_success(csvreader_load_index(reader, indexpath)));
+
+  for (size_t r = 149999; r > 0; r = r * 2 / 3) {
+    TEST_ASSERT_TRUE(csv_success(csvreader_seek_record(reader, r)));
+    rc = csvreader_next_record(reader, &record, &length);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_EQUAL_UINT(r, strtoul(record[0], NULL, 10));
+    free_record(record, length);
+  }
+
+  TEST_ASSERT_TRUE(csv_success(csvreader_seek_offset(reader, 0)));
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_STRING("0", record[0]);
+  free_record(record, length);
+  csvreader_close(&reader);
+
+  /* missing file */
+  reader = csvreader_uring_init(NULL, "file-does-not-exist.csv", false);
+  TEST_ASSERT_NULL(reader);
+
+  remove(indexpath);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderUring` completed");
+}
+
+void test_CSVReaderDescriptor(void) {
+  ZF_LOGI("`test_CSVReaderDescriptor` called");
+  const char *filepath = "data/test_reader_descriptor.csv";
+  FILE *      fileobj  = fopen(filepath, "wb");
+  csvreader   reader   = NULL;
+  csvreader   expected = NULL;
+  size_t      count    = 0;
+#ifndef _WIN32
+  int         fds[2]   = {-1, -1};
+  char **     record   = NULL;
+  size_t      length   = 0;
+  csvreturn   rc;
+#endif
+
+  /* quoted line terminators straddle the blocks read */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 100000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"quoted\nfield\",%s\r\n",
+            (unsigned long)i,
+            (i % 9 == 0) ? "" : "plain text");
+  }
+  fclose(fileobj);
+
+  fileobj = fopen(filepath, "rb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  reader   = csvreader_fd_init(NULL, fileno(fileobj));
+  expected = csvreader_mmap_init(NULL, filepath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(100000U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+  fclose(fileobj);
+
+#ifndef _WIN32
+  /* a pipe returns the data in chunks of at most its capacity */
+  fileobj = popen("cat data/test_reader_descriptor.csv", "r");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  reader   = csvreader_fd_init(NULL, fileno(fileobj));
+  expected = csvreader_mmap_init(NULL, filepath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(100000U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+  TEST_ASSERT_EQUAL_INT(0, pclose(fileobj));
+
+  /* closing returns while the writer still holds the pipe open */
+  TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+  TEST_ASSERT_EQUAL_INT(8, (int)write(fds[1], "a,b\nc,d\n", 8));
+  reader = csvreader_fd_init(NULL, fds[0]);
+  rc     = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(2U, length);
+  TEST_ASSERT_EQUAL_STRING("a", record[0]);
+  free_record(record, length);
+  csvreader_close(&reader);
+  close(fds[0]);
+  close(fds[1]);
+#endif
+
+  /* the reader cannot seek */
+  fileobj = fopen(filepath, "rb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  reader = csvreader_fd_init(NULL, fileno(fileobj));
+  TEST_ASSERT_FALSE(csv_success(csvreader_seek_offset(reader, 0)));
+  csvreader_close(&reader);
+  fclose(fileobj);
+
+  TEST_ASSERT_NULL(csvreader_fd_init(NULL, -1));
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderDescriptor` completed");
+}
+
+static void test_append_file(const char *filepath,
+                             const char *mode,
+                             const char *s) {
+  FILE *fileobj = fopen(filepath, mode);
+
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fputs(s, fileobj);
+  fclose(fileobj);
+}
+
+static void test_next_follow(csvreader   reader,
+                             const char *first,
+                             const char *last) {
+  char **   record = NULL;
+  size_t    length = 0;
+  csvreturn rc     = csvreader_next_record(reader, &record, &length);
+
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_FALSE(rc.io_eof);
+  TEST_ASSERT_TRUE(length > 0);
+  TEST_ASSERT_EQUAL_STRING(first, record[0]);
+  TEST_ASSERT_EQUAL_STRING(last, record[length - 1]);
+  free_record(record, length);
+}
+
+void test_CSVReaderFollow(void) {
+  ZF_LOGI("`test_CSVReaderFollow` called");
+#ifdef _WIN32
+  TEST_IGNORE_MESSAGE("following a file is not supported");
+#else
+  const char *filepath = "data/test_reader_follow.csv";
+  const char *newpath  = "data/test_reader_follow.csv.new";
+  csvreader   reader   = NULL;
+  char **     record   = NULL;
+  size_t      length   = 0;
+  FILE *      writer   = NULL;
+  csvreturn   rc;
+
+  TEST_ASSERT_NULL(csvreader_follow_init(NULL, "data/missing.csv", 0));
+
+  test_append_file(filepath, "wb", "a,b\r\n1,\"par");
+  reader = csvreader_follow_init(NULL, filepath, 0);
+  TEST_ASSERT_NOT_NULL(reader);
+  test_next_follow(reader, "a", "b");
+
+  /* the partial record is kept until the rest of it is written */
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_FALSE(csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_again);
+  TEST_ASSERT_FALSE(rc.io_eof);
+
+  test_append_file(filepath, "ab", "tial\"\"x\",2\r\n3,4");
+  test_next_follow(reader, "1", "2");
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(rc.io_again);
+  test_append_file(filepath, "ab", "\r\n");
+  test_next_follow(reader, "3", "4");
+
+  /* a replaced file is read from its start */
+  test_append_file(newpath, "wb", "x,y\r\n");
+  TEST_ASSERT_EQUAL_INT(0, rename(newpath, filepath));
+  test_next_follow(reader, "x", "y");
+
+  /* as is a truncated one */
+  test_append_file(filepath, "wb", "t\r\n");
+  test_next_follow(reader, "t", "t");
+  csvreader_close(&reader);
+
+  /* the reader sleeps until the file grows */
+  reader = csvreader_follow_init(NULL, filepath, 10000);
+  TEST_ASSERT_NOT_NULL(reader);
+  test_next_follow(reader, "t", "t");
+
+  writer = popen("sleep 0.2 && printf 'late,record\\n' >> "
+                 "data/test_reader_follow.csv",
+                 "r");
+  TEST_ASSERT_NOT_NULL(writer);
+  test_next_follow(reader, "late", "record");
+  TEST_ASSERT_EQUAL_INT(0, pclose(writer));
+  csvreader_close(&reader);
+
+  /* and gives up after the timeout */
+  reader = csvreader_follow_init(NULL, filepath, 50);
+  TEST_ASSERT_NOT_NULL(reader);
+  test_next_follow(reader, "t", "t");
+  test_next_follow(reader, "late", "record");
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(rc.io_again);
+  TEST_ASSERT_FALSE(csv_success(csvreader_seek_offset(reader, 0)));
+  csvreader_close(&reader);
+
+  remove(filepath);
+#endif
+  ZF_LOGI("`test_CSVReaderFollow` completed");
+}
+
+/*
+ * Push parser callbacks, the records are serialized into a growing string
+ */
+typedef struct test_parser_output {
+  char * text;
+  size_t length;
+  size_t capacity;
+  size_t fields;
+  size_t records;
+} test_parser_output;
+
+static void test_output_append(test_parser_output *out,
+                               const char *        data,
+                               size_t              n) {
+  while (out->length + n + 1 > out->capacity) {
+    out->capacity = (out->capacity > 0) ? out->capacity * 2 : 256;
+    out->text     = realloc(out->text, out->capacity);
+    TEST_ASSERT_NOT_NULL(out->text);
+  }
+  memcpy(out->text + out->length, data, n);
+  out->length += n;
+  out->text[out->length] = '\0';
+}
+
+static void test_parser_field(void *          context,
+                              const csvfield *field,
+                              size_t          column) {
+  test_parser_output *out = (test_parser_output *)context;
+
+  if (column > 0) test_output_append(out, "|", 1);
+  test_output_append(out, field->data, field->len);
+  out->fields++;
+}
+
+static void test_parser_record(void *          context,
+                               const csvfield *fields,
+                               size_t          length) {
+  test_parser_output *out = (test_parser_output *)context;
+
+  (void)fields;
+  TEST_ASSERT_TRUE(length > 0);
+  test_output_append(out, "\n", 1);
+  out->records++;
+}
+
+void test_CSVParserFeed(void) {
+  ZF_LOGI("`test_CSVParserFeed` called");
+  static const char text[] =
+      "a,b,c\r\n"
+      "\"quoted, field\",\"with \"\"doubled\"\" quotes\",\"line\r\nbreak\"\r\n"
+      "\r\n"
+      "1,,3\n"
+      "\"\",x,\"last\"";
+  const char *       filepath = "data/test_parser_feed.csv";
+  FILE *             fileobj  = fopen(filepath, "wb");
+  csvreader          reader   = NULL;
+  csvparser          parser   = NULL;
+  const csvfield *   fields   = NULL;
+  size_t             length   = 0;
+  test_parser_output expected = {NULL, 0, 0, 0, 0};
+  test_parser_output actual   = {NULL, 0, 0, 0, 0};
+  csvreturn          rc;
+
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fwrite(text, 1, sizeof text - 1, fileobj);
+  fclose(fileobj);
+
+  /* the pull reader gives the expected records */
+  reader = csvreader_init(NULL, filepath);
+  TEST_ASSERT_NOT_NULL(reader);
+  while (true) {
+    rc = csvreader_next_record_view(reader, &fields, &length);
+    if (csv_failure(rc)) break;
+    for (size_t i = 0; i < length; ++i) {
+      test_parser_field(&expected, &fields[i], i);
+    }
+    test_parser_record(&expected, fields, length);
+    if (rc.io_eof) break;
+  }
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_UINT(4U, expected.records);
+  csvreader_close(&reader);
+
+  /* every chunk size, so every boundary falls in every parser state */
+  for (size_t chunk = 1; chunk <= sizeof text; ++chunk) {
+    actual.length  = 0;
+    actual.fields  = 0;
+    actual.records = 0;
+
+    parser = csvparser_init(
+        NULL, &test_parser_field, &test_parser_record, &actual);
+    TEST_ASSERT_NOT_NULL(parser);
+
+    for (size_t pos = 0; pos < sizeof text - 1; pos += chunk) {
+      size_t n = (chunk < sizeof text - 1 - pos) ? chunk
+                                                 : sizeof text - 1 - pos;
+      TEST_ASSERT_TRUE(csv_success(csvparser_feed(parser, text + pos, n)));
+    }
+
+    /* the final record has no line terminator, it waits for the end */
+    TEST_ASSERT_EQUAL_UINT(3U, actual.records);
+    TEST_ASSERT_TRUE(csv_success(csvparser_finish(parser)));
+    TEST_ASSERT_EQUAL_UINT(expected.records, actual.records);
+    TEST_ASSERT_EQUAL_UINT(expected.fields, actual.fields);
+    TEST_ASSERT_EQUAL_STRING(expected.text, actual.text);
+
+    TEST_ASSERT_FALSE(csv_success(csvparser_feed(parser, "x\n", 2)));
+    TEST_ASSERT_FALSE(csv_success(csvparser_finish(parser)));
+    csvparser_close(&parser);
+    TEST_ASSERT_NULL(parser);
+  }
+
+  /* an empty feed and a finish with nothing pending are fine */
+  parser = csvparser_init(NULL, NULL, NULL, NULL);
+  TEST_ASSERT_NOT_NULL(parser);
+  TEST_ASSERT_TRUE(csv_success(csvparser_feed(parser, NULL, 0)));
+  TEST_ASSERT_TRUE(csv_success(csvparser_feed(parser, "a,b\n", 4)));
+  TEST_ASSERT_TRUE(csv_success(csvparser_finish(parser)));
+  csvparser_close(&parser);
+
+  free(expected.text);
+  free(actual.text);
+  remove(filepath);
+  ZF_LOGI("`test_CSVParserFeed` completed");
+}
+
+void test_CSVReaderCompressed(void) {
+  ZF_LOGI("`test_CSVReaderCompressed` called");
+  const char *    filepath = "data/test_reader_compressed.csv";
+  const char *    gzippath = "data/test_reader_compressed.csv.gz";
+  const char *    zstdpath = "data/test_reader_compressed.csv.zst";
+  FILE *          fileobj  = fopen(filepath, "wb");
+  char *          text     = NULL;
+  long            length   = 0;
+  size_t          half     = 0;
+  size_t          count    = 0;
+  csvreader       reader   = NULL;
+  csvreader       expected = NULL;
+  const csvfield *fields   = NULL;
+  csvreturn       rc;
+
+  /* fields with quoted line terminators straddle the inflated blocks */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 50000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"quoted\r\nfield %lu\",%s,\"\"\"x\"\"\"\r\n",
+            (unsigned long)i,
+            (unsigned long)(i * 7919),
+            (i % 11 == 0) ? "" : "plain");
+  }
+  fclose(fileobj);
+
+  fileobj = fopen(filepath, "rb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fseek(fileobj, 0, SEEK_END);
+  length = ftell(fileobj);
+  rewind(fileobj);
+  text = malloc((size_t)length);
+  TEST_ASSERT_NOT_NULL(text);
+  TEST_ASSERT_EQUAL_UINT((size_t)length, fread(text, 1, length, fileobj));
+  fclose(fileobj);
+
+  /* written as two members or frames, split in the middle of a record */
+  half = (size_t)length / 2;
+
+#ifdef CSV_HAVE_ZLIB
+  {
+    gzFile gz = gzopen(gzippath, "wb");
+    TEST_ASSERT_NOT_NULL(gz);
+    TEST_ASSERT_EQUAL_INT((int)half, gzwrite(gz, text, (unsigned)half));
+    gzclose(gz);
+
+    gz = gzopen(gzippath, "ab");
+    TEST_ASSERT_NOT_NULL(gz);
+    TEST_ASSERT_EQUAL_INT((int)(length - half),
+                          gzwrite(gz, text + half, (unsigned)(length - half)));
+    gzclose(gz);
+  }
+
+  reader   = csvreader_gzip_init(NULL, gzippath);
+  expected = csvreader_init(NULL, filepath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(50000U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+
+  /* a truncated member is an error, not the end of the input */
+  {
+    char * packed = malloc((size_t)length);
+    size_t size   = 0;
+
+    TEST_ASSERT_NOT_NULL(packed);
+    fileobj = fopen(gzippath, "rb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    size = fread(packed, 1, (size_t)length, fileobj);
+    fclose(fileobj);
+
+    fileobj = fopen(gzippath, "wb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    fwrite(packed, 1, size - 8, fileobj);
+    fclose(fileobj);
+    free(packed);
+  }
+
+  reader = csvreader_gzip_init(NULL, gzippath);
+  TEST_ASSERT_NOT_NULL(reader);
+  do {
+    rc = csvreader_next_record_view(reader, &fields, &count);
+  } while (csv_success(rc));
+  TEST_ASSERT_TRUE(rc.io_error);
+  csvreader_close(&reader);
+
+  /* padding after the last member is ignored, as by `gzip -d` */
+  {
+    static const char padding[512] = {0};
+    gzFile            gz           = gzopen(gzippath, "wb");
+
+    TEST_ASSERT_NOT_NULL(gz);
+    TEST_ASSERT_EQUAL_INT((int)length, gzwrite(gz, text, (unsigned)length));
+    gzclose(gz);
+
+    fileobj = fopen(gzippath, "ab");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    fwrite(padding, 1, sizeof padding, fileobj);
+    fclose(fileobj);
+  }
+
+  reader   = csvreader_gzip_init(NULL, gzippath);
+  expected = csvreader_init(NULL, filepath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(50000U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+  remove(gzippath);
+#else
+  TEST_ASSERT_NULL(csvreader_gzip_init(NULL, gzippath));
+#endif
+
+#ifdef CSV_HAVE_ZSTD
+  {
+    size_t bound  = ZSTD_compressBound(half) + ZSTD_compressBound(length);
+    char * frames = malloc(bound);
+    size_t first  = 0;
+    size_t second = 0;
+
+    TEST_ASSERT_NOT_NULL(frames);
+    first = ZSTD_compress(frames, bound, text, half, 3);
+    TEST_ASSERT_FALSE(ZSTD_isError(first));
+    second = ZSTD_compress(
+        frames + first, bound - first, text + half, length - half, 3);
+    TEST_ASSERT_FALSE(ZSTD_isError(second));
+
+    fileobj = fopen(zstdpath, "wb");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    fwrite(frames, 1, first + second, fileobj);
+    fclose(fileobj);
+    free(frames);
+  }
+
+  reader   = csvreader_zstd_init(NULL, zstdpath);
+  expected = csvreader_init(NULL, filepath);
+  compare_readers(reader, expected, &count);
+  TEST_ASSERT_EQUAL_UINT(50000U, count);
+  csvreader_close(&reader);
+  csvreader_close(&expected);
+  remove(zstdpath);
+#else
+  TEST_ASSERT_NULL(csvreader_zstd_init(NULL, zstdpath));
+#endif
+
+  free(text);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderCompressed` completed");
+}
+
+#if defined(CSV_HAVE_ZLIB) || defined(CSV_HAVE_ZSTD)
+/*
+ * Little endian integers of the block compressed formats
+ */
+static void put_le(unsigned char *out, uint32_t value, size_t width) {
+  for (size_t i = 0; i < width; ++i) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+#ifdef CSV_HAVE_ZLIB
+/*
+ * Write `text` as BGZF members of `chunk` characters, as `bgzip` does
+ */
+static void write_bgzf(const char *path,
+                       const char *text,
+                       size_t      length,
+                       size_t      chunk) {
+  static const unsigned char eof[28] = {
+      0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C',
+      2,    0,    0x1b, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  static const unsigned char header[16] = {
+      0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0};
+  unsigned char *member  = malloc(1 << 17);
+  FILE *         fileobj = fopen(path, "wb");
+  size_t         size    = 0;
+
+  TEST_ASSERT_NOT_NULL(member);
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t pos = 0; pos < length; pos += chunk) {
+    z_stream stream = {0};
+
+    if (chunk > length - pos) chunk = length - pos;
+
+    TEST_ASSERT_EQUAL_INT(
+        Z_OK,
+        deflateInit2(&stream, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY));
+    stream.next_in   = (Bytef *)(text + pos);
+    stream.avail_in  = (uInt)chunk;
+    stream.next_out  = member + 18;
+    stream.avail_out = (1 << 17) - 26;
+    TEST_ASSERT_EQUAL_INT(Z_STREAM_END, deflate(&stream, Z_FINISH));
+    size = stream.total_out;
+    deflateEnd(&stream);
+
+    memcpy(member, header, sizeof header);
+    put_le(member + 16, (uint32_t)(18 + size + 8 - 1), 2);
+    put_le(member + 18 + size,
+           (uint32_t)crc32(0L, (const Bytef *)text + pos, (uInt)chunk),
+           4);
+    put_le(member + 18 + size + 4, (uint32_t)chunk, 4);
+    fwrite(member, 1, 18 + size + 8, fileobj);
+  }
+  fwrite(eof, 1, sizeof eof, fileobj);
+  fclose(fileobj);
+  free(member);
+}
+#endif
+
+#ifdef CSV_HAVE_ZSTD
+/*
+ * Write `text` as Zstandard frames of `chunk` characters, followed by the seek
+ * table of the seekable format
+ */
+static void write_zstd_seekable(const char *path,
+                                const char *text,
+                                size_t      length,
+                                size_t      chunk) {
+  size_t         frames  = (length + chunk - 1) / chunk;
+  size_t         bound   = ZSTD_compressBound(chunk);
+  char *         frame   = malloc(bound);
+  unsigned char *table   = malloc(8 + frames * 8 + 9);
+  FILE *         fileobj = fopen(path, "wb");
+  size_t         size    = 0;
+
+  TEST_ASSERT_NOT_NULL(frame);
+  TEST_ASSERT_NOT_NULL(table);
+  TEST_ASSERT_NOT_NULL(fileobj);
+  put_le(table, 0x184D2A5EU, 4);
+  put_le(table + 4, (uint32_t)(frames * 8 + 9), 4);
+
+  for (size_t f = 0; f < frames; ++f) {
+    size_t pos = f * chunk;
+
+    if (chunk > length - pos) chunk = length - pos;
+
+    size = ZSTD_compress(frame, bound, text + pos, chunk, 3);
+    TEST_ASSERT_FALSE(ZSTD_isError(size));
+    fwrite(frame, 1, size, fileobj);
+    put_le(table + 8 + f * 8, (uint32_t)size, 4);
+    put_le(table + 12 + f * 8, (uint32_t)chunk, 4);
+  }
+
+  put_le(table + 8 + frames * 8, (uint32_t)frames, 4);
+  table[8 + frames * 8 + 4] = 0;
+  put_le(table + 8 + frames * 8 + 5, 0x8F92EAB1U, 4);
+  fwrite(table, 1, 8 + frames * 8 + 9, fileobj);
+  fclose(fileobj);
+  free(table);
+  free(frame);
+}
+#endif
+
+/*
+ * Read a block compressed file with several worker counts, then seek in it
+ */
+static void check_blocked_reader(
+    csvreader (*init)(csvdialect, const char *, size_t),
+    const char *filepath,
+    const char *indexpath,
+    const char *blockedpath,
+    size_t      total) {
+  static const size_t threads[3] = {1, 2, 4};
+  csvreader           reader     = NULL;
+  csvreader           expected   = NULL;
+  char **             record     = NULL;
+  size_t              length     = 0;
+  size_t              count      = 0;
+  csvreturn           rc;
+
+  for (size_t t = 0; t < 3; ++t) {
+    reader   = (*init)(NULL, blockedpath, threads[t]);
+    expected = csvreader_init(NULL, filepath);
+    compare_readers(reader, expected, &count);
+    TEST_ASSERT_EQUAL_UINT(total, count);
+    csvreader_close(&reader);
+    csvreader_close(&expected);
+  }
+
+  /* an index of the uncompressed file seeks in the compressed one */
+  reader = (*init)(NULL, blockedpath, 3);
+  TEST_ASSERT_NOT_NULL(reader);
+  TEST_ASSERT_TRUE(csv_success(csvreader_load_index(reader, indexpath)));
+
+  for (size_t r = total - 1; r > 0; r = r * 5 / 7) {
+    rc = csvreader_seek_record(reader, r);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    rc = csvreader_next_record(reader, &record, &length);
+    TEST_ASSERT_TRUE(csv_success(rc));
+    TEST_ASSERT_EQUAL_UINT(r, strtoul(record[0], NULL, 10));
+    free_record(record, length);
+  }
+
+  /* back to the start, then past the end */
+  TEST_ASSERT_TRUE(csv_success(csvreader_seek_offset(reader, 0)));
+  rc = csvreader_next_record(reader, &record, &length);
+  TEST_ASSERT_TRUE(csv_success(rc));
+  TEST_ASSERT_EQUAL_STRING("0", record[0]);
+  free_record(record, length);
+
+  rc = csvreader_seek_record(reader, total);
+  TEST_ASSERT_TRUE(rc.io_eof);
+  rc = csvreader_seek_offset(reader, (uint64_t)-1);
+  TEST_ASSERT_TRUE(rc.io_error);
+  csvreader_close(&reader);
+}
+#endif /* CSV_HAVE_ZLIB || CSV_HAVE_ZSTD */
+
+void test_CSVReaderBlocked(void) {
+  ZF_LOGI("`test_CSVReaderBlocked` called");
+  const char *filepath  = "data/test_reader_blocked.csv";
+  const char *indexpath = "data/test_reader_blocked.csv.idx";
+  const char *bgzfpath  = "data/test_reader_blocked.csv.bgz";
+  const char *zstdpath  = "data/test_reader_blocked.csv.zst";
+  FILE *      fileobj   = fopen(filepath, "wb");
+  char *      text      = NULL;
+  long        length    = 0;
+  csvreturn   rc;
+
+  /* quoted line terminators straddle the compressed blocks */
+  TEST_ASSERT_NOT_NULL(fileobj);
+  for (size_t i = 0; i < 40000; ++i) {
+    fprintf(fileobj,
+            "%lu,\"quoted\nfield %lu\",%s\r\n",
+            (unsigned long)i,
+            (unsigned long)(i * 7919),
+            (i % 13 == 0) ? "\"\"" : "plain");
+  }
+  fclose(fileobj);
+
+  fileobj = fopen(filepath, "rb");
+  TEST_ASSERT_NOT_NULL(fileobj);
+  fseek(fileobj, 0, SEEK_END);
+  length = ftell(fileobj);
+  rewind(fileobj);
+  text = malloc((size_t)length);
+  TEST_ASSERT_NOT_NULL(text);
+  TEST_ASSERT_EQUAL_UINT((size_t)length, fread(text, 1, length, fileobj));
+  fclose(fileobj);
+
+  rc = csvreader_build_index(NULL, filepath, indexpath, 100);
+  TEST_ASSERT_TRUE(csv_success(rc));
+
+#ifdef CSV_HAVE_ZLIB
+  write_bgzf(bgzfpath, text, (size_t)length, 60001);
+  check_blocked_reader(
+      &csvreader_bgzf_init, filepath, indexpath, bgzfpath, 40000);
+
+  /* a member failing its CRC check is an error */
+  {
+    csvreader       reader = NULL;
+    const csvfield *fields = NULL;
+    size_t          count  = 0;
+    unsigned char   member[18];
+
+    fileobj = fopen(bgzfpath, "r+b");
+    TEST_ASSERT_NOT_NULL(fileobj);
+    TEST_ASSERT_EQUAL_UINT(18U, fread(member, 1, 18, fileobj));
+    fseek(fileobj, (long)(member[16] | (member[17] << 8)) + 1 - 8, SEEK_SET);
+    fputc(0x5a, fileobj);
+    fclose(fileobj);
+
+    reader = csvreader_bgzf_init(NULL, bgzfpath, 2);
+    TEST_ASSERT_NOT_NULL(reader);
+    rc = csvreader_next_record_view(reader, &fields, &count);
+    TEST_ASSERT_TRUE(rc.io_error);
+    csvreader_close(&reader);
+  }
+
+  /* plain gzip has no block sizes */
+  {
+    gzFile gz = gzopen(bgzfpath, "wb");
+    TEST_ASSERT_NOT_NULL(gz);
+    gzwrite(gz, text, (unsigned)length);
+    gzclose(gz);
+  }
+  TEST_ASSERT_NULL(csvreader_bgzf_init(NULL, bgzfpath, 2));
+  remove(bgzfpath);
+#else
+  TEST_ASSERT_NULL(csvreader_bgzf_init(NULL, bgzfpath, 2));
+#endif
+
+#ifdef CSV_HAVE_ZSTD
+  write_zstd_seekable(zstdpath, text, (size_t)length, 100003);
+  check_blocked_reader(
+      &csvreader_zstd_seekable_init, filepath, indexpath, zstdpath, 40000);
+
+  /* a file without a seek table is rejected */
+  TEST_ASSERT_NULL(csvreader_zstd_seekable_init(NULL, filepath, 2));
+  remove(zstdpath);
+#else
+  TEST_ASSERT_NULL(csvreader_zstd_seekable_init(NULL, zstdpath, 2));
+#endif
+
+  free(text);
+  remove(indexpath);
+  remove(filepath);
+  ZF_LOGI("`test_CSVReaderBlocked` completed");
+}
+
 /*
  * Run the tests
  *
@@ -171,6 +2487,31 @@ int main(void) {
 
   RUN_TEST(test_CSVReaderInitDestroy);
   RUN_TEST(test_CSVReaderIrisDataset);
+  RUN_TEST(test_CSVReaderIrisDatasetView);
+  RUN_TEST(test_CSVReaderIrisDatasetBatch);
+  RUN_TEST(test_CSVReaderIrisDatasetColumns);
+  RUN_TEST(test_CSVReaderBlockStream);
+  RUN_TEST(test_CSVReaderDialectRules);
+  RUN_TEST(test_CSVReaderFileBlocks);
+  RUN_TEST(test_CSVReaderLongFields);
+  RUN_TEST(test_CSVReaderProjection);
+  RUN_TEST(test_CSVReaderFilter);
+  RUN_TEST(test_CSVReaderCountRecords);
+  RUN_TEST(test_CSVReaderSeekRecord);
+  RUN_TEST(test_CSVReaderUpdateIndex);
+  RUN_TEST(test_CSVReaderMmap);
+  RUN_TEST(test_CSVReaderParallel);
+  RUN_TEST(test_CSVReaderMultiFile);
+  RUN_TEST(test_CSVReaderCheckpoint);
+  RUN_TEST(test_CSVReaderReadAhead);
+  RUN_TEST(test_CSVReaderReset);
+  RUN_TEST(test_CSVReaderAllocator);
+  RUN_TEST(test_CSVReaderUring);
+  RUN_TEST(test_CSVReaderDescriptor);
+  RUN_TEST(test_CSVReaderFollow);
+  RUN_TEST(test_CSVParserFeed);
+  RUN_TEST(test_CSVReaderCompressed);
+  RUN_TEST(test_CSVReaderBlocked);
 
   output = UNITY_END();
   ZF_LOGI("Ending CSV Reader Test, result: %d", output);